@@ -0,0 +1,337 @@
+#include "adaptiverectifier.hpp"
+#include <algorithm>
+#include <map>
+
+const uint32_t AdaptiveRectifier::NONE;
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// the seed is the coarsest level, see can_refine()
+AdaptiveRectifier::AdaptiveRectifier(const Solid3d &seed, const unsigned _depth) : depth(_depth), updates(0) {
+    std::map<Vector3d, uint32_t> seed_vertices;
+    for (const Segment3d &s : seed.edges) {
+        auto a = seed_vertices.emplace(s.a, static_cast<uint32_t>(seed_vertices.size())).first;
+        if (a->second == vertices.size())
+            add_vertex(s.a, 0);
+        auto b = seed_vertices.emplace(s.b, static_cast<uint32_t>(seed_vertices.size())).first;
+        if (b->second == vertices.size())
+            add_vertex(s.b, 0);
+
+        add_edge(a->second, b->second);
+    }
+
+    for (const Face3d &face : seed.faces) {
+        uint32_t f = add_face(0, face.edges, face.normal);
+        for (uint32_t corner : faces[f].corners)
+            vertices[corner].degree++;
+        base_faces.push_back(f);
+    }
+
+    build_shape();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// the hierarchy needs the faces of a closed shape: every edge shared by two of them
+bool AdaptiveRectifier::can_refine(const Solid3d &seed) {
+    if (seed.faces.empty())
+        return false;
+
+    std::vector<unsigned> edge_faces(seed.edges.size(), 0);
+    for (const Face3d &face : seed.faces)
+        for (uint32_t e : face.edges)
+            if (e >= edge_faces.size() || ++edge_faces[e] > 2)
+                return false;
+
+    for (unsigned count : edge_faces)
+        if (count != 2)
+            return false;
+
+    return true;
+}
+
+uint32_t AdaptiveRectifier::add_vertex(const Vector3d &position, const uint32_t degree) {
+    uint32_t v = static_cast<uint32_t>(vertices.size());
+    if (free_vertices.empty())
+        vertices.emplace_back();
+    else {
+        v = free_vertices.back();
+        free_vertices.pop_back();
+    }
+
+    vertices[v].position = position;
+    vertices[v].degree   = degree;
+    vertices[v].refined  = 0;
+    vertices[v].face     = NONE;
+    vertices[v].cuts.clear();
+    return v;
+}
+
+uint32_t AdaptiveRectifier::add_edge(const uint32_t a, const uint32_t b) {
+    uint32_t e = static_cast<uint32_t>(edges.size());
+    if (free_edges.empty())
+        edges.emplace_back();
+    else {
+        e = free_edges.back();
+        free_edges.pop_back();
+    }
+
+    edges[e] = {a, b, {NONE, NONE}, 0, NONE};
+    return e;
+}
+
+// the face takes a free side of each of its edges, its corners, centroid and radius come from the edge order
+uint32_t AdaptiveRectifier::add_face(const unsigned level, const std::vector<uint32_t> &face_edges, const Vector3d &outward) {
+    uint32_t f = static_cast<uint32_t>(faces.size());
+    if (free_faces.empty())
+        faces.emplace_back();
+    else {
+        f = free_faces.back();
+        free_faces.pop_back();
+    }
+
+    Face &face = faces[f];
+    face.level    = level;
+    face.edges    = face_edges;
+    face.child    = NONE;
+    face.outward  = outward;
+    face.centroid = Vector3d();
+    face.radius   = 0.0;
+    face.mark     = 0;
+    face.cuts.clear();
+    face.corners.resize(face_edges.size());
+
+    for (size_t i = 0; i < face_edges.size(); ++i) {
+        const Edge &s = edges[face_edges[i]];
+        const Edge &t = edges[face_edges[(i + 1) % face_edges.size()]];
+        face.corners[i] = (s.a == t.a || s.a == t.b) ? s.a : s.b;
+        face.centroid += vertices[face.corners[i]].position;
+    }
+    face.centroid *= 1.0 / face_edges.size();
+
+    for (uint32_t corner : face.corners)
+        face.radius = std::max(face.radius, (vertices[corner].position - face.centroid).norm());
+
+    for (uint32_t e : face_edges)
+        edges[e].faces[edges[e].faces[0] == NONE ? 0 : 1] = f;
+
+    return f;
+}
+
+void AdaptiveRectifier::remove_vertex(const uint32_t v) {
+    vertices[v].cuts.clear();
+    free_vertices.push_back(v);
+}
+
+void AdaptiveRectifier::remove_edge(const uint32_t e) {
+    edges[e].a = NONE;
+    free_edges.push_back(e);
+}
+
+void AdaptiveRectifier::remove_face(const uint32_t f) {
+    for (uint32_t e : faces[f].edges)
+        edges[e].faces[edges[e].faces[0] == f ? 0 : 1] = NONE;
+
+    faces[f].edges.clear();
+    faces[f].corners.clear();
+    free_faces.push_back(f);
+}
+
+// rectification of face f alone: its edges get their midpoint, its corners are cut by the
+// edges of the next iteration forming its child, and a vertex whose faces are now all
+// rectified is replaced by the face of these cuts, as in getNextShape()
+void AdaptiveRectifier::refine(const uint32_t f) {
+    const std::vector<uint32_t> face_edges = faces[f].edges;
+    const std::vector<uint32_t> corners = faces[f].corners;
+    const unsigned level = faces[f].level;
+    const size_t n = face_edges.size();
+
+    std::vector<uint32_t> midpoints(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t e = face_edges[i];
+        if (edges[e].midpoint == NONE) {
+            Vector3d midpoint = (vertices[edges[e].a].position + vertices[edges[e].b].position) * 0.5;
+            midpoint.set_color(sf::Color::White);
+
+            // on the two children of the faces of e and the faces replacing its vertices
+            uint32_t v = add_vertex(midpoint, 4);
+            edges[e].midpoint = v;
+        }
+        edges[e].refined++;
+        midpoints[i] = edges[e].midpoint;
+    }
+
+    std::vector<uint32_t> cuts(n);
+    for (size_t i = 0; i < n; ++i) {
+        cuts[i] = add_edge(midpoints[i], midpoints[(i + 1) % n]);
+        vertices[corners[i]].cuts.push_back(cuts[i]);
+        vertices[corners[i]].refined++;
+    }
+
+    uint32_t child = add_face(level + 1, cuts, faces[f].outward);
+    faces[f].child = child;
+    faces[f].cuts = cuts;
+
+    for (uint32_t corner : corners) {
+        if (vertices[corner].refined != vertices[corner].degree)
+            continue;
+
+        // chain the cuts so that consecutive edges share a midpoint
+        std::vector<uint32_t> ring = vertices[corner].cuts;
+        uint32_t shared = edges[ring[0]].b;
+        for (size_t i = 1; i < ring.size(); ++i) {
+            for (size_t j = i; j < ring.size(); ++j) {
+                if (edges[ring[j]].a == shared || edges[ring[j]].b == shared) {
+                    std::swap(ring[i], ring[j]);
+                    break;
+                }
+            }
+            shared = edges[ring[i]].a == shared ? edges[ring[i]].b : edges[ring[i]].a;
+        }
+
+        uint32_t face = add_face(level + 1, ring, Vector3d());
+        faces[face].outward = vertices[corner].position - faces[face].centroid;
+        vertices[corner].face = face;
+    }
+}
+
+// inverse of refine(): the descendants of f and the faces replacing its corners are removed first
+void AdaptiveRectifier::unrefine(const uint32_t f) {
+    const uint32_t child = faces[f].child;
+    if (faces[child].child != NONE)
+        unrefine(child);
+    remove_face(child);
+
+    const std::vector<uint32_t> corners = faces[f].corners;
+    const std::vector<uint32_t> cuts = faces[f].cuts;
+    for (size_t i = 0; i < corners.size(); ++i) {
+        Vertex &corner = vertices[corners[i]];
+        if (corner.face != NONE) {
+            if (faces[corner.face].child != NONE)
+                unrefine(corner.face);
+            remove_face(corner.face);
+            corner.face = NONE;
+        }
+
+        corner.refined--;
+        corner.cuts.erase(std::find(corner.cuts.begin(), corner.cuts.end(), cuts[i]));
+        remove_edge(cuts[i]);
+    }
+
+    for (uint32_t e : faces[f].edges) {
+        if (--edges[e].refined == 0) {
+            remove_vertex(edges[e].midpoint);
+            edges[e].midpoint = NONE;
+        }
+    }
+
+    faces[f].child = NONE;
+    faces[f].cuts.clear();
+}
+
+// walks the hierarchy level by level from the seed: a face is rectified while it is below the
+// requested depth, in the frustrum and larger than ADAPTIVE_FACE_PIXELS on screen, and merged
+// back otherwise, returns true if the shape changed
+bool AdaptiveRectifier::update(const Camera3d &camera) {
+    bool changed = false;
+    size_t refinements = 0;
+    std::vector<uint32_t> current = base_faces, next;
+
+    updates++;
+    level_faces.clear();
+    for (unsigned level = 0; ! current.empty(); ++level) {
+        level_faces.push_back(current.size());
+
+        for (uint32_t f : current) {
+            const Face &face = faces[f];
+            const bool refined = face.child != NONE;
+            const double scale = refined ? ADAPTIVE_HYSTERESIS : 1.0;
+            const Vector3d center = camera.transform_vector(face.centroid);
+
+            const bool wanted = level < depth
+                             && camera.is_sphere_in_frustrum(center, face.radius / scale)
+                             && (center.z <= face.radius || face.radius * PROJECTION_FACTOR / center.z > ADAPTIVE_FACE_PIXELS * scale);
+
+            if (wanted && ! refined && refinements < ADAPTIVE_REFINEMENTS_LIMIT) {
+                refine(f);
+                refinements++;
+                changed = true;
+            }
+            else if (! wanted && refined) {
+                unrefine(f);
+                changed = true;
+            }
+        }
+
+        // faces of the next level: the children and the faces replacing the corners, met several times
+        next.clear();
+        for (uint32_t f : current) {
+            if (faces[f].child == NONE)
+                continue;
+
+            next.push_back(faces[f].child);
+            for (uint32_t corner : faces[f].corners) {
+                uint32_t face = vertices[corner].face;
+                if (face != NONE && faces[face].mark != updates) {
+                    faces[face].mark = updates;
+                    next.push_back(face);
+                }
+            }
+        }
+        current.swap(next);
+    }
+
+    if (changed)
+        build_shape();
+
+    return changed;
+}
+
+// an edge is drawn unless both its faces are rectified, so the edges of the unrectified
+// faces close the regions left at a coarser level
+void AdaptiveRectifier::build_shape() {
+    std::shared_ptr<Solid3d> next = std::make_shared<Solid3d>();
+    std::vector<uint32_t> drawn(edges.size(), NONE);
+
+    for (size_t e = 0; e < edges.size(); ++e) {
+        const Edge &edge = edges[e];
+        if (edge.a == NONE)
+            continue;
+        if (edge.faces[0] != NONE && edge.faces[1] != NONE && faces[edge.faces[0]].child != NONE && faces[edge.faces[1]].child != NONE)
+            continue;
+
+        drawn[e] = static_cast<uint32_t>(next->edges.size());
+        next->add_segment(Segment3d(vertices[edge.a].position, vertices[edge.b].position));
+    }
+
+    for (const Face &face : faces) {
+        if (face.edges.empty() || face.child != NONE)
+            continue;
+
+        std::vector<uint32_t> face_edges;
+        for (uint32_t e : face.edges)
+            face_edges.push_back(drawn[e]);
+
+        Face3d drawn_face(next->edges, face_edges);
+        drawn_face.orient(face.outward);
+        next->add_face(drawn_face);
+    }
+
+    next->build_clusters();
+    shape = next;
+}
+
+// faces visited at each level by the last update and edges drawn
+std::string AdaptiveRectifier::get_stats() const {
+    std::string stats = "# of edges drawn: " + std::to_string(shape->edges.size()) + "\n";
+    stats += "Faces per iteration:\n";
+    for (size_t level = 0; level < level_faces.size(); ++level)
+        stats += "\t" + std::to_string(level) + ": " + std::to_string(level_faces[level]) + " faces\n";
+
+    return stats;
+}
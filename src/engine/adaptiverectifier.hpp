@@ -0,0 +1,83 @@
+#ifndef ADAPTIVE_RECTIFIER_HPP
+#define ADAPTIVE_RECTIFIER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "../geometry/solid3d.hpp"
+#include "../geometry/camera3d.hpp"
+
+#define ADAPTIVE_FACE_PIXELS       16.0 // a face is rectified while its projected radius is larger
+#define ADAPTIVE_HYSTERESIS        0.75 // a rectified face is only merged back below this fraction of it
+#define ADAPTIVE_REFINEMENTS_LIMIT 8192 // faces rectified by one update, the others wait for the next ones
+
+// view-dependent rectification: the iterations of the seed form a hierarchy where a
+// face is only rectified while it is in the camera frustrum and large on screen, up to
+// the requested depth, so that distant or culled regions stay at coarser iterations.
+// An element of the next iteration is only created once every face it depends on is
+// rectified, so each drawn edge is an edge of the full iteration of its level
+class AdaptiveRectifier {
+private:
+    static const uint32_t NONE = UINT32_MAX;
+
+    struct Vertex {
+        Vector3d position;
+        uint32_t degree;            // faces around the vertex
+        uint32_t refined;           // rectified faces around the vertex
+        uint32_t face;              // face of the next iteration replacing the vertex, NONE until refined == degree
+        std::vector<uint32_t> cuts; // edges of the next iteration cutting the corners of the vertex
+    };
+
+    struct Edge {
+        uint32_t a, b;     // vertices, a is NONE for a free edge
+        uint32_t faces[2]; // NONE for a face not created
+        uint32_t refined;  // rectified faces of the edge
+        uint32_t midpoint; // vertex of the next iteration, NONE while refined is 0
+    };
+
+    struct Face {
+        unsigned level;
+        std::vector<uint32_t> edges;   // in order around the face, empty for a free face
+        std::vector<uint32_t> corners; // corners[i] is shared by edges[i] and edges[i + 1]
+        std::vector<uint32_t> cuts;    // cuts[i] cuts corners[i] at the next iteration, empty when not rectified
+        uint32_t child;                // same face at the next iteration, NONE when not rectified
+        Vector3d outward;
+        Vector3d centroid;
+        double radius;
+        unsigned mark;                 // last update that visited the face
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<Edge> edges;
+    std::vector<Face> faces;
+    std::vector<uint32_t> free_vertices, free_edges, free_faces;
+    std::vector<uint32_t> base_faces;
+    std::vector<size_t> level_faces; // faces of each level visited by the last update
+    unsigned depth;
+    unsigned updates;
+    std::shared_ptr<const Solid3d> shape;
+
+    uint32_t add_vertex(const Vector3d &position, const uint32_t degree);
+    uint32_t add_edge(const uint32_t a, const uint32_t b);
+    uint32_t add_face(const unsigned level, const std::vector<uint32_t> &face_edges, const Vector3d &outward);
+    void remove_vertex(const uint32_t v);
+    void remove_edge(const uint32_t e);
+    void remove_face(const uint32_t f);
+    void refine(const uint32_t f);
+    void unrefine(const uint32_t f);
+    void build_shape();
+
+public:
+    // constructors
+    AdaptiveRectifier(const Solid3d &seed, const unsigned _depth);
+
+    // others
+    static bool can_refine(const Solid3d &seed);
+    unsigned get_depth() const { return depth; }
+    void set_depth(const unsigned _depth) { depth = _depth; }
+    bool update(const Camera3d &camera);
+    const std::shared_ptr<const Solid3d>& get_shape() const { return shape; }
+    std::string get_stats() const;
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "batch.hpp"
+#include "shapecounts.hpp"
+#include "memorybudget.hpp"
+#include "../utils/memory.hpp"
+#include "../utils/perfcounter.hpp"
+#include "distributedrectifier.hpp"
+#include "../geometry/meshsimplifier.hpp"
+#include <chrono>
+
+static double getMilliseconds(const std::chrono::steady_clock::time_point &start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// one projection of the shape on the calling thread, as the transform and the clipping of a
+// frame do, by a camera close enough to see about half of it so that the clusters outside
+// the view are skipped: its time and the cache misses it causes, both lowered by the spatial
+// order (tighter clusters, fewer edges read for nothing). figure is the buffer of the projected
+// edges, kept between the shapes measured
+static void measureFigure(const Solid3d &shape, std::vector<sf::Vertex> &figure, PerfCounter &counter, double &time, uint64_t &cacheMisses) {
+  Vector3d center;
+  double radius;
+  shape.get_bounding_sphere(center, radius);
+  const Camera3d camera(center - Vector3d(0, 0, 0.8 * radius), 0, 0, 0, 1280, 720);
+  figure.resize(2 * shape.edges.size() + 2);
+
+  auto start = std::chrono::steady_clock::now();
+  counter.start();
+  shape.write_figure(figure.data(), 0, shape.edges.size(), 1280, 720, camera);
+  cacheMisses = counter.stop();
+  time = getMilliseconds(start);
+}
+
+// the lighter copy of an iteration drawn by the window with --simplify or --simplify-error
+struct Simplification {
+  bool done;
+  size_t edges;
+  double time;       // ms
+  double error;      // largest move, relative to the radius of the shape
+  double figureTime; // ms of its projection, see measureFigure()
+};
+
+static Simplification simplify(const Solid3d &shape, const Options &options, const std::atomic_bool &cancel, std::vector<sf::Vertex> &figure, PerfCounter &counter) {
+  Simplification simplification = {false, shape.edges.size(), 0.0, 0.0, 0.0};
+  if (options.simplify ? shape.edges.size() <= options.simplify : !(options.simplify_error > 0)) {
+    return simplification;
+  }
+
+  Vector3d center;
+  double radius;
+  shape.get_bounding_sphere(center, radius);
+
+  auto start = std::chrono::steady_clock::now();
+  MeshSimplifier simplifier(shape);
+  simplifier.simplify(options.simplify, options.simplify_error * radius, cancel);
+  Solid3d simplified = simplifier.get_shape();
+  simplified.build_clusters();
+  simplification.time = getMilliseconds(start);
+
+  if (options.figure) {
+    uint64_t cacheMisses;
+    measureFigure(simplified, figure, counter, simplification.figureTime, cacheMisses);
+  }
+  simplification.done = true;
+  simplification.edges = simplified.edges.size();
+  simplification.error = radius > 0 ? simplifier.get_error() / radius : 0.0;
+  return simplification;
+}
+
+// "faces":8,"edges":12,"vertices":6,"edges_per_vertex":{"4":6}
+static void printCounts(std::ostream &os, const ShapeCounts &counts) {
+  os << "\"faces\":" << counts.get_face_count()
+     << ",\"edges\":" << counts.get_edge_count()
+     << ",\"vertices\":" << counts.get_vertex_count()
+     << ",\"edges_per_vertex\":{";
+
+  for (auto degree = counts.degrees.begin(); degree != counts.degrees.end(); ++degree) {
+    os << (degree == counts.degrees.begin() ? "" : ",") << "\"" << degree->first << "\":" << degree->second;
+  }
+  os << "}";
+}
+
+// {"iteration":1,"time_ms":0.1,"memory_bytes":...,"peak_memory_bytes":...,"shape_bytes":...,"next_estimate_bytes":...[,"figure_ms":...,"figure_cache_misses":...],"faces":8,"edges":12,"vertices":6,"edges_per_vertex":{"4":6}[,"file":...,"file_bytes":...,"export_ms":...][,"simplified_edges":...,"simplify_ms":...,"simplify_error":...[,"simplified_figure_ms":...]]}
+// the figure is measured with --figure on only, figure_cache_misses is null where the hardware counters are not available
+static void printIteration(std::ostream &os, const Rectifier &rectifier, const double time, const std::string &file, const uint64_t fileBytes, const double exportTime, const Simplification &simplification, std::vector<sf::Vertex> *figure, PerfCounter &counter) {
+  ShapeCounts counts(*rectifier.get_shape());
+  double figureTime = 0.0;
+  uint64_t cacheMisses = 0;
+  if (figure) {
+    measureFigure(*rectifier.get_shape(), *figure, counter, figureTime, cacheMisses);
+  }
+
+  os << std::setprecision(3) << std::fixed;
+  os << "{\"iteration\":" << rectifier.get_iteration()
+     << ",\"time_ms\":" << time
+     << ",\"memory_bytes\":" << get_memory_usage()
+     << ",\"peak_memory_bytes\":" << get_peak_memory_usage()
+     << ",\"shape_bytes\":" << rectifier.get_memory_usage()
+     << ",\"next_estimate_bytes\":" << rectifier.estimate_next_memory(rectifier.get_mode());
+  if (figure) {
+    os << ",\"figure_ms\":" << figureTime
+       << ",\"figure_cache_misses\":" << (counter.is_open() ? std::to_string(cacheMisses) : "null");
+  }
+  os << ",";
+  printCounts(os, counts);
+
+  if (!file.empty()) {
+    os << ",\"file\":\"" << file << "\",\"file_bytes\":" << fileBytes << ",\"export_ms\":" << exportTime;
+  }
+
+  if (simplification.done) {
+    os << ",\"simplified_edges\":" << simplification.edges
+       << ",\"simplify_ms\":" << simplification.time
+       << ",\"simplify_error\":" << std::setprecision(6) << simplification.error << std::setprecision(3);
+    if (figure) {
+      os << ",\"simplified_figure_ms\":" << simplification.figureTime;
+    }
+  }
+
+  os << "}" << std::endl;
+}
+
+int runBatch(const Options &options) {
+  std::atomic_bool cancel(false);
+  Solid3d seed;
+
+  // the time of iteration 0 includes loading the seed
+  auto start = std::chrono::steady_clock::now();
+  if (!getSeed(options.seed, seed)) {
+    return EXIT_FAILURE;
+  }
+  std::shared_ptr<DistributedRectifier> workers;
+  if (options.processes) {
+    std::string error;
+    workers = std::make_shared<DistributedRectifier>(options.processes);
+    if (!workers->start(error)) {
+      std::cerr << "cannot start the workers: " << error << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  Rectifier rectifier = Rectifier(seed, options.mode).with_curve(options.curve).with_workers(workers);
+  double time = getMilliseconds(start);
+  PerfCounter counter;
+  std::vector<sf::Vertex> figure; // projected edges of the measured shapes, released before each iteration
+
+  for (unsigned i = 0; ; i++) {
+    std::string file;
+    uint64_t fileBytes = 0;
+    double exportTime = 0.0;
+
+    if (options.do_export) {
+      file = options.output + "_" + std::to_string(rectifier.get_iteration()) + "." + MeshIO::get_extension(options.format);
+
+      auto exportStart = std::chrono::steady_clock::now();
+      if (!MeshIO::write(*rectifier.get_shape(), file, options.format, &fileBytes)) {
+        std::cerr << "could not write " << file << std::endl;
+        return EXIT_FAILURE;
+      }
+      exportTime = getMilliseconds(exportStart);
+    }
+
+    // the full shape is exported, the simplified one only measured
+    const Simplification simplification = simplify(*rectifier.get_shape(), options, cancel, figure, counter);
+    printIteration(std::cout, rectifier, time, file, fileBytes, exportTime, simplification, options.figure ? &figure : nullptr, counter);
+    figure.clear();
+    figure.shrink_to_fit();
+
+    if (i == options.iterations) {
+      break;
+    }
+
+    std::string message;
+    if (!fitMemoryBudget(rectifier, options.memory_budget, message)) {
+      std::cerr << message << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!message.empty()) {
+      std::cerr << message << std::endl;
+    }
+
+    start = std::chrono::steady_clock::now();
+    Rectifier next = rectifier.get_next(cancel);
+    time = getMilliseconds(start);
+
+    if (next.get_iteration() == rectifier.get_iteration()) {
+      std::cerr << "iteration " << rectifier.get_iteration() + 1 << " cannot be computed" << std::endl;
+      return EXIT_FAILURE;
+    }
+    rectifier = next;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// {"iteration":30,"predicted":true,"faces":...,"edges":...,"vertices":...,"edges_per_vertex":{...},"face_sizes":{...}}
+// face_sizes has the key 0 for the faces of unknown size (seeds whose faces are not known)
+int runPrediction(const Options &options) {
+  Solid3d seed;
+  if (!getSeed(options.seed, seed)) {
+    return EXIT_FAILURE;
+  }
+
+  ShapeCounts counts(seed);
+  for (unsigned i = 0; ; i++) {
+    std::cout << "{\"iteration\":" << i << ",\"predicted\":true,";
+    printCounts(std::cout, counts);
+    std::cout << ",\"face_sizes\":{";
+    for (auto size = counts.face_sizes.begin(); size != counts.face_sizes.end(); ++size) {
+      std::cout << (size == counts.face_sizes.begin() ? "" : ",") << "\"" << size->first << "\":" << size->second;
+    }
+    std::cout << "}}" << std::endl;
+
+    if (i == options.predict) {
+      break;
+    }
+    if (!counts.can_rectify()) {
+      std::cerr << "iteration " << i + 1 << " cannot be predicted" << std::endl;
+      return EXIT_FAILURE;
+    }
+    counts = counts.get_next();
+  }
+
+  return EXIT_SUCCESS;
+}
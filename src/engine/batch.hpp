@@ -0,0 +1,12 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "options.hpp"
+
+// headless run of options.iterations rectifications, one JSON line per iteration on std::cout
+int runBatch(const Options &options);
+
+// statistics of iterations 0 to options.predict from ShapeCounts::get_next(), without any geometry
+int runPrediction(const Options &options);
+
+#endif
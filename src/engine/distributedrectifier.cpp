@@ -0,0 +1,620 @@
+#include "distributedrectifier.hpp"
+#include "rectification.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <numeric>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#define NO_VERTEX UINT32_MAX
+
+// little-endian whatever the host, see the frames in distributedrectifier.hpp
+static void putUint(std::vector<uint8_t> &out, const uint64_t value, const unsigned bytes) {
+    for (unsigned i = 0; i < bytes; ++i)
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+static void putHeader(std::vector<uint8_t> &out, const DistributedRectifier::FRAME type, const uint64_t size) {
+    putUint(out, REGION_MAGIC, 4);
+    putUint(out, REGION_VERSION, 2);
+    putUint(out, type, 2);
+    putUint(out, size, 8);
+}
+
+// bounded reads of a payload, ok turns false at the first read beyond its end
+class PayloadReader {
+private:
+    const uint8_t *data, *end;
+
+public:
+    bool ok;
+
+    explicit PayloadReader(const std::vector<uint8_t> &payload) : data(payload.data()), end(payload.data() + payload.size()), ok(true) {}
+
+    uint64_t get(const unsigned bytes) {
+        if (static_cast<size_t>(end - data) < bytes) {
+            ok = false;
+            return 0;
+        }
+
+        uint64_t value = 0;
+        for (unsigned i = 0; i < bytes; ++i)
+            value |= static_cast<uint64_t>(data[i]) << (8 * i);
+        data += bytes;
+
+        return value;
+    }
+
+    uint32_t get_uint32() { return static_cast<uint32_t>(get(4)); }
+    int64_t get_int64() { return static_cast<int64_t>(get(8)); }
+    bool is_done() const { return ok && data == end; }
+};
+
+// the whole of data, false on error (a worker gone)
+static bool writeAll(const int fd, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return true;
+}
+
+// the whole of data, returns the bytes read, fewer only at the end of the stream or on error
+static size_t readAll(const int fd, uint8_t *data, const size_t size) {
+    size_t done = 0;
+
+    while (done < size) {
+        const ssize_t bytes = read(fd, data + done, size - done);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes <= 0)
+            break;
+
+        done += static_cast<size_t>(bytes);
+    }
+
+    return done;
+}
+
+// type and payload size of the REGION_HEADER_BYTES of header, false with error if they are not
+// the header of a frame of this version
+static bool parseHeader(const std::vector<uint8_t> &header, DistributedRectifier::FRAME &type, uint64_t &size, std::string &error) {
+    PayloadReader in(header);
+    const uint32_t magic = in.get_uint32();
+    const uint32_t version = static_cast<uint32_t>(in.get(2));
+    type = static_cast<DistributedRectifier::FRAME>(in.get(2));
+    size = in.get(8);
+
+    if (magic != REGION_MAGIC) {
+        error = "not a region frame";
+        return false;
+    }
+    if (version != REGION_VERSION) {
+        error = "frame version " + std::to_string(version) + ", version " + std::to_string(REGION_VERSION) + " expected";
+        return false;
+    }
+    if (size > REGION_MAX_PAYLOAD) {
+        error = "frame of " + std::to_string(size) + " bytes";
+        return false;
+    }
+
+    return true;
+}
+
+// the vertices of order[begin, end) go to count regions from first on, by halving their bounding
+// box on its longest side, the ties broken by vertex index so that the regions only depend on the shape
+static void splitRegions(const ExactSolid3d &shape, std::vector<uint32_t> &order, const size_t begin, const size_t end, const uint32_t first, const unsigned count, std::vector<uint32_t> &regions) {
+    if (count <= 1 || end - begin <= 1) {
+        for (size_t i = begin; i < end; ++i)
+            regions[order[i]] = first;
+        return;
+    }
+
+    int64_t low[3] = {INT64_MAX, INT64_MAX, INT64_MAX}, high[3] = {INT64_MIN, INT64_MIN, INT64_MIN};
+    for (size_t i = begin; i < end; ++i) {
+        const LatticePoint &p = shape.vertices[order[i]];
+        const int64_t coordinates[3] = {p.x, p.y, p.z};
+        for (unsigned c = 0; c < 3; ++c) {
+            low[c] = std::min(low[c], coordinates[c]);
+            high[c] = std::max(high[c], coordinates[c]);
+        }
+    }
+
+    unsigned axis = 0;
+    for (unsigned c = 1; c < 3; ++c)
+        if (high[c] - low[c] > high[axis] - low[axis])
+            axis = c;
+
+    auto coordinate = [&](const uint32_t v) {
+        const LatticePoint &p = shape.vertices[v];
+        return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+    };
+
+    // as many vertices per region on both sides
+    const unsigned left = count / 2;
+    const size_t middle = begin + (end - begin) * left / count;
+    std::nth_element(order.begin() + static_cast<std::ptrdiff_t>(begin), order.begin() + static_cast<std::ptrdiff_t>(middle), order.begin() + static_cast<std::ptrdiff_t>(end), [&](const uint32_t a, const uint32_t b) {
+        const int64_t ca = coordinate(a), cb = coordinate(b);
+        return ca != cb ? ca < cb : a < b;
+    });
+
+    splitRegions(shape, order, begin, middle, first, left, regions);
+    splitRegions(shape, order, middle, end, first + left, count - left, regions);
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+DistributedRectifier::DistributedRectifier(const unsigned _processes, const std::string &_executable) : processes(_processes), executable(_executable) {}
+
+DistributedRectifier::~DistributedRectifier() {
+    stop();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// runs the workers, false if one of them could not be started
+// each one talks through a socket pair rather than pipes, so that a worker gone fails the sends
+// (MSG_NOSIGNAL) instead of raising SIGPIPE, which would otherwise have to be ignored by the
+// whole process
+bool DistributedRectifier::start(std::string &error) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // everything the child needs before exec, it may only call async-signal-safe functions
+    char worker_option[] = "--worker", worker_transport[] = "stdio";
+    std::vector<char> path(executable.begin(), executable.end());
+    path.push_back('\0');
+    char *const arguments[] = {path.data(), worker_option, worker_transport, nullptr};
+
+    for (unsigned i = 0; i < processes; ++i) {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+            error = std::string("socketpair: ") + strerror(errno);
+            stop();
+            return false;
+        }
+
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // dup2() clears close-on-exec on stdin and stdout only
+            if (dup2(sockets[1], STDIN_FILENO) < 0 || dup2(sockets[1], STDOUT_FILENO) < 0)
+                _exit(127);
+            execv(path.data(), arguments);
+            _exit(127);
+        }
+
+        close(sockets[1]);
+        if (pid < 0 || fcntl(sockets[0], F_SETFL, fcntl(sockets[0], F_GETFL) | O_NONBLOCK) != 0) {
+            error = std::string(pid < 0 ? "fork: " : "fcntl: ") + strerror(errno);
+            close(sockets[0]);
+            if (pid > 0) {
+                kill(pid, SIGKILL);
+                while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+            }
+            stop();
+            return false;
+        }
+
+        workers.push_back(Worker{pid, sockets[0]});
+    }
+
+    return true;
+}
+
+// closing its socket ends a worker once it has answered its region, kill_workers ends it at once
+void DistributedRectifier::stop(const bool kill_workers) {
+    for (const Worker &worker : workers) {
+        if (kill_workers)
+            kill(worker.pid, SIGKILL);
+        close(worker.socket);
+    }
+    for (const Worker &worker : workers) {
+        int status;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+    }
+    workers.clear();
+}
+
+// the regions are sent one after the other, a request being freed once sent, and the answers are
+// read as they come: a poll() loop on the calling thread (a background task) multiplexes the
+// sockets rather than a thread or a scheduler task per worker, which would block in their reads
+// for as long as the workers compute while holding threads of the pool. cancel is checked every
+// REGION_POLL_MS, the workers being killed then since they would finish their regions first.
+// The answers are kept until stitched, see Rectifier::estimate_next_memory(). False with error
+// if a worker failed, all of them being stopped then, or if cancel was set
+bool DistributedRectifier::get_next_shape(const ExactSolid3d &shape, const std::atomic_bool &cancel, ExactSolid3d &next, std::string &error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (workers.empty()) {
+        error = "no worker running";
+        return false;
+    }
+
+    const size_t count = workers.size();
+    const std::vector<uint32_t> regions = get_regions(shape, static_cast<unsigned>(count));
+    std::vector<std::vector<uint8_t>> headers(count), answers(count);
+    std::vector<size_t> received(count, 0); // bytes of the payload of the answer
+    std::vector<FRAME> types(count, ERROR);
+    std::vector<uint8_t> request_header, request; // frame of the region being sent
+    size_t sending = 0, sent = 0;                 // worker receiving its region, bytes of the frame sent
+    size_t waiting = count;                       // answers not complete
+
+    auto fail = [&](const size_t i, const std::string &message) {
+        error = "worker " + std::to_string(i) + message;
+        stop(true);
+        return false;
+    };
+    auto prepare = [&]() {
+        write_region(shape, regions, static_cast<uint32_t>(sending), request);
+        request_header.clear();
+        putHeader(request_header, REGION, request.size());
+    };
+
+    prepare();
+    std::vector<pollfd> polled;
+    std::vector<size_t> polled_workers;
+    while (waiting > 0) {
+        if (cancel) {
+            error = "cancelled";
+            stop(true);
+            return false;
+        }
+
+        // the worker receiving its region, then the ones computing theirs
+        polled.clear();
+        polled_workers.clear();
+        for (size_t i = 0; i < count && i <= sending; ++i) {
+            if (i == sending || headers[i].size() < REGION_HEADER_BYTES || received[i] < answers[i].size()) {
+                polled.push_back(pollfd{workers[i].socket, static_cast<short>(i == sending ? POLLOUT : POLLIN), 0});
+                polled_workers.push_back(i);
+            }
+        }
+
+        const int ready = poll(polled.data(), polled.size(), REGION_POLL_MS);
+        if (ready < 0 && errno != EINTR) {
+            error = std::string("poll: ") + strerror(errno);
+            stop(true);
+            return false;
+        }
+        if (ready <= 0)
+            continue;
+
+        for (size_t p = 0; p < polled.size(); ++p) {
+            if (! polled[p].revents)
+                continue;
+            const size_t i = polled_workers[p];
+
+            if (i == sending) {
+                const bool in_header = sent < request_header.size();
+                const std::vector<uint8_t> &part = in_header ? request_header : request;
+                const size_t offset = in_header ? sent : sent - request_header.size();
+                const ssize_t bytes = send(workers[i].socket, part.data() + offset, part.size() - offset, MSG_NOSIGNAL);
+                if (bytes < 0 && (errno == EINTR || errno == EAGAIN))
+                    continue;
+                if (bytes < 0)
+                    return fail(i, " does not read its region");
+
+                sent += static_cast<size_t>(bytes);
+                if (sent == request_header.size() + request.size()) {
+                    sent = 0;
+                    if (++sending < count)
+                        prepare();
+                    else
+                        std::vector<uint8_t>().swap(request);
+                }
+                continue;
+            }
+
+            // the header of the answer, then its payload
+            const bool in_header = headers[i].size() < REGION_HEADER_BYTES;
+            uint8_t header_bytes[REGION_HEADER_BYTES];
+            uint8_t *data = in_header ? header_bytes : answers[i].data() + received[i];
+            const size_t size = in_header ? REGION_HEADER_BYTES - headers[i].size() : answers[i].size() - received[i];
+            const ssize_t bytes = recv(workers[i].socket, data, size, 0);
+            if (bytes < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            if (bytes < 0)
+                return fail(i, std::string(": ") + strerror(errno));
+            if (bytes == 0)
+                return fail(i, " exited");
+
+            if (! in_header)
+                received[i] += static_cast<size_t>(bytes);
+            else {
+                headers[i].insert(headers[i].end(), data, data + bytes);
+                uint64_t payload = 0;
+                std::string message;
+                if (headers[i].size() < REGION_HEADER_BYTES)
+                    continue;
+                if (! parseHeader(headers[i], types[i], payload, message))
+                    return fail(i, ": " + message);
+                answers[i].resize(payload);
+            }
+            if (headers[i].size() < REGION_HEADER_BYTES || received[i] < answers[i].size())
+                continue;
+
+            if (types[i] == ERROR)
+                return fail(i, ": " + std::string(answers[i].begin(), answers[i].end()));
+            if (types[i] != POLYGONS)
+                return fail(i, ": unexpected frame " + std::to_string(types[i]));
+            --waiting;
+        }
+    }
+
+    return stitch(shape, regions, answers, next, error);
+}
+
+// region of every vertex, count regions of about as many vertices each
+std::vector<uint32_t> DistributedRectifier::get_regions(const ExactSolid3d &shape, const unsigned count) {
+    std::vector<uint32_t> regions(shape.vertices.size(), 0);
+    std::vector<uint32_t> order(shape.vertices.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    splitRegions(shape, order, 0, order.size(), 0, std::max(1u, count), regions);
+    return regions;
+}
+
+// REGION payload of region: its vertices, the edges reaching them and the other ends of those
+void DistributedRectifier::write_region(const ExactSolid3d &shape, const std::vector<uint32_t> &regions, const uint32_t region, std::vector<uint8_t> &payload) {
+    std::vector<uint32_t> owned;
+    for (uint32_t v = 0; v < shape.vertices.size(); ++v)
+        if (regions[v] == region)
+            owned.push_back(v);
+
+    std::unordered_map<uint32_t, uint32_t> local;
+    local.reserve(2 * owned.size());
+    for (uint32_t i = 0; i < owned.size(); ++i)
+        local.emplace(owned[i], i);
+
+    // the overlap: ends of the edges of the region owned by the other regions
+    std::vector<uint32_t> overlap;
+    std::vector<uint32_t> edges; // edge index, local a, local b
+    auto get_local = [&](const uint32_t v) {
+        auto inserted = local.emplace(v, static_cast<uint32_t>(owned.size() + overlap.size()));
+        if (inserted.second)
+            overlap.push_back(v);
+        return inserted.first -> second;
+    };
+
+    for (uint32_t e = 0; e < shape.edges.size(); ++e) {
+        const auto &edge = shape.edges[e];
+        if (regions[edge.first] != region && regions[edge.second] != region)
+            continue;
+
+        const uint32_t a = get_local(edge.first);
+        const uint32_t b = get_local(edge.second);
+        edges.insert(edges.end(), {e, a, b});
+    }
+
+    payload.clear();
+    payload.reserve(12 + 24 * (owned.size() + overlap.size()) + 4 + 4 * edges.size());
+    putUint(payload, static_cast<uint32_t>(shape.shift), 4);
+    putUint(payload, owned.size(), 4);
+    putUint(payload, overlap.size(), 4);
+    for (const std::vector<uint32_t> *vertices : {&owned, &overlap}) {
+        for (const uint32_t v : *vertices) {
+            const LatticePoint &p = shape.vertices[v];
+            putUint(payload, static_cast<uint64_t>(p.x), 8);
+            putUint(payload, static_cast<uint64_t>(p.y), 8);
+            putUint(payload, static_cast<uint64_t>(p.z), 8);
+        }
+    }
+    putUint(payload, edges.size() / 3, 4);
+    for (const uint32_t value : edges)
+        putUint(payload, value, 4);
+}
+
+// the worker side: POLYGONS payload of a REGION payload, false with error if it is malformed
+bool DistributedRectifier::answer_region(const std::vector<uint8_t> &request, std::vector<uint8_t> &answer, std::string &error) {
+    PayloadReader in(request);
+    in.get_uint32(); // shift, the midpoints are sums at the next scale
+    const uint32_t owned = in.get_uint32();
+    const uint32_t overlap = in.get_uint32();
+    const uint64_t vertex_count = uint64_t(owned) + overlap;
+    if (! in.ok || vertex_count * 24 > request.size()) {
+        error = "truncated region";
+        return false;
+    }
+
+    std::vector<LatticePoint> vertices(vertex_count);
+    for (auto &p : vertices) {
+        p.x = in.get_int64();
+        p.y = in.get_int64();
+        p.z = in.get_int64();
+    }
+
+    const uint32_t edge_count = in.get_uint32();
+    if (! in.ok || uint64_t(edge_count) * 12 > request.size()) {
+        error = "truncated region";
+        return false;
+    }
+
+    // the midpoints are numbered by the edges of the region, the edges of every owned vertex
+    // listed by increasing edge index as getNextShape() does
+    std::vector<uint32_t> indices(edge_count);
+    std::vector<LatticePoint> midpoints(edge_count);
+    std::vector<uint32_t> offsets(owned + 1, 0);
+    std::vector<std::pair<uint32_t, uint32_t>> ends(edge_count);
+    for (uint32_t i = 0; i < edge_count; ++i) {
+        indices[i] = in.get_uint32();
+        const uint32_t a = in.get_uint32(), b = in.get_uint32();
+        if (! in.ok || a >= vertex_count || b >= vertex_count) {
+            error = "invalid edge " + std::to_string(i) + " in region";
+            return false;
+        }
+
+        midpoints[i] = {vertices[a].x + vertices[b].x, vertices[a].y + vertices[b].y, vertices[a].z + vertices[b].z};
+        ends[i] = std::make_pair(a, b);
+        if (a < owned)
+            offsets[a + 1]++;
+        if (b < owned)
+            offsets[b + 1]++;
+    }
+    if (! in.is_done()) {
+        error = "trailing bytes in region";
+        return false;
+    }
+
+    for (uint32_t v = 0; v < owned; ++v)
+        offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> incident(offsets.back());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < edge_count; ++i) {
+        if (ends[i].first < owned)
+            incident[fill[ends[i].first]++] = i;
+        if (ends[i].second < owned)
+            incident[fill[ends[i].second]++] = i;
+    }
+
+    answer.clear();
+    answer.reserve(4 + 4 * owned + 16 * edge_count);
+    putUint(answer, owned, 4);
+
+    std::vector<uint32_t> around;
+    std::vector<std::pair<uint32_t, uint32_t>> polygon;
+    for (uint32_t v = 0; v < owned; ++v) {
+        around.assign(incident.begin() + offsets[v], incident.begin() + offsets[v + 1]);
+        polygon.clear();
+        connectMidpoints(around, midpoints.data(), polygon);
+
+        putUint(answer, polygon.size(), 4);
+        for (const auto &side : polygon) {
+            putUint(answer, indices[side.first], 4);
+            putUint(answer, indices[side.second], 4);
+        }
+    }
+
+    return true;
+}
+
+// the next shape: its vertices, the midpoints of the edges of shape, and the polygons of the
+// regions taken back in the order of the vertices of shape
+bool DistributedRectifier::stitch(const ExactSolid3d &shape, const std::vector<uint32_t> &regions, const std::vector<std::vector<uint8_t>> &answers, ExactSolid3d &next, std::string &error) {
+    next = ExactSolid3d();
+    next.shift = shape.shift + 1;
+    next.vertices.resize(shape.edges.size());
+    for (size_t i = 0; i < shape.edges.size(); ++i) {
+        const LatticePoint &a = shape.vertices[shape.edges[i].first];
+        const LatticePoint &b = shape.vertices[shape.edges[i].second];
+        next.vertices[i] = {a.x + b.x, a.y + b.y, a.z + b.z};
+    }
+
+    std::vector<PayloadReader> readers;
+    std::vector<uint32_t> owned(answers.size(), 0);
+    for (const auto &answer : answers) {
+        readers.emplace_back(answer);
+        readers.back().get_uint32();
+    }
+
+    next.edges.reserve(2 * shape.edges.size());
+    for (uint32_t v = 0; v < shape.vertices.size(); ++v) {
+        const uint32_t region = regions[v];
+        if (region >= readers.size()) {
+            error = "vertex " + std::to_string(v) + " has no region";
+            return false;
+        }
+
+        PayloadReader &in = readers[region];
+        owned[region]++;
+        const uint32_t sides = in.get_uint32();
+        for (uint32_t s = 0; s < sides && in.ok; ++s) {
+            const uint32_t a = in.get_uint32(), b = in.get_uint32();
+            if (a >= shape.edges.size() || b >= shape.edges.size())
+                in.ok = false;
+            next.edges.push_back(std::make_pair(a, b));
+        }
+
+        if (! in.ok) {
+            error = "invalid polygons from region " + std::to_string(region);
+            return false;
+        }
+    }
+
+    for (size_t r = 0; r < readers.size(); ++r) {
+        PayloadReader echo(answers[r]);
+        if (echo.get_uint32() != owned[r] || ! readers[r].is_done()) {
+            error = "region " + std::to_string(r) + " does not answer for its " + std::to_string(owned[r]) + " vertices";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DistributedRectifier::write_frame(const int fd, const FRAME type, const std::vector<uint8_t> &payload) {
+    std::vector<uint8_t> header;
+    putHeader(header, type, payload.size());
+
+    return writeAll(fd, header.data(), header.size()) && writeAll(fd, payload.data(), payload.size());
+}
+
+// false with an empty error at the end of the stream between two frames
+bool DistributedRectifier::read_frame(const int fd, FRAME &type, std::vector<uint8_t> &payload, std::string &error) {
+    std::vector<uint8_t> header(REGION_HEADER_BYTES);
+    const size_t bytes = readAll(fd, header.data(), header.size());
+    if (bytes == 0) {
+        error.clear();
+        return false;
+    }
+    if (bytes < header.size()) {
+        error = "truncated frame header";
+        return false;
+    }
+
+    uint64_t size;
+    if (! parseHeader(header, type, size, error))
+        return false;
+
+    payload.resize(size);
+    if (readAll(fd, payload.data(), payload.size()) < payload.size()) {
+        error = "truncated frame";
+        return false;
+    }
+
+    return true;
+}
+
+int runWorker() {
+    std::vector<uint8_t> request, answer;
+    std::string error;
+
+    for (;;) {
+        DistributedRectifier::FRAME type;
+        if (! DistributedRectifier::read_frame(STDIN_FILENO, type, request, error)) {
+            if (error.empty())
+                return EXIT_SUCCESS;
+            std::cerr << "worker: " << error << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (type != DistributedRectifier::REGION)
+            error = "unexpected frame " + std::to_string(type);
+        else if (DistributedRectifier::answer_region(request, answer, error)) {
+            if (! DistributedRectifier::write_frame(STDOUT_FILENO, DistributedRectifier::POLYGONS, answer))
+                return EXIT_FAILURE;
+            continue;
+        }
+
+        DistributedRectifier::write_frame(STDOUT_FILENO, DistributedRectifier::ERROR, std::vector<uint8_t>(error.begin(), error.end()));
+        return EXIT_FAILURE;
+    }
+}
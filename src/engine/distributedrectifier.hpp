@@ -0,0 +1,81 @@
+#ifndef DISTRIBUTEDRECTIFIER_HPP
+#define DISTRIBUTEDRECTIFIER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "../geometry/exactsolid3d.hpp"
+
+#define REGION_MAGIC        0x54434552u // "RECT" as read little-endian, first bytes of every frame
+#define REGION_VERSION      1           // of the frames below, a worker refuses the other ones
+#define REGION_HEADER_BYTES 16
+#define REGION_MAX_PAYLOAD  (uint64_t(1) << 36) // bytes, beyond the frame is taken as corrupted
+#define REGION_POLL_MS      100         // between two checks of cancel while the workers compute
+
+// lattice rectification (--mode exact) split among worker processes (--processes N):
+//    - the vertices are split into N spatial regions by halving the longest side of their
+//      bounding box, each region is sent with the edges of its vertices, whose other ends
+//      (the vertices of the neighboring regions) overlap with them
+//    - each worker orders the midpoints around its own vertices with connectMidpoints(), the
+//      new vertex on an edge being numbered after the edge, so the polygons of two regions
+//      meet on their shared edges without any vertex matching
+//    - the polygons are stitched in the order of the vertices, which gives the edges of
+//      getNextShape() whatever the number of regions
+// workers are the engine itself run with --worker stdio and talk through a socket pair; the frames
+// only hold fixed-size little-endian integers, so that a worker reached through a socket
+// on another host reads them the same way:
+//    header   uint32 REGION_MAGIC, uint16 REGION_VERSION, uint16 type, uint64 payload bytes
+//    REGION   int32 shift, uint32 owned vertices O, uint32 overlap vertices H,
+//             (O + H) x int64 x, y, z (the owned vertices first, in their order in the shape),
+//             uint32 edges E, E x uint32 edge index in the shape, local end a, local end b
+//             (by increasing edge index)
+//    POLYGONS uint32 O, for every owned vertex uint32 sides S, S x uint32 a, b (the new
+//             edges, their ends being the edge indices in the shape)
+//    ERROR    the message, UTF-8
+class DistributedRectifier {
+public:
+    enum FRAME : uint16_t {REGION = 1, POLYGONS = 2, ERROR = 3};
+
+private:
+    struct Worker {
+        pid_t pid;
+        int socket; // non-blocking, the other end is its stdin and stdout
+    };
+
+    const unsigned processes;
+    const std::string executable;
+    std::vector<Worker> workers;
+    std::mutex mutex; // one rectification at a time on the workers
+
+    void stop(const bool kill_workers = false);
+
+public:
+    // constructors
+    explicit DistributedRectifier(const unsigned _processes, const std::string &_executable = "/proc/self/exe");
+    DistributedRectifier(const DistributedRectifier &) = delete;
+    ~DistributedRectifier();
+
+    // operators
+    DistributedRectifier& operator=(const DistributedRectifier &) = delete;
+
+    // others
+    bool start(std::string &error);
+    unsigned get_processes() const { return processes; }
+    bool get_next_shape(const ExactSolid3d &shape, const std::atomic_bool &cancel, ExactSolid3d &next, std::string &error);
+
+    // the steps of get_next_shape(), whatever carries the frames
+    static std::vector<uint32_t> get_regions(const ExactSolid3d &shape, const unsigned count);
+    static void write_region(const ExactSolid3d &shape, const std::vector<uint32_t> &regions, const uint32_t region, std::vector<uint8_t> &payload);
+    static bool answer_region(const std::vector<uint8_t> &request, std::vector<uint8_t> &answer, std::string &error);
+    static bool stitch(const ExactSolid3d &shape, const std::vector<uint32_t> &regions, const std::vector<std::vector<uint8_t>> &answers, ExactSolid3d &next, std::string &error);
+    static bool write_frame(const int fd, const FRAME type, const std::vector<uint8_t> &payload);
+    static bool read_frame(const int fd, FRAME &type, std::vector<uint8_t> &payload, std::string &error);
+};
+
+// worker of --processes: answers the REGION frames of stdin on stdout until stdin is closed
+int runWorker();
+
+#endif
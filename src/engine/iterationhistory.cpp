@@ -0,0 +1,301 @@
+#include "iterationhistory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+
+// unsigned values take one byte per 7 bits, signed ones are zigzagged first so that
+// small differences of either sign stay short
+static void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t getVarint(const uint8_t *&in) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        const uint8_t byte = *in++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (! (byte & 0x80))
+            return value;
+    }
+}
+
+static void putSigned(std::vector<uint8_t> &out, const int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static int64_t getSigned(const uint8_t *&in) {
+    const uint64_t value = getVarint(in);
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+CompressedIteration::CompressedIteration(const Rectifier &rectifier) : mode(rectifier.get_mode()), curve(rectifier.get_curve()), iteration(rectifier.get_iteration()), step(1.0), vertex_count(0), edge_count(0), face_count(0), lattice_shift(0), lattice_vertex_count(0), lattice_edge_count(0) {
+    // the symmetric representatives are the iteration, its full shape is their expansion
+    if (mode == Rectifier::MODE::SYMMETRIC) {
+        symmetric_shape = rectifier.get_symmetric_shape();
+        return;
+    }
+
+    // the lattice as its vertices and edges, each as the difference to the previous one
+    if (mode == Rectifier::MODE::EXACT) {
+        const ExactSolid3d &exact = *rectifier.get_exact_shape();
+        lattice_shift = exact.shift;
+        lattice_vertex_count = static_cast<uint32_t>(exact.vertices.size());
+        lattice_edge_count = static_cast<uint32_t>(exact.edges.size());
+
+        LatticePoint previous = {0, 0, 0};
+        for (const LatticePoint &p : exact.vertices) {
+            putSigned(lattice_vertices, p.x - previous.x);
+            putSigned(lattice_vertices, p.y - previous.y);
+            putSigned(lattice_vertices, p.z - previous.z);
+            previous = p;
+        }
+
+        int64_t previous_index = 0;
+        for (const auto &edge : exact.edges) {
+            putSigned(lattice_edges, static_cast<int64_t>(edge.first) - previous_index);
+            putSigned(lattice_edges, static_cast<int64_t>(edge.second) - static_cast<int64_t>(edge.first));
+            previous_index = edge.first;
+        }
+
+        lattice_vertices.shrink_to_fit();
+        lattice_edges.shrink_to_fit();
+    }
+
+    const Solid3d &shape = *rectifier.get_shape();
+    edge_count = static_cast<uint32_t>(shape.edges.size());
+    face_count = static_cast<uint32_t>(shape.faces.size());
+    if (shape.edges.empty())
+        return;
+
+    // grid over the bounding box
+    double low[3] = {INFINITY, INFINITY, INFINITY}, high[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (const auto &edge : shape.edges) {
+        for (const Vector3d *v : {&edge.a, &edge.b}) {
+            const double coordinates[3] = {v -> get<0>(), v -> get<1>(), v -> get<2>()};
+            for (unsigned c = 0; c < 3; ++c) {
+                low[c] = std::min(low[c], coordinates[c]);
+                high[c] = std::max(high[c], coordinates[c]);
+            }
+        }
+    }
+    origin = Vector3d(low[0], low[1], low[2]);
+    const double extent = std::max(high[0] - low[0], std::max(high[1] - low[1], high[2] - low[2]));
+    if (extent > 0)
+        step = extent / ((UINT64_C(1) << HISTORY_COORDINATE_BITS) - 1);
+
+    // the vertices welded on the grid, numbered as the edges reach them
+    std::unordered_map<LatticePoint, uint32_t, LatticePointHash> indices;
+    indices.reserve(shape.edges.size());
+    LatticePoint previous = {0, 0, 0};
+    int64_t previous_index = 0;
+    sf::Color run_color;
+    uint64_t run = 0;
+
+    auto flush_run = [&]() {
+        putVarint(colors, run);
+        colors.insert(colors.end(), {run_color.r, run_color.g, run_color.b, run_color.a});
+    };
+
+    auto add_end = [&](const Vector3d &v) {
+        const LatticePoint p = {std::llround((v.get<0>() - origin.get<0>()) / step),
+                                std::llround((v.get<1>() - origin.get<1>()) / step),
+                                std::llround((v.get<2>() - origin.get<2>()) / step)};
+        const auto inserted = indices.emplace(p, vertex_count);
+        if (inserted.second) {
+            putSigned(vertices, p.x - previous.x);
+            putSigned(vertices, p.y - previous.y);
+            putSigned(vertices, p.z - previous.z);
+            previous = p;
+            vertex_count++;
+        }
+
+        const int64_t index = inserted.first -> second;
+        putSigned(edges, index - previous_index);
+        previous_index = index;
+
+        if (run > 0 && v.get_color() == run_color)
+            run++;
+        else {
+            if (run > 0)
+                flush_run();
+            run_color = v.get_color();
+            run = 1;
+        }
+    };
+
+    for (const auto &edge : shape.edges) {
+        add_end(edge.a);
+        add_end(edge.b);
+    }
+    flush_run();
+
+    // faces by their edge indices, the orientation of their normal as a bit
+    int64_t previous_edge = 0;
+    flipped.assign((face_count + 7) / 8, 0);
+    for (uint32_t f = 0; f < face_count; ++f) {
+        const Face3d &face = shape.faces[f];
+        putVarint(faces, face.edges.size());
+        for (const uint32_t edge : face.edges) {
+            putSigned(faces, static_cast<int64_t>(edge) - previous_edge);
+            previous_edge = edge;
+        }
+
+        if (Face3d(shape.edges, face.edges).normal * face.normal < 0)
+            flipped[f / 8] |= static_cast<uint8_t>(1 << (f % 8));
+    }
+
+    vertices.shrink_to_fit();
+    edges.shrink_to_fit();
+    colors.shrink_to_fit();
+    faces.shrink_to_fit();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+Solid3d CompressedIteration::get_shape() const {
+    if (symmetric_shape)
+        return symmetric_shape -> expand();
+
+    std::vector<Vector3d> points;
+    points.reserve(vertex_count);
+    const uint8_t *in = vertices.data();
+    int64_t x = 0, y = 0, z = 0;
+    for (uint32_t i = 0; i < vertex_count; ++i) {
+        x += getSigned(in);
+        y += getSigned(in);
+        z += getSigned(in);
+        points.emplace_back(origin.get<0>() + x * step, origin.get<1>() + y * step, origin.get<2>() + z * step);
+    }
+
+    Solid3d shape;
+    shape.edges.reserve(edge_count);
+    in = edges.data();
+    const uint8_t *color_in = colors.data();
+    int64_t index = 0;
+    uint64_t run = 0;
+    sf::Color color;
+
+    auto next_end = [&]() {
+        index += getSigned(in);
+        if (run == 0) {
+            run = getVarint(color_in);
+            color = sf::Color(color_in[0], color_in[1], color_in[2], color_in[3]);
+            color_in += 4;
+        }
+        run--;
+        return Vector3d(points[static_cast<size_t>(index)], color);
+    };
+
+    for (uint32_t e = 0; e < edge_count; ++e) {
+        const Vector3d a = next_end();
+        const Vector3d b = next_end();
+        shape.edges.emplace_back(a, b);
+    }
+
+    shape.faces.reserve(face_count);
+    in = faces.data();
+    int64_t edge = 0;
+    for (uint32_t f = 0; f < face_count; ++f) {
+        std::vector<uint32_t> face_edges(getVarint(in));
+        for (auto &face_edge : face_edges) {
+            edge += getSigned(in);
+            face_edge = static_cast<uint32_t>(edge);
+        }
+
+        shape.faces.emplace_back(shape.edges, face_edges);
+        if (flipped[f / 8] & (1 << (f % 8))) {
+            const Vector3d inward = shape.faces.back().normal * -1.0;
+            shape.faces.back().orient(inward);
+        }
+    }
+
+    return shape;
+}
+
+ExactSolid3d CompressedIteration::get_exact_shape() const {
+    ExactSolid3d exact;
+    exact.shift = lattice_shift;
+
+    exact.vertices.reserve(lattice_vertex_count);
+    const uint8_t *in = lattice_vertices.data();
+    LatticePoint p = {0, 0, 0};
+    for (uint32_t i = 0; i < lattice_vertex_count; ++i) {
+        p.x += getSigned(in);
+        p.y += getSigned(in);
+        p.z += getSigned(in);
+        exact.vertices.push_back(p);
+    }
+
+    exact.edges.reserve(lattice_edge_count);
+    in = lattice_edges.data();
+    int64_t first = 0;
+    for (uint32_t e = 0; e < lattice_edge_count; ++e) {
+        first += getSigned(in);
+        const int64_t second = first + getSigned(in);
+        exact.edges.emplace_back(static_cast<uint32_t>(first), static_cast<uint32_t>(second));
+    }
+
+    return exact;
+}
+
+// the rectifier of the iteration in its mode and spatial order, going on exactly as the original one
+Rectifier CompressedIteration::restore() const {
+    if (mode == Rectifier::MODE::SYMMETRIC)
+        return Rectifier(symmetric_shape, iteration).with_curve(curve);
+    if (mode == Rectifier::MODE::EXACT)
+        return Rectifier(get_shape(), get_exact_shape(), iteration).with_curve(curve);
+
+    return Rectifier(get_shape(), mode, iteration).with_curve(curve);
+}
+
+// the symmetric representatives are shared with the rectifier they come from, counted here anyway
+size_t CompressedIteration::get_memory_usage() const {
+    return sizeof(CompressedIteration) + vertices.capacity() + edges.capacity() + colors.capacity() + faces.capacity() + flipped.capacity()
+         + lattice_vertices.capacity() + lattice_edges.capacity() + (symmetric_shape ? symmetric_shape -> get_memory_usage() : 0);
+}
+
+// the iteration replaces an older copy of itself, it always stays even alone over max_bytes
+void IterationHistory::store(const Rectifier &rectifier) {
+    std::shared_ptr<const CompressedIteration> compressed = std::make_shared<const CompressedIteration>(rectifier);
+    const unsigned iteration = compressed -> get_iteration();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<const CompressedIteration> &slot = iterations[iteration];
+    if (slot)
+        bytes -= slot -> get_memory_usage();
+    slot = compressed;
+    bytes += compressed -> get_memory_usage();
+
+    while (bytes > max_bytes && iterations.size() > 1) {
+        const auto first = iterations.begin();
+        const auto last = std::prev(iterations.end());
+        const auto dropped = iteration - first -> first >= last -> first - iteration ? first : last;
+        bytes -= dropped -> second -> get_memory_usage();
+        iterations.erase(dropped);
+    }
+}
+
+// nullptr if the iteration was never stored or has been dropped
+std::shared_ptr<const CompressedIteration> IterationHistory::find(const unsigned iteration) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto found = iterations.find(iteration);
+    return found == iterations.end() ? nullptr : found -> second;
+}
+
+size_t IterationHistory::get_memory_usage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
@@ -0,0 +1,75 @@
+#ifndef ITERATIONHISTORY_HPP
+#define ITERATIONHISTORY_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "rectification.hpp"
+
+#define HISTORY_COORDINATE_BITS 24           // vertices are rounded on a grid of 2^24 steps across the shape
+#define HISTORY_MAX_BYTES       (256u << 20) // compressed iterations kept, the farthest ones are dropped beyond
+
+// one iteration stored compactly, several times smaller than its Solid3d:
+//    - vertices welded, numbered in the order the edges reach them, rounded on a grid over
+//      their bounding box and stored as the difference to the previous vertex
+//    - edge ends and face edges as the difference to the previous index
+//    - all of them as zigzag varints, the colors of the edge ends as runs
+// the restored shape has the same vertices, edges and faces, each vertex within half a
+// grid step of the original one. The next iterations are computed from the exact lattice
+// (stored the same way, with its shift) or from the representatives of a symmetric iteration
+// (kept as they are, they are already small), so that they do not depend on the rounding
+class CompressedIteration {
+private:
+    Rectifier::MODE mode;
+    Solid3d::CURVE curve;
+    unsigned iteration;
+    Vector3d origin;
+    double step;
+    uint32_t vertex_count, edge_count, face_count;
+    std::vector<uint8_t> vertices, edges, colors, faces;
+    std::vector<uint8_t> flipped; // one bit per face, its normal is against the order of its edges
+    int lattice_shift;
+    uint32_t lattice_vertex_count, lattice_edge_count;
+    std::vector<uint8_t> lattice_vertices, lattice_edges;
+    std::shared_ptr<const SymmetricSolid3d> symmetric_shape;
+
+    ExactSolid3d get_exact_shape() const;
+
+public:
+    // constructors
+    explicit CompressedIteration(const Rectifier &rectifier);
+
+    // others
+    unsigned get_iteration() const { return iteration; }
+    Solid3d get_shape() const;
+    Rectifier restore() const;
+    size_t get_memory_usage() const;
+};
+
+// the iterations met in the window, so that stepping back and forth only decompresses
+// them; store() compresses on the calling thread (a background task of the scheduler)
+// and drops the iterations farthest from the new one once max_bytes is exceeded
+class IterationHistory {
+private:
+    std::map<unsigned, std::shared_ptr<const CompressedIteration>> iterations;
+    mutable std::mutex mutex; // stores run on the scheduler while the main loop looks iterations up
+    size_t bytes;
+    const size_t max_bytes;
+
+public:
+    // constructors
+    explicit IterationHistory(const size_t _max_bytes = HISTORY_MAX_BYTES) : bytes(0), max_bytes(_max_bytes) {}
+    IterationHistory(const IterationHistory &) = delete;
+
+    // operators
+    IterationHistory& operator=(const IterationHistory &) = delete;
+
+    // others
+    void store(const Rectifier &rectifier);
+    std::shared_ptr<const CompressedIteration> find(const unsigned iteration) const;
+    size_t get_memory_usage() const;
+};
+
+#endif
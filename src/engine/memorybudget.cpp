@@ -0,0 +1,36 @@
+#include "memorybudget.hpp"
+#include "../utils/memory.hpp"
+
+static std::string toMegabytes(const size_t bytes) {
+  return std::to_string((bytes + (1 << 20) - 1) >> 20) + " MB";
+}
+
+bool fitMemoryBudget(Rectifier &rectifier, size_t budget, std::string &message, const bool preview) {
+  const size_t used = get_memory_usage();
+  if (budget == 0) {
+    budget = used + get_available_memory();
+  }
+  if (budget == used) {
+    return true; // nothing known about the system
+  }
+
+  const size_t estimate = rectifier.estimate_next_memory(rectifier.get_mode(), preview);
+  if (used + estimate <= budget) {
+    return true;
+  }
+
+  // the lattice shapes have no faces and a compact representation
+  if (rectifier.get_mode() == Rectifier::MODE::DEFAULT) {
+    const size_t exactEstimate = rectifier.estimate_next_memory(Rectifier::MODE::EXACT, preview);
+    if (used + exactEstimate <= budget) {
+      rectifier = rectifier.with_mode(Rectifier::MODE::EXACT);
+      message = "iteration " + std::to_string(rectifier.get_iteration() + 1) + " needs about " + toMegabytes(used + estimate)
+              + ", over the budget of " + toMegabytes(budget) + ": switching to exact mode (" + toMegabytes(used + exactEstimate) + ")";
+      return true;
+    }
+  }
+
+  message = "iteration " + std::to_string(rectifier.get_iteration() + 1) + " needs about " + toMegabytes(used + estimate)
+          + ", over the budget of " + toMegabytes(budget) + ": not computed";
+  return false;
+}
@@ -0,0 +1,15 @@
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <string>
+#include "rectification.hpp"
+
+// checks before an iteration that the resident memory of the process plus the estimated
+// peak of the next iteration stays under budget bytes (0: what the system has available):
+//    - true if it fits in the mode of rectifier
+//    - true if it fits in exact mode, rectifier is switched to it and message says so
+//    - false otherwise, message says why
+// preview counts the copy of the next shape drawn while it grows, see ShapeProgress
+bool fitMemoryBudget(Rectifier &rectifier, size_t budget, std::string &message, const bool preview = false);
+
+#endif
@@ -0,0 +1,310 @@
+#include "options.hpp"
+#include "../geometry/geometry.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+void printUsage(std::ostream &os, const char *executable) {
+  os << "usage: " << executable << " [options]\n"
+     << "  --seed NAME       starting shape: tetrahedron (default), cube or an .obj/.ply file\n"
+     << "  --mode MODE       rectification: default, exact or symmetric\n"
+     << "  --batch N         no window, compute N iterations and print one JSON line per iteration\n"
+     << "  --figure on|off   with --batch, time the projection of a close-up view of every iteration\n"
+     << "                    and count its cache misses (default: off)\n"
+     << "  --predict N       print the statistics of iterations 0 to N from the vertex degrees and face sizes\n"
+     << "                    alone, in the JSON of --batch, without computing any shape\n"
+     << "  --export FORMAT   with --batch, write every iteration as obj or ply\n"
+     << "  --output PREFIX   exported files are PREFIX_<iteration>.<format> (default: shape)\n"
+     << "  --gallery N       draw N instances of the current shape sharing the same geometry\n"
+     << "  --memory-budget MB  iterations that would not fit are computed in exact mode or refused\n"
+     << "                    (default: the memory available on the system)\n"
+     << "  --adaptive N      refine the regions in view and near the camera up to N iterations,\n"
+     << "                    the rest stays coarser (default mode only, Space adds one iteration)\n"
+     << "  --record FILE     write the input of every frame to FILE\n"
+     << "  --replay FILE     play the input of FILE back without frame cap nor vsync, then print the frame times\n"
+     << "  --spatial-order CURVE  sort the edges of every new shape along a morton or hilbert curve\n"
+     << "                    (default: none, the order of the rectification)\n"
+     << "  --quality MODE    adaptive (default): fewer edges, less antialiasing, a lower resolution or an older\n"
+     << "                    iteration while the frames are late, fixed: always the full detail\n"
+     << "  --simplify EDGES  draw the shapes of more edges from a copy simplified to EDGES edges in the background,\n"
+     << "                    with --batch report its time and error (export and statistics keep the full shape)\n"
+     << "  --simplify-error FRACTION  stop the simplification before it moves the shape by more than FRACTION\n"
+     << "                    of its radius, alone it simplifies every shape as far as that bound allows\n"
+     << "  --share NAME      publish the current mesh and every frame in the POSIX shared memory object /NAME\n"
+     << "                    for other processes of the host (layout in src/engine/sharedlayout.hpp)\n"
+     << "  --serve PATH      no window, answer stats and mesh requests of local tools on the Unix domain\n"
+     << "                    socket PATH until interrupted (protocol in src/engine/rectificationserver.hpp)\n"
+     << "  --processes N     with --mode exact, split every iteration by spatial region among N worker processes\n"
+     << "                    (frames in src/engine/distributedrectifier.hpp), the shapes are the same\n"
+     << "  --worker stdio    run as a worker of --processes, reading regions on stdin and answering on stdout\n"
+     << "  --help            print this message\n";
+}
+
+// value of option as a whole decimal number not above max, false and printed on std::cerr otherwise
+template <typename T>
+static bool parseNumber(const char *option, const char *value, T &number, const uint64_t max = std::numeric_limits<T>::max()) {
+  char *end;
+  errno = 0;
+  // strtoull() would accept leading spaces and a minus sign, negating the number
+  const unsigned long long parsed = (*value >= '0' && *value <= '9') ? strtoull(value, &end, 10) : 0;
+  if (*value < '0' || *value > '9' || errno == ERANGE || *end != '\0' || parsed > max) {
+    std::cerr << "invalid value for " << option << ": " << value << std::endl;
+    return false;
+  }
+
+  number = static_cast<T>(parsed);
+  return true;
+}
+
+// value of option as a positive finite decimal number, false and printed on std::cerr otherwise
+static bool parsePositive(const char *option, const char *value, double &number) {
+  char *end;
+  errno = 0;
+  // strtod() would accept leading spaces, a sign, "inf", "nan" and hexadecimal numbers
+  const bool decimal = ((*value >= '0' && *value <= '9') || *value == '.') && value[strspn(value, "0123456789.eE+-")] == '\0';
+  const double parsed = decimal ? strtod(value, &end) : 0.0;
+  if (!decimal || errno == ERANGE || *end != '\0' || !std::isfinite(parsed) || !(parsed > 0)) {
+    std::cerr << "invalid value for " << option << ": " << value << std::endl;
+    return false;
+  }
+
+  number = parsed;
+  return true;
+}
+
+static bool isMeshFile(const std::string &name) {
+  return name.size() > 4 && (name.compare(name.size() - 4, 4, ".obj") == 0 || name.compare(name.size() - 4, 4, ".ply") == 0);
+}
+
+bool getSeed(const std::string &name, Solid3d &seed) {
+  if (name == "tetrahedron") {
+    seed = Tetrahedron3d(200);
+  }
+  else if (name == "cube") {
+    seed = Cube3d(Vector3d(), 200);
+    for (auto& edge : seed.edges) {
+      edge.a.set_color(sf::Color::White);
+      edge.b.set_color(sf::Color::White);
+    }
+  }
+  else if (isMeshFile(name)) {
+    std::string error;
+    if (!MeshIO::read(name, seed, error)) {
+      std::cerr << name << ": " << error << std::endl;
+      return false;
+    }
+  }
+  else {
+    return false;
+  }
+
+  return true;
+}
+
+// returns false and prints why on std::cerr if the command line is not valid
+bool parseOptions(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; i++) {
+    const char *option = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+    if (!strcmp(option, "--help")) {
+      printUsage(std::cout, argv[0]);
+      exit(EXIT_SUCCESS);
+    }
+
+    if (!value && (!strcmp(option, "--seed") || !strcmp(option, "--mode") || !strcmp(option, "--batch") || !strcmp(option, "--figure") || !strcmp(option, "--predict") || !strcmp(option, "--export") || !strcmp(option, "--output") || !strcmp(option, "--gallery") || !strcmp(option, "--record") || !strcmp(option, "--replay") || !strcmp(option, "--memory-budget") || !strcmp(option, "--adaptive") || !strcmp(option, "--share") || !strcmp(option, "--spatial-order") || !strcmp(option, "--quality") || !strcmp(option, "--serve") || !strcmp(option, "--simplify") || !strcmp(option, "--simplify-error") || !strcmp(option, "--processes") || !strcmp(option, "--worker"))) {
+      std::cerr << "missing value for " << option << std::endl;
+      return false;
+    }
+    i++;
+
+    if (!strcmp(option, "--seed")) {
+      options.seed = value;
+    }
+    else if (!strcmp(option, "--mode")) {
+      if (!strcmp(value, "default")) {
+        options.mode = Rectifier::MODE::DEFAULT;
+      }
+      else if (!strcmp(value, "exact")) {
+        options.mode = Rectifier::MODE::EXACT;
+      }
+      else if (!strcmp(value, "symmetric")) {
+        options.mode = Rectifier::MODE::SYMMETRIC;
+      }
+      else {
+        std::cerr << "unknown mode: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--batch")) {
+      options.batch = true;
+      if (!parseNumber(option, value, options.iterations)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--figure")) {
+      if (!strcmp(value, "on")) {
+        options.figure = true;
+      }
+      else if (!strcmp(value, "off")) {
+        options.figure = false;
+      }
+      else {
+        std::cerr << "unknown figure measurement: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--predict")) {
+      if (!parseNumber(option, value, options.predict)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--export")) {
+      options.do_export = true;
+      if (!strcmp(value, "obj")) {
+        options.format = MeshIO::FORMAT::OBJ;
+      }
+      else if (!strcmp(value, "ply")) {
+        options.format = MeshIO::FORMAT::PLY;
+      }
+      else {
+        std::cerr << "unknown export format: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--output")) {
+      options.output = value;
+    }
+    else if (!strcmp(option, "--gallery")) {
+      if (!parseNumber(option, value, options.gallery)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--record")) {
+      options.record = value;
+    }
+    else if (!strcmp(option, "--replay")) {
+      options.replay = value;
+    }
+    else if (!strcmp(option, "--memory-budget")) {
+      // megabytes, the bytes must fit in a size_t
+      if (!parseNumber(option, value, options.memory_budget, std::numeric_limits<size_t>::max() >> 20)) {
+        return false;
+      }
+      options.memory_budget <<= 20;
+    }
+    else if (!strcmp(option, "--adaptive")) {
+      if (!parseNumber(option, value, options.adaptive)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--share")) {
+      options.share = value;
+    }
+    else if (!strcmp(option, "--spatial-order")) {
+      if (!strcmp(value, "none")) {
+        options.curve = Solid3d::CURVE::NONE;
+      }
+      else if (!strcmp(value, "morton")) {
+        options.curve = Solid3d::CURVE::MORTON;
+      }
+      else if (!strcmp(value, "hilbert")) {
+        options.curve = Solid3d::CURVE::HILBERT;
+      }
+      else {
+        std::cerr << "unknown spatial order: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--serve")) {
+      options.serve = value;
+    }
+    else if (!strcmp(option, "--simplify")) {
+      if (!parseNumber(option, value, options.simplify)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--simplify-error")) {
+      if (!parsePositive(option, value, options.simplify_error)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--processes")) {
+      if (!parseNumber(option, value, options.processes)) {
+        return false;
+      }
+    }
+    else if (!strcmp(option, "--worker")) {
+      if (strcmp(value, "stdio")) {
+        std::cerr << "unknown worker transport: " << value << std::endl;
+        return false;
+      }
+      options.worker = value;
+    }
+    else if (!strcmp(option, "--quality")) {
+      if (!strcmp(value, "adaptive")) {
+        options.adaptive_quality = true;
+      }
+      else if (!strcmp(value, "fixed")) {
+        options.adaptive_quality = false;
+      }
+      else {
+        std::cerr << "unknown quality: " << value << std::endl;
+        return false;
+      }
+    }
+    else {
+      std::cerr << "unknown option: " << option << std::endl;
+      return false;
+    }
+  }
+
+  if (!options.record.empty() && !options.replay.empty()) {
+    std::cerr << "--record and --replay cannot be used together" << std::endl;
+    return false;
+  }
+
+  if (options.predict && (options.batch || !options.serve.empty() || options.processes)) {
+    std::cerr << "--predict cannot be used with --batch, --serve nor --processes" << std::endl;
+    return false;
+  }
+
+  if (options.figure && !options.batch) {
+    std::cerr << "--figure needs --batch" << std::endl;
+    return false;
+  }
+
+  if (!options.share.empty() && options.batch) {
+    std::cerr << "--share needs a window" << std::endl;
+    return false;
+  }
+
+  if (!options.serve.empty() && (options.batch || !options.share.empty())) {
+    std::cerr << "--serve cannot be used with --batch nor --share" << std::endl;
+    return false;
+  }
+
+  if (options.adaptive && (options.batch || options.gallery || options.mode != Rectifier::MODE::DEFAULT)) {
+    std::cerr << "--adaptive needs a window and cannot be used with --gallery nor another mode" << std::endl;
+    return false;
+  }
+
+  if ((options.simplify || options.simplify_error > 0) && (options.adaptive || !options.serve.empty())) {
+    std::cerr << "--simplify and --simplify-error cannot be used with --adaptive nor --serve" << std::endl;
+    return false;
+  }
+
+  if (options.processes && (options.mode != Rectifier::MODE::EXACT || options.adaptive || !options.serve.empty())) {
+    std::cerr << "--processes needs --mode exact and cannot be used with --adaptive nor --serve" << std::endl;
+    return false;
+  }
+
+  // file seeds are only loaded once by getSeed()
+  if (options.seed != "tetrahedron" && options.seed != "cube" && !isMeshFile(options.seed)) {
+    std::cerr << "invalid seed: " << options.seed << std::endl;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,56 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <string>
+#include "rectification.hpp"
+#include "../geometry/meshio.hpp"
+
+// command line of the 3D-engine executable
+struct Options {
+    std::string seed;           // "tetrahedron", "cube" or the path of an .obj or .ply file
+    Rectifier::MODE mode;
+    bool batch;                 // no window: run iterations and print their statistics
+    bool figure;                // batch: time the projection of a close-up view of every iteration
+    unsigned iterations;
+    unsigned predict;           // last iteration whose statistics are predicted without geometry, 0 when off
+    bool do_export;
+    MeshIO::FORMAT format;
+    std::string output;         // exported files are <output>_<iteration>.<format>
+    unsigned gallery;           // number of instances of the current shape drawn side by side, 0 for a single one
+    std::string record;         // file receiving the input of every frame
+    std::string replay;         // file of recorded input played back without frame cap
+    size_t memory_budget;       // bytes, 0 for the memory available on the system
+    unsigned adaptive;          // depth of the view-dependent refinement, 0 when off
+    std::string share;          // name of the shared memory object receiving the mesh and the frames, empty when off
+    Solid3d::CURVE curve;       // order of the edges of every new shape
+    bool adaptive_quality;      // lower the detail drawn when the frames get late, see QualityController
+    std::string serve;          // path of the Unix domain socket of the rectification server, empty when off
+    size_t simplify;            // shapes with more edges are drawn from a copy simplified to that many, 0 when off
+    double simplify_error;      // largest move of the simplification, relative to the radius of the shape, 0 for no bound
+    unsigned processes;         // worker processes computing the exact iterations, 0 to compute them in this process
+    std::string worker;         // transport of a worker process ("stdio"), empty for the engine itself
+
+    Options() : seed("tetrahedron"),
+                mode(Rectifier::MODE::DEFAULT),
+                batch(false),
+                figure(false),
+                iterations(0),
+                predict(0),
+                do_export(false),
+                format(MeshIO::FORMAT::OBJ),
+                output("shape"),
+                gallery(0),
+                memory_budget(0),
+                adaptive(0),
+                curve(Solid3d::CURVE::NONE),
+                adaptive_quality(true),
+                simplify(0),
+                simplify_error(0.0),
+                processes(0) {}
+};
+
+bool parseOptions(int argc, char *argv[], Options &options);
+void printUsage(std::ostream &os, const char *executable);
+bool getSeed(const std::string &name, Solid3d &seed);
+
+#endif
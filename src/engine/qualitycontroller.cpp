@@ -0,0 +1,140 @@
+#include "qualitycontroller.hpp"
+#include <algorithm>
+#include <sstream>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+QualityController::QualityController(const unsigned _max_antialiasing, const double _target) : target(_target), max_antialiasing(_max_antialiasing), max_fallback(0), frame_time(0.0), work_time(0.0), samples(0), settle(QUALITY_SETTLE_FRAMES), headroom(0), raise_frames(QUALITY_RAISE_FRAMES), since_raise(QUALITY_RAISE_FRAMES) {
+    settings.edge_ratio   = 1.0;
+    settings.antialiasing = max_antialiasing;
+    settings.resolution   = 1.0;
+    settings.fallback     = 0;
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// one step down, false if every knob is at its coarsest already
+bool QualityController::lower() {
+    Settings &s = settings;
+
+    // late in the display: the knobs of the offscreen target first
+    if (work_time <= 0.75 * target) {
+        if (s.antialiasing > 0) {
+            s.antialiasing /= 2;
+            return true;
+        }
+        if (s.resolution > QUALITY_MIN_RESOLUTION) {
+            s.resolution = std::max(QUALITY_MIN_RESOLUTION, s.resolution - 0.25);
+            return true;
+        }
+    }
+
+    if (s.edge_ratio <= QUALITY_MIN_EDGE_RATIO && s.fallback >= max_fallback)
+        return false;
+
+    // the projection time is about proportional to the edges drawn
+    s.edge_ratio *= std::min(0.9, std::max(0.5, 0.75 * target / work_time));
+    if (s.edge_ratio < QUALITY_MIN_EDGE_RATIO) {
+        if (s.fallback < max_fallback) {
+            // the previous iteration has half as many edges
+            s.fallback++;
+            s.edge_ratio = std::min(1.0, 2 * s.edge_ratio);
+        }
+        else
+            s.edge_ratio = QUALITY_MIN_EDGE_RATIO;
+    }
+
+    return true;
+}
+
+// one step up, false if every knob is at its finest already
+bool QualityController::raise() {
+    Settings &s = settings;
+
+    if (s.fallback > 0 && s.edge_ratio >= 2 * QUALITY_MIN_EDGE_RATIO) {
+        // as many edges, taken from the finer iteration
+        s.fallback--;
+        s.edge_ratio /= 2;
+    }
+    else if (s.edge_ratio < 1.0)
+        s.edge_ratio = std::min(1.0, s.edge_ratio * std::min(2.0, std::max(1.25, 0.6 * target / work_time)));
+    else if (s.resolution < 1.0)
+        s.resolution = std::min(1.0, s.resolution + 0.25);
+    else if (s.antialiasing < max_antialiasing)
+        s.antialiasing = std::min(max_antialiasing, std::max(1u, 2 * s.antialiasing));
+    else
+        return false;
+
+    return true;
+}
+
+// frame and work: ms of the last frame, returns true if the settings changed
+bool QualityController::update(const double frame, const double work) {
+    since_raise = std::min(since_raise + 1, 16u * QUALITY_RAISE_FRAMES);
+    if (settle > 0) {
+        settle--;
+        return false;
+    }
+
+    frame_time = samples == 0 ? frame : frame_time + QUALITY_SMOOTHING * (frame - frame_time);
+    work_time  = samples == 0 ? work  : work_time  + QUALITY_SMOOTHING * (work - work_time);
+    samples++;
+
+    bool changed = false;
+    if (frame_time > 1.1 * target || work_time > 0.9 * target) {
+        headroom = 0;
+        changed = lower();
+        if (changed)
+            raise_frames = since_raise < QUALITY_RAISE_FRAMES ? std::min(2 * raise_frames, 16u * QUALITY_RAISE_FRAMES) : QUALITY_RAISE_FRAMES;
+    }
+    else if (frame_time < 1.05 * target && work_time < 0.5 * target) {
+        if (++headroom >= raise_frames) {
+            headroom = 0;
+            changed = raise();
+            if (changed)
+                since_raise = 0;
+        }
+    }
+    else
+        headroom = 0;
+
+    if (changed) {
+        samples = 0;
+        settle = QUALITY_SETTLE_FRAMES;
+    }
+
+    return changed;
+}
+
+// the iterations below the current one that can be drawn instead of it, 0 when the shape
+// has no older iteration at hand
+void QualityController::set_max_fallback(const unsigned _max_fallback) {
+    max_fallback = std::min(_max_fallback, static_cast<unsigned>(QUALITY_MAX_FALLBACK));
+    settings.fallback = std::min(settings.fallback, max_fallback);
+}
+
+bool QualityController::is_finest() const {
+    return settings.edge_ratio >= 1.0 && settings.antialiasing >= max_antialiasing && settings.resolution >= 1.0 && settings.fallback == 0;
+}
+
+// the knobs below their finest setting, for the window
+std::string QualityController::get_description() const {
+    std::ostringstream description;
+    description << "Reduced quality:";
+
+    if (settings.fallback > 0)
+        description << " iteration -" << settings.fallback;
+    if (settings.edge_ratio < 1.0)
+        description << " " << static_cast<int>(100 * settings.edge_ratio + 0.5) << "% of the edges";
+    if (settings.resolution < 1.0)
+        description << " resolution " << static_cast<int>(100 * settings.resolution + 0.5) << "%";
+    if (settings.antialiasing < max_antialiasing)
+        description << " antialiasing x" << settings.antialiasing;
+
+    return description.str();
+}
@@ -0,0 +1,61 @@
+#ifndef QUALITYCONTROLLER_HPP
+#define QUALITYCONTROLLER_HPP
+
+#include <string>
+#include "../utils/parameters.hpp"
+
+#define QUALITY_MIN_EDGE_RATIO 0.25 // below, an older iteration is drawn instead
+#define QUALITY_MAX_FALLBACK   3    // iterations below the current one at most
+#define QUALITY_MIN_RESOLUTION 0.5  // of the offscreen target, lowered by steps of 0.25
+#define QUALITY_SETTLE_FRAMES  4    // frames ignored after a change, until it shows in the measures
+#define QUALITY_RAISE_FRAMES   60   // frames with headroom before raising, doubled when a raise is undone
+#define QUALITY_SMOOTHING      0.25 // weight of the newest frame in the moving averages
+
+// feedback loop holding the frame time under target (MAX_MAIN_LOOP_DURATION) at the finest
+// detail possible, fed every frame with
+//    - the frame time: the whole main loop, display included
+//    - the work time: what the engine itself spends (events, clipping and projection), the
+//      display and its vsync wait excluded
+// a late frame whose work time is most of the budget draws fewer edges, the edge ratio being
+// scaled by the time missing, then an older iteration with twice its edge ratio; a frame late
+// in the display (fill rate) halves the antialiasing, then shrinks the offscreen target the
+// figure is drawn in, before dropping edges too. Once the budget has been held with headroom
+// for QUALITY_RAISE_FRAMES frames, the knobs go back one step in the reverse order; a raise
+// undone at once doubles the wait before the next one, so the controller does not oscillate
+class QualityController {
+public:
+    struct Settings {
+        double edge_ratio;     // fraction of the edges drawn, see Solid3d::get_edge_threshold()
+        unsigned antialiasing; // level of the target the figure is drawn in
+        double resolution;     // size of that target relative to the window
+        unsigned fallback;     // the shape drawn is that many iterations below the current one
+    };
+
+private:
+    const double target;             // ms per frame
+    const unsigned max_antialiasing; // the finest level: that of the window
+    unsigned max_fallback;           // iterations available below the current one
+    Settings settings;
+    double frame_time, work_time;    // moving averages of the frames since the last change, ms
+    unsigned samples;                // frames in the averages
+    unsigned settle;                 // frames left to ignore
+    unsigned headroom;               // consecutive frames with headroom
+    unsigned raise_frames;           // of headroom needed before the next raise
+    unsigned since_raise;            // frames since the last raise
+
+    bool lower();
+    bool raise();
+
+public:
+    // constructors
+    explicit QualityController(const unsigned _max_antialiasing, const double _target = MAX_MAIN_LOOP_DURATION);
+
+    // others
+    bool update(const double frame, const double work);
+    void set_max_fallback(const unsigned _max_fallback);
+    const Settings& get_settings() const { return settings; }
+    bool is_finest() const;
+    std::string get_description() const;
+};
+
+#endif
@@ -0,0 +1,594 @@
+#include "rectification.hpp"
+#include "distributedrectifier.hpp"
+#include "../utils/scheduler.hpp"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+std::string getStats(const Solid3d& shape) {
+  std::string stats;
+
+  size_t faces, edges, vertices;
+  std::map<Vector3d, size_t> edgesPerVertex;
+  
+  edges = shape.edges.size();
+  for (const Segment3d& edge : shape.edges) {
+    edgesPerVertex[edge.a]++;
+    edgesPerVertex[edge.b]++;
+  }
+  vertices = edgesPerVertex.size();
+  faces = shape.faces.empty() ? edges - vertices + 2 : shape.faces.size();
+
+  std::map<size_t, size_t> edgesPerVertexOccurences;
+  for (const auto& vertex : edgesPerVertex) {
+    edgesPerVertexOccurences[vertex.second]++;
+  }
+
+  stats += "# of faces: " + std::to_string(faces) + "\n";
+  stats += "# of edges: " + std::to_string(edges) + "\n";
+  stats += "# of vertices: " + std::to_string(vertices) + "\n";
+  stats += "Edges per vertex:\n";
+  for (const auto& edgesCount : edgesPerVertexOccurences) {
+    stats += "\t" + std::to_string(edgesCount.first) + " edges: " + std::to_string(edgesCount.second) + " occurences\n";
+  }
+
+  return stats;
+}
+
+// order points to be connected in correct order to create polygon
+// swap(i, j) follows the swaps of midpoints[i] and midpoints[j]
+template <typename Swap>
+static void orderPolygon(std::vector<Vector3d>& midpoints, Swap swap) {
+  for (size_t i = 0; i < midpoints.size() - 1; i++) {
+    size_t nextVertex = i + 1;
+    double length = (midpoints[i] - midpoints[nextVertex]).norm();
+
+    for (size_t j = i + 2; j < midpoints.size(); j++) {
+      double currentLength = (midpoints[i] - midpoints[j]).norm();
+      if (currentLength < length) {
+        nextVertex = j;
+        length = currentLength;
+      }
+    }
+
+    if (nextVertex != i + 1) {
+      std::swap(midpoints[i + 1], midpoints[nextVertex]);
+      swap(i + 1, nextVertex);
+    }
+  }
+}
+
+void orderPolygon(std::vector<Vector3d>& midpoints) {
+  orderPolygon(midpoints, [](const size_t, const size_t) {});
+}
+
+// rectification of a shape whose faces are known: face F becomes the polygon joining
+// the midpoints of its consecutive edges, with the same normal, and vertex v becomes
+// the polygon of the new edges between two edges of v, chained through shared midpoints
+static Solid3d getNextShapeWithFaces(const Solid3d& shape, const std::atomic_bool& cancel, ShapeProgress* progress) {
+  // new edge joining the midpoints of the old edges e and f around an old vertex
+  struct Corner { uint32_t edge, e, f; };
+
+  std::vector<Vector3d> midpoints(shape.edges.size());
+  for (size_t i = 0; i < shape.edges.size(); i++) {
+    midpoints[i] = (shape.edges[i].a + shape.edges[i].b) * 0.5;
+    midpoints[i].set_color(sf::Color::White);
+  }
+
+  // a closed shape has E - F + 2 vertices, each one becoming a face, and every edge
+  // is shared by two faces
+  Solid3d nextShape;
+  nextShape.edges.reserve(2 * shape.edges.size());
+  nextShape.faces.reserve(shape.edges.size() + 2);
+  std::map<Vector3d, std::vector<Corner>> corners;
+  std::vector<Segment3d> batch;
+  for (const Face3d& face : shape.faces) {
+    if (cancel) {
+      return shape;
+    }
+
+    std::vector<uint32_t> faceEdges;
+    for (size_t k = 0; k < face.edges.size(); k++) {
+      uint32_t e = face.edges[k], f = face.edges[(k + 1) % face.edges.size()];
+      uint32_t edge = static_cast<uint32_t>(nextShape.edges.size());
+
+      nextShape.add_segment(Segment3d(midpoints[e], midpoints[f]));
+      if (progress) {
+        batch.push_back(nextShape.edges.back());
+      }
+      faceEdges.push_back(edge);
+      corners[Face3d::get_shared_vertex(shape.edges[e], shape.edges[f])].push_back({edge, e, f});
+    }
+
+    Face3d nextFace(nextShape.edges, faceEdges);
+    nextFace.orient(face.normal);
+    nextShape.add_face(nextFace);
+    publishEdges(progress, batch);
+  }
+  publishEdges(progress, batch, true);
+
+  for (auto& vertex : corners) {
+    if (cancel) {
+      return shape;
+    }
+
+    // chain the corners so that consecutive new edges share a midpoint
+    std::vector<Corner>& ring = vertex.second;
+    uint32_t shared = ring[0].f;
+    for (size_t i = 1; i < ring.size(); i++) {
+      for (size_t j = i; j < ring.size(); j++) {
+        if (ring[j].e == shared || ring[j].f == shared) {
+          std::swap(ring[i], ring[j]);
+          break;
+        }
+      }
+      shared = ring[i].e == shared ? ring[i].f : ring[i].e;
+    }
+
+    std::vector<uint32_t> faceEdges;
+    for (const Corner& corner : ring) {
+      faceEdges.push_back(corner.edge);
+    }
+
+    Face3d nextFace(nextShape.edges, faceEdges);
+    nextFace.orient(vertex.first - nextFace.centroid);
+    nextShape.add_face(nextFace);
+  }
+
+  return nextShape;
+}
+
+Solid3d getNextShape(const Solid3d& shape, const std::atomic_bool& cancel, ShapeProgress* progress) {
+  if (!shape.faces.empty()) {
+    return getNextShapeWithFaces(shape, cancel, progress);
+  }
+
+  std::map<Vector3d, std::vector<Vector3d>> kMap;
+  for (const Segment3d& edge : shape.edges) {
+    if (cancel) {
+      return shape;
+    }
+
+    Vector3d midpoint = (edge.a + edge.b) * 0.5;
+    midpoint.set_color(sf::Color::White);
+    kMap[edge.a].push_back(midpoint);
+    kMap[edge.b].push_back(midpoint);
+  }
+
+  Solid3d nextShape;
+  nextShape.edges.reserve(2 * shape.edges.size());
+  std::vector<Segment3d> batch;
+  for (const auto& vertex : kMap) {
+    if (cancel) {
+      return shape;
+    }
+
+    std::vector<Vector3d> midpoints = vertex.second;
+
+    orderPolygon(midpoints);
+
+    // connect midpoints of vertex
+    for (size_t i = 0; i < midpoints.size(); i++) {
+      Segment3d edge = Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]);
+
+      if (std::find(nextShape.edges.begin(), nextShape.edges.end(), edge) == nextShape.edges.end()) {
+        nextShape.add_segment(Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]));
+        if (progress) {
+          batch.push_back(nextShape.edges.back());
+        }
+      }
+    }
+    publishEdges(progress, batch);
+  }
+  publishEdges(progress, batch, true);
+
+  return nextShape;
+}
+
+void connectMidpoints(std::vector<uint32_t>& midpoints, const LatticePoint* points, std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+  if (midpoints.empty()) {
+    return;
+  }
+
+  auto distance = [&](uint32_t i, uint32_t j) {
+    const LatticePoint& p = points[i];
+    const LatticePoint& q = points[j];
+    double dx = static_cast<double>(p.x - q.x), dy = static_cast<double>(p.y - q.y), dz = static_cast<double>(p.z - q.z);
+    return dx * dx + dy * dy + dz * dz;
+  };
+
+  // order points to be connected in correct order to create polygon
+  for (size_t i = 0; i + 1 < midpoints.size(); i++) {
+    size_t nextVertex = i + 1;
+    double length = distance(midpoints[i], midpoints[nextVertex]);
+
+    for (size_t j = i + 2; j < midpoints.size(); j++) {
+      double currentLength = distance(midpoints[i], midpoints[j]);
+      if (currentLength < length) {
+        nextVertex = j;
+        length = currentLength;
+      }
+    }
+
+    std::swap(midpoints[i + 1], midpoints[nextVertex]);
+  }
+
+  // connect midpoints of vertex, a 2 points polygon is a single edge
+  size_t sides = midpoints.size() == 2 ? 1 : midpoints.size();
+  for (size_t i = 0; i < sides; i++) {
+    edges.push_back(std::make_pair(midpoints[i], midpoints[(i + 1) % midpoints.size()]));
+  }
+}
+
+ExactSolid3d getNextShape(const ExactSolid3d& shape, const std::atomic_bool& cancel, unsigned threads, ShapeProgress* progress) {
+  if (!shape.can_rectify()) {
+    return shape;
+  }
+
+  ExactSolid3d nextShape;
+  nextShape.shift = shape.shift + 1;
+
+  // exact midpoint of edge i at the next scale
+  nextShape.vertices.resize(shape.edges.size());
+  for (size_t i = 0; i < shape.edges.size(); i++) {
+    const LatticePoint& a = shape.vertices[shape.edges[i].first];
+    const LatticePoint& b = shape.vertices[shape.edges[i].second];
+    nextShape.vertices[i] = {a.x + b.x, a.y + b.y, a.z + b.z};
+  }
+
+  // edges incident to each vertex, in compressed rows: incident[offsets[v] .. offsets[v + 1]]
+  std::vector<uint32_t> offsets(shape.vertices.size() + 1, 0);
+  for (const auto& edge : shape.edges) {
+    offsets[edge.first + 1]++;
+    offsets[edge.second + 1]++;
+  }
+  for (size_t v = 0; v < shape.vertices.size(); v++) {
+    offsets[v + 1] += offsets[v];
+  }
+
+  std::vector<uint32_t> incident(offsets.back());
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < shape.edges.size(); i++) {
+    incident[fill[shape.edges[i].first]++] = static_cast<uint32_t>(i);
+    incident[fill[shape.edges[i].second]++] = static_cast<uint32_t>(i);
+  }
+
+  // order the midpoints around each vertex and connect them, every vertex range
+  // writes its own edge list so the concatenation is in vertex order whatever the thread count
+  if (threads == 0) {
+    threads = Scheduler::get().get_concurrency();
+  }
+  threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, shape.vertices.size() / 1024)));
+
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> rangeEdges(threads);
+  auto connect = [&](size_t t) {
+    size_t begin = shape.vertices.size() * t / threads;
+    size_t end = shape.vertices.size() * (t + 1) / threads;
+    std::vector<uint32_t> midpoints;
+    std::vector<Segment3d> batch;
+    size_t published = 0;
+
+    // the range publishes its new edges in real coordinates
+    auto publishRange = [&]() {
+      for (; published < rangeEdges[t].size(); published++) {
+        const auto& edge = rangeEdges[t][published];
+        batch.push_back(Segment3d(nextShape.get_vertex(edge.first), nextShape.get_vertex(edge.second)));
+      }
+      publishEdges(progress, batch, true);
+    };
+
+    for (size_t v = begin; v < end; v++) {
+      if (cancel) {
+        return;
+      }
+
+      midpoints.assign(incident.begin() + offsets[v], incident.begin() + offsets[v + 1]);
+      connectMidpoints(midpoints, nextShape.vertices.data(), rangeEdges[t]);
+
+      if (progress && rangeEdges[t].size() - published >= PROGRESS_BATCH_EDGES) {
+        publishRange();
+      }
+    }
+
+    if (progress) {
+      publishRange();
+    }
+  };
+
+  // background tasks, the ranges left by busy workers are stolen by the idle ones
+  Scheduler::get().parallel_for(0, threads, 1, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      connect(t);
+    }
+  }, Scheduler::PRIORITY::BACKGROUND);
+
+  if (cancel) {
+    return shape;
+  }
+
+  size_t edgeCount = 0;
+  for (const auto& edges : rangeEdges) {
+    edgeCount += edges.size();
+  }
+  nextShape.edges.reserve(edgeCount);
+  for (const auto& edges : rangeEdges) {
+    nextShape.edges.insert(nextShape.edges.end(), edges.begin(), edges.end());
+  }
+
+  return nextShape;
+}
+
+SymmetricSolid3d getNextShape(const SymmetricSolid3d& shape, const std::atomic_bool& cancel, ShapeProgress* progress) {
+  typedef SymmetricSolid3d::VertexCopy VertexCopy;
+  const SymmetryGroup& group = shape.group;
+
+  // vertex i of the next shape is the midpoint of edge i, fixed by the rotations fixing the edge
+  SymmetricSolid3d nextShape;
+  nextShape.group = group;
+  for (size_t i = 0; i < shape.edges.size(); i++) {
+    Vector3d midpoint = (shape.edges[i].a + shape.edges[i].b) * 0.5;
+    midpoint.set_color(sf::Color::White);
+    nextShape.vertices.push_back(midpoint);
+    nextShape.vertex_stabilizers.push_back(shape.stabilizers[i]);
+  }
+
+  // edges reaching each representative vertex: an end of edge i being the copy (v, g) of vertex v,
+  // the rotation g^-1 brings edge i, and its midpoint, to v
+  std::vector<std::vector<VertexCopy>> around(shape.vertices.size());
+  for (uint32_t i = 0; i < shape.edges.size(); i++) {
+    for (const VertexCopy& end : {shape.ends[i].first, shape.ends[i].second}) {
+      around[end.orbit].push_back(VertexCopy{i, static_cast<uint32_t>(group.inverse(end.element))});
+    }
+  }
+
+  std::vector<VertexCopy> polygon;
+  std::vector<Vector3d> midpoints;
+  std::vector<Segment3d> batch;
+  for (size_t v = 0; v < shape.vertices.size(); v++) {
+    if (cancel) {
+      return shape;
+    }
+
+    // the rotations fixing the vertex give the other edges around it, an edge fixed by one of
+    // them is reached twice
+    polygon.clear();
+    midpoints.clear();
+    for (const VertexCopy& reached : around[v]) {
+      SymmetricSolid3d::for_each_element(shape.vertex_stabilizers[v], [&](const size_t s) {
+        const VertexCopy copy = nextShape.get_canonical(VertexCopy{reached.orbit, static_cast<uint32_t>(group.compose(s, reached.element))});
+        if (std::find(polygon.begin(), polygon.end(), copy) == polygon.end()) {
+          polygon.push_back(copy);
+          midpoints.push_back(nextShape.get_position(copy));
+        }
+      });
+    }
+
+    orderPolygon(midpoints, [&](const size_t i, const size_t j) { std::swap(polygon[i], polygon[j]); });
+
+    // connect midpoints of vertex, one edge per orbit of the rotations fixing it
+    const size_t added = nextShape.add_polygon(polygon, shape.vertex_stabilizers[v]);
+    if (progress) {
+      // the whole orbit of the new representatives is drawn
+      for (size_t e = nextShape.edges.size() - added; e < nextShape.edges.size(); e++) {
+        SymmetricSolid3d::for_each_element(nextShape.images[e], [&](const size_t g) {
+          batch.push_back(group.apply(g, nextShape.edges[e]));
+        });
+      }
+    }
+    publishEdges(progress, batch);
+  }
+  publishEdges(progress, batch, true);
+
+  return nextShape;
+}
+
+// ##############################################
+// ### Rectifier ################################
+// ##############################################
+
+// shapes are immutable once shared, their edge clusters are built before
+static std::shared_ptr<const Solid3d> makeShared(Solid3d shape, const Solid3d::CURVE curve = Solid3d::CURVE::NONE) {
+  shape.sort_spatially(curve);
+  shape.build_clusters();
+  return std::make_shared<const Solid3d>(std::move(shape));
+}
+
+Rectifier::Rectifier(const Solid3d &seed, const MODE _mode, const unsigned _iteration) : mode(_mode), curve(Solid3d::CURVE::NONE), iteration(_iteration), shape(makeShared(seed)) {
+  if (mode == MODE::EXACT) {
+    exact_shape = std::make_shared<const ExactSolid3d>(seed);
+  }
+  else if (mode == MODE::SYMMETRIC) {
+    symmetric_shape = std::make_shared<const SymmetricSolid3d>(seed, SymmetryGroup::detect(seed));
+  }
+}
+
+Rectifier::Rectifier(const Solid3d &_shape, const ExactSolid3d &_exact_shape, const unsigned _iteration) : mode(MODE::EXACT), curve(Solid3d::CURVE::NONE), iteration(_iteration), shape(makeShared(_shape)), exact_shape(std::make_shared<const ExactSolid3d>(_exact_shape)) {}
+
+Rectifier::Rectifier(const std::shared_ptr<const SymmetricSolid3d> &_symmetric_shape, const unsigned _iteration) : mode(MODE::SYMMETRIC), curve(Solid3d::CURVE::NONE), iteration(_iteration), expansion(std::make_shared<Expansion>()), symmetric_shape(_symmetric_shape) {}
+
+// returns *this if cancelled (or if the lattice would overflow in exact mode)
+Rectifier Rectifier::get_next(const std::atomic_bool &cancel, ShapeProgress *progress) const {
+  Rectifier next(*this);
+
+  if (mode == MODE::EXACT) {
+    if (!exact_shape->can_rectify()) {
+      return *this;
+    }
+    ExactSolid3d nextShape;
+    std::string error;
+    if (workers && !workers->get_next_shape(*exact_shape, cancel, nextShape, error)) {
+      if (cancel) {
+        return *this;
+      }
+      // the workers are stopped, this iteration and the next ones are computed here
+      std::cerr << "Distributed rectification failed (" << error << "), going on in this process" << std::endl;
+      next.workers.reset();
+    }
+    if (!next.workers) {
+      nextShape = getNextShape(*exact_shape, cancel, 0, progress);
+    }
+    next.exact_shape = std::make_shared<const ExactSolid3d>(std::move(nextShape));
+    next.shape = makeShared(next.exact_shape->to_solid(), curve);
+  }
+  else if (mode == MODE::SYMMETRIC) {
+    // expanded when a full solid is needed only, an iteration stepped through costs its representatives
+    next.symmetric_shape = std::make_shared<const SymmetricSolid3d>(getNextShape(*symmetric_shape, cancel, progress));
+    next.shape.reset();
+    next.expansion = std::make_shared<Expansion>();
+  }
+  else {
+    next.shape = makeShared(getNextShape(*shape, cancel, progress), curve);
+  }
+
+  if (cancel) {
+    return *this;
+  }
+
+  next.iteration++;
+  return next;
+}
+
+// same shapes in another mode, keeping the iteration number: the current shape is the new seed
+Rectifier Rectifier::with_mode(const MODE _mode) const {
+  Rectifier other(*this);
+
+  other.mode = _mode;
+  other.shape = get_shape();
+  other.expansion.reset();
+  other.exact_shape.reset();
+  other.symmetric_shape.reset();
+  if (_mode == MODE::EXACT) {
+    other.exact_shape = std::make_shared<const ExactSolid3d>(*other.shape);
+  }
+  else if (_mode == MODE::SYMMETRIC) {
+    other.symmetric_shape = std::make_shared<const SymmetricSolid3d>(*other.shape, SymmetryGroup::detect(*other.shape));
+  }
+
+  return other;
+}
+
+// same iteration whose shapes are sorted along _curve (see Solid3d::sort_spatially()) from now on,
+// the exact and symmetric representations keep their own order, only the drawn shape is sorted
+Rectifier Rectifier::with_curve(const Solid3d::CURVE _curve) const {
+  Rectifier other(*this);
+
+  other.curve = _curve;
+  if (_curve != curve && expansion) {
+    other.expansion = std::make_shared<Expansion>();
+  }
+  else if (_curve != curve) {
+    other.shape = makeShared(*shape, _curve);
+  }
+
+  return other;
+}
+
+// same iteration whose next exact shapes are computed by _workers (already started), nullptr
+// to compute them in this process again
+Rectifier Rectifier::with_workers(const std::shared_ptr<DistributedRectifier> &_workers) const {
+  Rectifier other(*this);
+
+  other.workers = _workers;
+  return other;
+}
+
+// the symmetric iterations are only expanded here, when they are drawn, exported or counted
+const std::shared_ptr<const Solid3d>& Rectifier::get_shape() const {
+  if (!expansion) {
+    return shape;
+  }
+
+  std::lock_guard<std::mutex> lock(expansion->mutex);
+  if (!expansion->shape) {
+    expansion->shape = makeShared(symmetric_shape->expand(), curve);
+  }
+  return expansion->shape;
+}
+
+// bytes of the shapes of this iteration, a symmetric one counting its full solid once expanded
+size_t Rectifier::get_memory_usage() const {
+  size_t expanded = 0;
+  if (expansion) {
+    std::lock_guard<std::mutex> lock(expansion->mutex);
+    expanded = expansion->shape ? expansion->shape->get_memory_usage() : 0;
+  }
+
+  return (shape ? shape->get_memory_usage() : expanded)
+       + (exact_shape ? exact_shape->get_memory_usage() : 0)
+       + (symmetric_shape ? symmetric_shape->get_memory_usage() : 0);
+}
+
+// bytes of a solid of edges edges and faces faces (if known), see Solid3d::get_memory_usage()
+static size_t getSolidMemory(const size_t edges, const size_t faces) {
+  return edges * sizeof(Segment3d)
+       + (faces ? faces * (sizeof(Face3d) + MEMORY_BLOCK_OVERHEAD) + 2 * edges * sizeof(uint32_t) : 0)
+       + (edges / OCCLUSION_CLUSTER_SIZE + 1) * sizeof(EdgeCluster);
+}
+
+// peak of the bytes allocated by get_next() (with_mode(next_mode) first if the mode changes) while
+// the current shapes are kept, for a closed shape of E edges: the next one has E vertices of
+// degree 4, 2 E edges and E + 2 faces. With preview, the window also keeps a copy of the edges
+// published through a ShapeProgress until the next shape is complete
+size_t Rectifier::estimate_next_memory(const MODE next_mode, const bool preview) const {
+  const bool faces = shape && !shape->faces.empty();
+  const size_t edges = shape ? shape->edges.size() : symmetric_shape->get_edge_count();
+  const size_t vertices = exact_shape ? exact_shape->vertices.size()
+                        : (faces ? edges - shape->faces.size() + 2 : 2 * edges / 3);
+  const size_t order = next_mode == mode ? get_symmetry_order() : 1;
+  const size_t hashNode = sizeof(void*) + MEMORY_BLOCK_OVERHEAD + sizeof(void*); // node and bucket
+
+  size_t bytes = 0;
+
+  if (next_mode == MODE::EXACT) {
+    // conversion of the current shape to the lattice, with its welding table
+    if (mode != MODE::EXACT) {
+      bytes += vertices * (sizeof(LatticePoint) + sizeof(LatticePoint) + sizeof(uint32_t) + hashNode) + edges * 2 * sizeof(uint32_t);
+    }
+
+    // next lattice shape, then either the compressed incidence rows and per range edges or the solid
+    size_t nextLattice = edges * sizeof(LatticePoint) + 2 * edges * 2 * sizeof(uint32_t);
+    size_t temporaries = (2 * vertices + 2 * edges) * sizeof(uint32_t) + 2 * 2 * edges * 2 * sizeof(uint32_t);
+    if (workers) {
+      // with worker processes: the region of every vertex, the request being sent (its vertices
+      // with the overlap, its edges and the local numbering) and the answers kept until stitched,
+      // a side of a polygon for every next edge
+      const size_t processes = std::max(1u, workers->get_processes());
+      temporaries = vertices * sizeof(uint32_t) + 2 * (3 * sizeof(int64_t) * vertices + 3 * sizeof(uint32_t) * edges) / processes
+                  + vertices * sizeof(uint32_t) + 2 * edges * 2 * sizeof(uint32_t);
+    }
+    bytes += nextLattice + std::max(temporaries, getSolidMemory(2 * edges, 0));
+  }
+  else if (next_mode == MODE::SYMMETRIC) {
+    // representatives with their ends and the lists of edges around each vertex, then the
+    // expanded solid with its welding table once drawn
+    size_t representatives = 2 * edges / order;
+    bytes += representatives * (sizeof(Segment3d) + sizeof(std::pair<SymmetricSolid3d::VertexCopy, SymmetricSolid3d::VertexCopy>) + 2 * sizeof(uint64_t))
+           + edges / order * (sizeof(Vector3d) + sizeof(uint64_t))
+           + vertices / order * sizeof(std::vector<SymmetricSolid3d::VertexCopy>) + 2 * edges / order * sizeof(SymmetricSolid3d::VertexCopy)
+           + getSolidMemory(2 * edges, 0) + edges * (sizeof(LatticePoint) + sizeof(Vector3d) + hashNode);
+  }
+  else if (faces) {
+    // midpoints and corners around each vertex, then the solid with its faces
+    bytes += edges * sizeof(Vector3d)
+           + vertices * (sizeof(Vector3d) + sizeof(std::vector<uint32_t>) + MEMORY_NODE_OVERHEAD) + 2 * 2 * edges * 3 * sizeof(uint32_t)
+           + getSolidMemory(2 * edges, edges + 2);
+  }
+  else {
+    // midpoints around each vertex, then the solid
+    bytes += vertices * (sizeof(Vector3d) + sizeof(std::vector<Vector3d>) + MEMORY_NODE_OVERHEAD) + 2 * 2 * edges * sizeof(Vector3d)
+           + getSolidMemory(2 * edges, 0);
+  }
+
+  // spatial order of the next solid: keys and new positions, then a sorted copy of its edges,
+  // counted on top of the generation although its temporaries are freed by then
+  if (curve != Solid3d::CURVE::NONE) {
+    bytes += 2 * edges * (sizeof(std::pair<uint64_t, uint32_t>) + sizeof(uint32_t) + sizeof(Segment3d));
+  }
+
+  // every edge of the next shape drawn as a part of the preview, with its clusters
+  if (preview) {
+    bytes += getSolidMemory(2 * edges, 0);
+  }
+
+  return bytes;
+}
@@ -0,0 +1,87 @@
+#ifndef RECTIFICATION_HPP
+#define RECTIFICATION_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "../geometry/solid3d.hpp"
+#include "../geometry/exactsolid3d.hpp"
+#include "../geometry/symmetricsolid3d.hpp"
+#include "shapeprogress.hpp"
+
+// faces, edges, vertices and edges per vertex histogram of the shape, the
+// face count is given by Euler's formula if the faces are not known
+std::string getStats(const Solid3d& shape);
+
+// rectification: every edge is replaced by its midpoint and the midpoints
+// around each vertex are connected, returns shape unchanged if cancel is set
+// faces are carried to the next shape when the ones of shape are known
+// the edges of the next shape are published through progress as they are built
+Solid3d getNextShape(const Solid3d& shape, const std::atomic_bool& cancel, ShapeProgress* progress = nullptr);
+
+// same rectification on the dyadic lattice: midpoints are exact, the vertex
+// created on edge i is vertex i of the next shape and vertex polygons are
+// built in parallel by vertex ranges on the scheduler, the result does not
+// depend on the number of ranges (threads, by default one per core)
+ExactSolid3d getNextShape(const ExactSolid3d& shape, const std::atomic_bool& cancel, unsigned threads = 0, ShapeProgress* progress = nullptr);
+
+// new edges of the lattice rectification around one vertex: its midpoints (indices in points,
+// in the order of their edges) chained each to the nearest one left, then connected as a
+// polygon appended to edges; the processes of DistributedRectifier share it so that their
+// regions give the very edges of getNextShape()
+void connectMidpoints(std::vector<uint32_t>& midpoints, const LatticePoint* points, std::vector<std::pair<uint32_t, uint32_t>>& edges);
+
+// same rectification computed on one vertex and one edge per orbit of the
+// symmetry group only, the other copies are obtained by applying its rotations
+SymmetricSolid3d getNextShape(const SymmetricSolid3d& shape, const std::atomic_bool& cancel, ShapeProgress* progress = nullptr);
+
+class DistributedRectifier;
+
+// one iteration of the rectification sequence, kept in the representation of
+// its mode, copies are cheap and share the (immutable) shapes
+class Rectifier {
+public:
+    enum class MODE {DEFAULT, EXACT, SYMMETRIC};
+
+private:
+    // full solid of a symmetric iteration, expanded by the first get_shape() of any of its copies
+    struct Expansion {
+        std::mutex mutex;
+        std::shared_ptr<const Solid3d> shape;
+    };
+
+    MODE mode;
+    Solid3d::CURVE curve; // order of the edges of every new shape
+    unsigned iteration;
+    std::shared_ptr<const Solid3d> shape; // null for a symmetric iteration, see expansion
+    std::shared_ptr<Expansion> expansion;
+    std::shared_ptr<const ExactSolid3d> exact_shape;
+    std::shared_ptr<const SymmetricSolid3d> symmetric_shape;
+    std::shared_ptr<DistributedRectifier> workers; // exact iterations split among processes
+
+public:
+    // constructors
+    // _iteration numbers a seed restored from an iteration already computed
+    Rectifier(const Solid3d &seed, const MODE _mode = MODE::DEFAULT, const unsigned _iteration = 0);
+    // exact and symmetric iterations restored in their own representation, see CompressedIteration
+    Rectifier(const Solid3d &_shape, const ExactSolid3d &_exact_shape, const unsigned _iteration);
+    Rectifier(const std::shared_ptr<const SymmetricSolid3d> &_symmetric_shape, const unsigned _iteration);
+
+    // others
+    Rectifier get_next(const std::atomic_bool &cancel, ShapeProgress *progress = nullptr) const;
+    Rectifier with_mode(const MODE _mode) const;
+    Rectifier with_curve(const Solid3d::CURVE _curve) const;
+    Rectifier with_workers(const std::shared_ptr<DistributedRectifier> &_workers) const;
+    MODE get_mode() const { return mode; }
+    Solid3d::CURVE get_curve() const { return curve; }
+    unsigned get_iteration() const { return iteration; }
+    const std::shared_ptr<const Solid3d>& get_shape() const;
+    const std::shared_ptr<const ExactSolid3d>& get_exact_shape() const { return exact_shape; }
+    const std::shared_ptr<const SymmetricSolid3d>& get_symmetric_shape() const { return symmetric_shape; }
+    size_t get_symmetry_order() const { return symmetric_shape ? symmetric_shape->group.get_order() : 1; }
+    size_t get_memory_usage() const;
+    size_t estimate_next_memory(const MODE next_mode, const bool preview = false) const;
+};
+
+#endif
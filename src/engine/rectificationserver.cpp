@@ -0,0 +1,515 @@
+#include "rectificationserver.hpp"
+#include "memorybudget.hpp"
+#include "shapecounts.hpp"
+#include "../utils/memory.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::atomic_bool stopRequested(false);
+
+static void requestStop(int) {
+    stopRequested = true;
+}
+
+static double getMilliseconds(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static const char* getModeName(const Rectifier::MODE mode) {
+    return mode == Rectifier::MODE::EXACT ? "exact" : (mode == Rectifier::MODE::SYMMETRIC ? "symmetric" : "default");
+}
+
+static std::string escapeJson(const std::string &text) {
+    std::string escaped;
+
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20)
+            escaped += c;
+    }
+
+    return escaped;
+}
+
+// the whole of data, false if the client is gone
+static bool sendAll(const int socket, const char *data, size_t size) {
+    while (size > 0) {
+        const ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+
+    return true;
+}
+
+static bool sendAll(const int socket, const std::string &text) {
+    return sendAll(socket, text.data(), text.size());
+}
+
+// {"seed":"cube","iteration":3,"mode":"default","time_ms":0.1,"faces":...,"edges":...,"vertices":...,"edges_per_vertex":{"4":...}}
+// the mode is the one of the shape, exact if the memory budget switched to it
+static std::string getStatsLine(const std::string &seed, const Rectifier &rectifier, const double time) {
+    ShapeCounts counts(*rectifier.get_shape());
+    std::ostringstream os;
+
+    os << std::setprecision(3) << std::fixed;
+    os << "{\"seed\":\"" << escapeJson(seed) << "\""
+       << ",\"iteration\":" << rectifier.get_iteration()
+       << ",\"mode\":\"" << getModeName(rectifier.get_mode()) << "\""
+       << ",\"time_ms\":" << time
+       << ",\"faces\":" << counts.get_face_count()
+       << ",\"edges\":" << counts.get_edge_count()
+       << ",\"vertices\":" << counts.get_vertex_count()
+       << ",\"edges_per_vertex\":{";
+
+    for (auto degree = counts.degrees.begin(); degree != counts.degrees.end(); ++degree)
+        os << (degree == counts.degrees.begin() ? "" : ",") << "\"" << degree -> first << "\":" << degree -> second;
+    os << "}}\n";
+
+    return os.str();
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+RectificationServer::RectificationServer(const Options &options, std::ostream &_log, const size_t _cache_limit) : curve(options.curve), memory_budget(options.memory_budget), cache_limit(_cache_limit), log(_log), listener(-1), cache_bytes(0), reserved_bytes(0), clock(0), cancel(false) {}
+
+RectificationServer::~RectificationServer() {
+    if (listener >= 0) {
+        close(listener);
+        unlink(path.c_str());
+    }
+}
+
+
+// ##############################################
+// ### operators ################################
+// ##############################################
+
+bool RectificationServer::Key::operator<(const Key &key) const {
+    if (seed != key.seed)
+        return seed < key.seed;
+    if (mode != key.mode)
+        return mode < key.mode;
+
+    return iteration < key.iteration;
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// a socket left by a server that is gone is replaced, not one that still accepts connections
+bool RectificationServer::listen(const std::string &_path, std::string &error) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (_path.empty() || _path.size() >= sizeof(address.sun_path)) {
+        error = "invalid socket path";
+        return false;
+    }
+    memcpy(address.sun_path, _path.c_str(), _path.size());
+
+    struct stat info;
+    if (lstat(_path.c_str(), &info) == 0) {
+        if (! S_ISSOCK(info.st_mode)) {
+            error = "exists and is not a socket";
+            return false;
+        }
+
+        const int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        const bool served = probe >= 0 && connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+        if (probe >= 0)
+            close(probe);
+        if (served) {
+            error = "already served by another process";
+            return false;
+        }
+        unlink(_path.c_str());
+    }
+
+    const int created = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (created < 0) {
+        error = strerror(errno);
+        return false;
+    }
+    if (bind(created, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || ::listen(created, SOMAXCONN) != 0) {
+        error = strerror(errno);
+        close(created);
+        return false;
+    }
+
+    listener = created;
+    path = _path;
+
+    return true;
+}
+
+// accepts the clients until stop is set, then closes their connections and waits for their threads
+void RectificationServer::run(const std::atomic_bool &stop) {
+    unsigned connections = 0;
+
+    while (! stop) {
+        for (auto client = clients.begin(); client != clients.end(); ) {
+            if ((*client) -> done) {
+                (*client) -> thread.join();
+                close((*client) -> socket);
+                client = clients.erase(client);
+            }
+            else
+                ++client;
+        }
+
+        if (clients.size() >= SERVER_MAX_CLIENTS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        pollfd incoming = {listener, POLLIN, 0};
+        if (poll(&incoming, 1, 100) <= 0)
+            continue;
+
+        const int socket = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (socket < 0)
+            continue;
+
+        clients.emplace_back(new Client(socket));
+        Client &client = *clients.back();
+        client.thread = std::thread(&RectificationServer::serve, this, std::ref(client), ++connections);
+    }
+
+    cancel = true;
+    for (auto &client : clients)
+        shutdown(client -> socket, SHUT_RDWR);
+    for (auto &client : clients) {
+        client -> thread.join();
+        close(client -> socket);
+    }
+    clients.clear();
+}
+
+// client thread: the requests of the connection in order, until it is closed
+void RectificationServer::serve(Client &client, const unsigned number) {
+    std::string pending;
+    char buffer[4096];
+
+    for (;;) {
+        const size_t end = pending.find('\n');
+        if (end == std::string::npos) {
+            if (pending.size() > SERVER_MAX_REQUEST) {
+                sendAll(client.socket, "error request too long\n");
+                break;
+            }
+
+            const ssize_t received = recv(client.socket, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+
+            pending.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+
+        std::string request = pending.substr(0, end);
+        pending.erase(0, end + 1);
+        if (! request.empty() && request.back() == '\r')
+            request.pop_back();
+
+        if (! request.empty() && ! answer(client.socket, request, number))
+            break;
+    }
+
+    client.done = true;
+}
+
+// false if the client is gone
+bool RectificationServer::answer(const int socket, const std::string &request, const unsigned number) {
+    const auto start = std::chrono::steady_clock::now();
+    std::istringstream words(request);
+    std::string command, seed, iteration, mode = "default", format = "ply", extra;
+    words >> command >> seed >> iteration;
+    if (command == "stats")
+        words >> mode >> extra;
+    else
+        words >> mode >> format >> extra;
+
+    std::string error;
+    Key key = {seed, Rectifier::MODE::DEFAULT, 0};
+    if (command != "stats" && command != "mesh")
+        error = "unknown command, expected stats or mesh";
+    else if (seed.empty() || iteration.empty() || iteration.find_first_not_of("0123456789") != std::string::npos)
+        error = "expected " + command + " SEED ITERATION";
+    else if (iteration.size() > 9 || std::stoul(iteration) > SERVER_MAX_ITERATION)
+        error = "iteration above " + std::to_string(SERVER_MAX_ITERATION);
+    else if (! extra.empty())
+        error = "unexpected " + extra;
+    else if (mode != "default" && mode != "exact" && mode != "symmetric")
+        error = "unknown mode " + mode;
+    else if (format != "ply" && format != "obj")
+        error = "unknown format " + format;
+
+    key.iteration = error.empty() ? static_cast<unsigned>(std::stoul(iteration)) : 0;
+    key.mode = mode == "exact" ? Rectifier::MODE::EXACT : (mode == "symmetric" ? Rectifier::MODE::SYMMETRIC : Rectifier::MODE::DEFAULT);
+
+    ORIGIN origin = ORIGIN::COMPUTED;
+    std::shared_ptr<Entry> entry;
+    if (error.empty()) {
+        try {
+            entry = get(key, origin);
+            error = entry -> error;
+        }
+        catch (...) {
+            error = "internal error";
+        }
+    }
+
+    bool sent;
+    size_t bytes = 0;
+    if (! error.empty())
+        sent = sendAll(socket, "error " + error + "\n");
+    else if (command == "stats") {
+        bytes = entry -> stats.size();
+        sent = sendAll(socket, "ok " + std::to_string(bytes) + "\n") && sendAll(socket, entry -> stats);
+    }
+    else {
+        const std::vector<char> &mesh = get_mesh(key, *entry, format == "obj" ? MeshIO::FORMAT::OBJ : MeshIO::FORMAT::PLY);
+        bytes = mesh.size();
+        sent = sendAll(socket, "ok " + std::to_string(bytes) + "\n") && sendAll(socket, mesh.data(), mesh.size());
+    }
+
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log << std::setprecision(3) << std::fixed
+        << "{\"client\":" << number
+        << ",\"request\":\"" << escapeJson(request) << "\""
+        << ",\"status\":\"" << (error.empty() ? "ok" : "error") << "\""
+        << ",\"origin\":\"" << (origin == ORIGIN::CACHED ? "cached" : (origin == ORIGIN::COALESCED ? "coalesced" : "computed")) << "\""
+        << ",\"bytes\":" << bytes
+        << ",\"time_ms\":" << getMilliseconds(start) << "}" << std::endl;
+
+    return sent;
+}
+
+// the iteration from the cache, waiting for it if another client is computing it, or computed
+// on the calling thread; origin tells which. An exception other than std::exception is passed
+// on to the waiting clients and thrown again, the iteration being dropped
+std::shared_ptr<RectificationServer::Entry> RectificationServer::get(const Key &key, ORIGIN &origin) {
+    std::promise<std::shared_ptr<Entry>> promise;
+    std::shared_future<std::shared_ptr<Entry>> result;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto found = cache.find(key);
+        if (found != cache.end()) {
+            found -> second.last_use = ++clock;
+            origin = found -> second.entry ? ORIGIN::CACHED : ORIGIN::COALESCED;
+            result = found -> second.result;
+        }
+        else {
+            origin = ORIGIN::COMPUTED;
+            Slot &slot = cache[key];
+            slot.result = promise.get_future().share();
+            slot.last_use = ++clock;
+            slot.bytes = 0;
+        }
+    }
+    if (origin != ORIGIN::COMPUTED)
+        return result.get();
+
+    std::shared_ptr<Entry> entry;
+    try {
+        entry = compute(key);
+    }
+    catch (const std::exception &e) {
+        entry = std::make_shared<Entry>();
+        entry -> error = e.what();
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            cache.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    // a failed iteration is not kept, the next request tries again
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto found = cache.find(key);
+        if (entry -> error.empty()) {
+            found -> second.entry = entry;
+            found -> second.bytes = entry -> rectifier -> get_memory_usage();
+            cache_bytes += found -> second.bytes;
+            evict(key);
+        }
+        else
+            cache.erase(found);
+    }
+
+    promise.set_value(entry);
+    return entry;
+}
+
+// iteration 0 loads the seed, the others start from the nearest iteration below already cached
+// or being computed, so that the previous iterations are computed in ascending order and the
+// recursion never goes deeper than one level
+std::shared_ptr<RectificationServer::Entry> RectificationServer::compute(const Key &key) {
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+    auto start = std::chrono::steady_clock::now();
+
+    if (key.iteration == 0) {
+        Solid3d seed;
+        if (getSeed(key.seed, seed))
+            entry -> rectifier.reset(new Rectifier(Rectifier(seed, key.mode).with_curve(curve)));
+        else
+            entry -> error = "cannot load the seed " + key.seed;
+    }
+    else {
+        // the keys of a seed and mode are sorted by iteration
+        Key previous = key;
+        previous.iteration = 0;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto below = cache.lower_bound(key);
+            if (below != cache.begin() && (--below) -> first.seed == key.seed && below -> first.mode == key.mode)
+                previous.iteration = below -> first.iteration;
+        }
+
+        std::shared_ptr<Entry> base;
+        ORIGIN origin;
+        for (;;) {
+            base = get(previous, origin);
+            if (! base -> error.empty() || previous.iteration + 1 == key.iteration)
+                break;
+            previous.iteration++;
+        }
+
+        if (! base -> error.empty())
+            entry -> error = base -> error;
+        else {
+            Rectifier rectifier = *base -> rectifier;
+            std::string message;
+            start = std::chrono::steady_clock::now();
+
+            // the budget left by the computations running, checked and reserved at once
+            bool fits = false;
+            size_t reserved = 0;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex);
+                const size_t budget = memory_budget ? memory_budget : get_memory_usage() + get_available_memory();
+                if (reserved_bytes >= budget)
+                    message = "iteration " + std::to_string(key.iteration) + " needs the memory held by the computations running: not computed";
+                else if ((fits = fitMemoryBudget(rectifier, budget - reserved_bytes, message))) {
+                    reserved = rectifier.estimate_next_memory(rectifier.get_mode());
+                    reserved_bytes += reserved;
+                }
+            }
+
+            if (! fits)
+                entry -> error = message;
+            else {
+                Rectifier next = rectifier;
+                try {
+                    next = rectifier.get_next(cancel);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(cache_mutex);
+                    reserved_bytes -= reserved;
+                    throw;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(cache_mutex);
+                    reserved_bytes -= reserved;
+                }
+
+                if (next.get_iteration() != rectifier.get_iteration())
+                    entry -> rectifier.reset(new Rectifier(next));
+                else
+                    entry -> error = cancel ? "server stopping" : "iteration " + std::to_string(key.iteration) + " cannot be computed";
+            }
+        }
+    }
+
+    if (entry -> rectifier)
+        entry -> stats = getStatsLine(key.seed, *entry -> rectifier, getMilliseconds(start));
+
+    return entry;
+}
+
+// written by the first request of the format, the others wait for it
+const std::vector<char>& RectificationServer::get_mesh(const Key &key, Entry &entry, const MeshIO::FORMAT format) {
+    const size_t index = format == MeshIO::FORMAT::OBJ ? 0 : 1;
+    bool written = false;
+
+    std::call_once(entry.mesh_once[index], [&]() {
+        MeshIO::write(*entry.rectifier -> get_shape(), entry.meshes[index], format);
+        entry.meshes[index].shrink_to_fit();
+        written = true;
+    });
+
+    if (written) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto found = cache.find(key);
+        if (found != cache.end() && found -> second.entry.get() == &entry) {
+            found -> second.bytes += entry.meshes[index].capacity();
+            cache_bytes += entry.meshes[index].capacity();
+            evict(key);
+        }
+    }
+
+    return entry.meshes[index];
+}
+
+// cache_mutex held: the least recently used iterations computed, except kept, until the cache
+// fits cache_limit; the clients still holding one keep it alive
+void RectificationServer::evict(const Key &kept) {
+    const auto keep = cache.find(kept);
+
+    while (cache_bytes > cache_limit) {
+        auto oldest = cache.end();
+        for (auto slot = cache.begin(); slot != cache.end(); ++slot)
+            if (slot != keep && slot -> second.entry && (oldest == cache.end() || slot -> second.last_use < oldest -> second.last_use))
+                oldest = slot;
+
+        if (oldest == cache.end())
+            break;
+
+        cache_bytes -= oldest -> second.bytes;
+        cache.erase(oldest);
+    }
+}
+
+int runServer(const Options &options) {
+    RectificationServer server(options);
+    std::string error;
+    if (! server.listen(options.serve, error)) {
+        std::cerr << options.serve << ": " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::cerr << "serving on " << options.serve << std::endl;
+    server.run(stopRequested);
+
+    return EXIT_SUCCESS;
+}
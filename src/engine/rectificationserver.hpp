@@ -0,0 +1,112 @@
+#ifndef RECTIFICATIONSERVER_HPP
+#define RECTIFICATIONSERVER_HPP
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "options.hpp"
+
+#define SERVER_MAX_CLIENTS 64                  // connections served at once, the next ones wait to be accepted
+#define SERVER_CACHE_BYTES (size_t(1) << 30)   // iterations and meshes kept, the least recently used dropped beyond
+#define SERVER_MAX_REQUEST 4096                // bytes of a request line
+#define SERVER_MAX_ITERATION 32                // deepest iteration served, the exact lattice of the seeds overflows soon after
+
+// long-running rectification service on a Unix domain socket (--serve PATH), so that the tools
+// of the host share the iterations instead of computing them each:
+//    - every connection is served by its own thread, the rectifications use the scheduler
+//    - the iterations are cached by seed, mode and iteration, iteration N being computed from
+//      iteration N - 1 through the cache; identical requests arriving while an iteration is
+//      computed wait for that single computation
+//    - the meshes are written once per iteration and format, then sent from memory
+//    - the computations running at once share the memory budget: each one reserves the estimated
+//      peak of its iteration until it ends, and an iteration that does not fit besides the
+//      reservations of the others is refused
+//
+// one request per line, answered in order on each connection:
+//    stats SEED ITERATION [MODE]            statistics of the iteration, one JSON line
+//    mesh SEED ITERATION [MODE] [FORMAT]    the iteration as a ply (default) or obj mesh
+// SEED being tetrahedron, cube or the path of an .obj or .ply file readable by the server,
+// ITERATION at most SERVER_MAX_ITERATION and MODE default (default), exact or symmetric; the
+// answer is "ok BYTES\n" followed by BYTES bytes, or "error MESSAGE\n"
+class RectificationServer {
+private:
+    struct Key {
+        std::string seed;
+        Rectifier::MODE mode;
+        unsigned iteration;
+
+        bool operator<(const Key &key) const;
+    };
+
+    // an iteration, or why it could not be computed
+    struct Entry {
+        std::unique_ptr<const Rectifier> rectifier; // nullptr on error
+        std::string error;
+        std::string stats;                          // JSON line
+        std::once_flag mesh_once[2];                // by MeshIO::FORMAT
+        std::vector<char> meshes[2];
+    };
+
+    struct Slot {
+        std::shared_future<std::shared_ptr<Entry>> result;
+        std::shared_ptr<Entry> entry; // once computed, never dropped before
+        uint64_t last_use;
+        size_t bytes;
+    };
+
+    enum class ORIGIN {COMPUTED, CACHED, COALESCED};
+
+    struct Client {
+        int socket;
+        std::atomic_bool done;
+        std::thread thread;
+
+        explicit Client(const int _socket) : socket(_socket), done(false) {}
+    };
+
+    const Solid3d::CURVE curve;
+    const size_t memory_budget;
+    const size_t cache_limit; // bytes
+    std::ostream &log;        // one JSON line per request
+    std::string path;
+    int listener;
+    std::map<Key, Slot> cache;
+    std::mutex cache_mutex;
+    size_t cache_bytes;
+    size_t reserved_bytes;   // estimated peaks of the computations running
+    uint64_t clock;
+    std::atomic_bool cancel; // the server stops, the computations give up
+    std::vector<std::unique_ptr<Client>> clients;
+    std::mutex log_mutex;
+
+    std::shared_ptr<Entry> get(const Key &key, ORIGIN &origin);
+    std::shared_ptr<Entry> compute(const Key &key);
+    const std::vector<char>& get_mesh(const Key &key, Entry &entry, const MeshIO::FORMAT format);
+    void evict(const Key &kept);
+    void serve(Client &client, const unsigned number);
+    bool answer(const int socket, const std::string &request, const unsigned number);
+
+public:
+    // constructors
+    explicit RectificationServer(const Options &options, std::ostream &_log = std::cout, const size_t _cache_limit = SERVER_CACHE_BYTES);
+    RectificationServer(const RectificationServer &) = delete;
+    ~RectificationServer();
+
+    // operators
+    RectificationServer& operator=(const RectificationServer &) = delete;
+
+    // others
+    bool listen(const std::string &_path, std::string &error);
+    void run(const std::atomic_bool &stop);
+};
+
+// serves on options.serve until SIGINT or SIGTERM, one JSON line per request on std::cout
+int runServer(const Options &options);
+
+#endif
@@ -0,0 +1,119 @@
+#include "renderpreparer.hpp"
+#include <algorithm>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+RenderPreparer::RenderPreparer(SharedPublisher *_publisher) : publisher(_publisher), edge_ratio(1.0), running(true), has_frame(false) {
+    worker = std::thread(&RenderPreparer::run, this);
+}
+
+RenderPreparer::~RenderPreparer() {
+    running = false;
+    worker.join();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// producer loop: waits for a new camera snapshot, then clips and projects the solid or the instances for its viewports
+void RenderPreparer::run() {
+    while (running) {
+        if (! requests.update()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        const FrameRequest &request = requests.read_buffer();
+        PreparedFrame &frame = frames.write_buffer();
+        const TimePoint start = std::chrono::steady_clock::now();
+
+        if (request.solid && request.occlusion && request.viewports.size() == 1) {
+            const Scene3d::Viewport &viewport = request.viewports[0];
+            occlusion.update(*request.solid, viewport.camera, viewport.width, viewport.height);
+            request.solid -> build_figure(frame.figure, viewport.width, viewport.height, viewport.camera, request.hidden_lines, &occlusion, request.edge_ratio);
+        }
+        else {
+            scene.clear();
+            if (request.solid)
+                scene.add(request.solid);
+            for (const auto &part : request.parts)
+                scene.add(part);
+            scene.instances = request.instances;
+            scene.edge_ratio = request.edge_ratio;
+            scene.build_figure(frame.figure, request.viewports, request.hidden_lines);
+        }
+
+        frame.sampled = request.sampled;
+        frame.duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (publisher) {
+            unsigned width = 0, height = 0;
+            for (const auto &viewport : request.viewports) {
+                width = std::max(width, viewport.left + viewport.width);
+                height = std::max(height, viewport.top + viewport.height);
+            }
+            publisher -> publish_frame(frame.figure, width, height, frame.sampled);
+        }
+        frames.publish();
+    }
+}
+
+// main thread: snapshot the camera state for the next frame to prepare
+void RenderPreparer::submit(const std::vector<Scene3d::Viewport> &viewports, const std::shared_ptr<const Solid3d> &solid, const bool hidden_lines, const bool occlusion_culling) {
+    FrameRequest &request = requests.write_buffer();
+
+    request.viewports     = viewports;
+    request.solid         = solid;
+    request.instances.clear();
+    request.parts.clear();
+    request.hidden_lines  = hidden_lines;
+    request.occlusion     = occlusion_culling;
+    request.edge_ratio    = edge_ratio;
+    request.sampled       = std::chrono::steady_clock::now();
+    submitted             = request.sampled;
+
+    requests.publish();
+}
+
+// main thread: same as above for several instances sharing their geometry, only the transforms are copied
+void RenderPreparer::submit(const std::vector<Scene3d::Viewport> &viewports, const std::vector<Instance3d> &instances, const bool hidden_lines) {
+    submit(viewports, instances, std::vector<std::shared_ptr<const Solid3d>>(), hidden_lines);
+}
+
+// main thread: instances and the parts of a shape being built, only pointers to the parts are copied
+void RenderPreparer::submit(const std::vector<Scene3d::Viewport> &viewports, const std::vector<Instance3d> &instances, const std::vector<std::shared_ptr<const Solid3d>> &parts, const bool hidden_lines) {
+    FrameRequest &request = requests.write_buffer();
+
+    request.viewports     = viewports;
+    request.solid.reset();
+    request.instances     = instances;
+    request.parts         = parts;
+    request.hidden_lines  = hidden_lines;
+    request.occlusion     = false;
+    request.edge_ratio    = edge_ratio;
+    request.sampled       = std::chrono::steady_clock::now();
+    submitted             = request.sampled;
+
+    requests.publish();
+}
+
+// main thread: latest prepared frame, nullptr until the first one is ready
+// the returned frame stays valid until the next call
+const RenderPreparer::PreparedFrame* RenderPreparer::acquire() {
+    if (frames.update())
+        has_frame = true;
+
+    return has_frame ? &frames.read_buffer() : nullptr;
+}
+
+// main thread: the frame of the last submitted request, waiting for the producer thread to
+// prepare it, so that the time of the frame includes its clipping and projection (replay)
+const RenderPreparer::PreparedFrame* RenderPreparer::wait() {
+    while (! acquire() || frames.read_buffer().sampled != submitted)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    return &frames.read_buffer();
+}
@@ -0,0 +1,75 @@
+#ifndef RENDERPREPARER_HPP
+#define RENDERPREPARER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "../utils/triplebuffer.hpp"
+#include "../geometry/camera3d.hpp"
+#include "../geometry/solid3d.hpp"
+#include "../geometry/instance3d.hpp"
+#include "../geometry/scene3d.hpp"
+#include "sharedpublisher.hpp"
+
+// producer thread building the projected vertex buffer of frame N + 1 while
+// the main thread presents frame N, camera snapshots go in and prepared
+// figures come out through two lock-free triple buffers
+// a request has one viewport per camera, all drawn in the same figure
+class RenderPreparer {
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    struct FrameRequest {
+        std::vector<Scene3d::Viewport> viewports;
+        std::shared_ptr<const Solid3d> solid;
+        std::vector<Instance3d> instances; // drawn instead of solid when not empty
+        std::vector<std::shared_ptr<const Solid3d>> parts; // drawn with the instances
+        bool hidden_lines;
+        bool occlusion; // cull the edges of solid hidden behind its own faces, single viewport only
+        double edge_ratio; // fraction of the edges drawn, see Solid3d::get_edge_threshold()
+        TimePoint sampled; // when the camera state was read from the input
+    };
+
+    struct PreparedFrame {
+        sf::VertexArray figure;
+        TimePoint sampled;
+        double duration; // ms spent clipping and projecting it
+
+        PreparedFrame() : figure(sf::Lines), duration(0.0) {}
+    };
+
+private:
+    TripleBuffer<FrameRequest> requests;
+    TripleBuffer<PreparedFrame> frames;
+    OcclusionBuffer occlusion; // owned by the producer thread
+    Scene3d scene;             // owned by the producer thread
+    SharedPublisher *publisher; // receives every prepared frame, if any
+    double edge_ratio;          // of the next requests
+    TimePoint submitted;        // sampled of the last request
+    std::atomic_bool running;
+    bool has_frame;
+    std::thread worker;
+
+    void run();
+
+public:
+    // constructors
+    explicit RenderPreparer(SharedPublisher *_publisher = nullptr);
+    RenderPreparer(const RenderPreparer &) = delete;
+    ~RenderPreparer();
+
+    // operators
+    RenderPreparer& operator=(const RenderPreparer &) = delete;
+
+    // others
+    void submit(const std::vector<Scene3d::Viewport> &viewports, const std::shared_ptr<const Solid3d> &solid, const bool hidden_lines = false, const bool occlusion_culling = false);
+    void submit(const std::vector<Scene3d::Viewport> &viewports, const std::vector<Instance3d> &instances, const bool hidden_lines = false);
+    void submit(const std::vector<Scene3d::Viewport> &viewports, const std::vector<Instance3d> &instances, const std::vector<std::shared_ptr<const Solid3d>> &parts, const bool hidden_lines = false);
+    const PreparedFrame* acquire();
+    const PreparedFrame* wait();
+    void set_edge_ratio(const double _edge_ratio) { edge_ratio = _edge_ratio; }
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "shapecounts.hpp"
+#include <limits>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// vertices are matched exactly as in getStats()
+ShapeCounts::ShapeCounts(const Solid3d &shape) {
+    std::map<Vector3d, size_t> edges_per_vertex;
+
+    for (const Segment3d &edge : shape.edges) {
+        edges_per_vertex[edge.a]++;
+        edges_per_vertex[edge.b]++;
+    }
+
+    for (const auto &vertex : edges_per_vertex)
+        degrees[vertex.second]++;
+
+    if (! shape.faces.empty())
+        for (const auto &face : shape.faces)
+            face_sizes[face.edges.size()]++;
+    else if (! shape.edges.empty())
+        face_sizes[UNKNOWN_FACE_SIZE] = shape.edges.size() - edges_per_vertex.size() + 2;
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+uint64_t ShapeCounts::get_vertex_count() const {
+    uint64_t count = 0;
+
+    for (const auto &degree : degrees)
+        count += degree.second;
+
+    return count;
+}
+
+// every edge has two ends
+uint64_t ShapeCounts::get_edge_count() const {
+    uint64_t ends = 0;
+
+    for (const auto &degree : degrees)
+        ends += degree.first * degree.second;
+
+    return ends / 2;
+}
+
+uint64_t ShapeCounts::get_face_count() const {
+    uint64_t count = 0;
+
+    for (const auto &size : face_sizes)
+        count += size.second;
+
+    return count;
+}
+
+// rules above only hold for vertices of degree 3 or more, and the next edge count 2E must fit
+bool ShapeCounts::can_rectify() const {
+    return ! degrees.empty()
+        && degrees.begin() -> first >= 3
+        && get_edge_count() <= std::numeric_limits<uint64_t>::max() / 4;
+}
+
+ShapeCounts ShapeCounts::get_next() const {
+    ShapeCounts next;
+
+    next.degrees[4] = get_edge_count();
+
+    next.face_sizes = face_sizes;
+    for (const auto &degree : degrees)
+        next.face_sizes[degree.first] += degree.second;
+
+    return next;
+}
+
+// same text as getStats()
+std::string ShapeCounts::get_stats() const {
+    std::string stats;
+
+    stats += "# of faces: " + std::to_string(get_face_count()) + "\n";
+    stats += "# of edges: " + std::to_string(get_edge_count()) + "\n";
+    stats += "# of vertices: " + std::to_string(get_vertex_count()) + "\n";
+    stats += "Edges per vertex:\n";
+    for (const auto &degree : degrees)
+        stats += "\t" + std::to_string(degree.first) + " edges: " + std::to_string(degree.second) + " occurences\n";
+
+    return stats;
+}
+
+// counts of the given iteration of the seed, stops early if the rules do not apply
+ShapeCounts ShapeCounts::predict(const Solid3d &seed, const unsigned iterations) {
+    ShapeCounts counts(seed);
+
+    for (unsigned i = 0; i < iterations && counts.can_rectify(); ++i)
+        counts = counts.get_next();
+
+    return counts;
+}
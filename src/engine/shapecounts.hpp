@@ -0,0 +1,39 @@
+#ifndef SHAPECOUNTS_HPP
+#define SHAPECOUNTS_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include "../geometry/solid3d.hpp"
+
+#define UNKNOWN_FACE_SIZE 0
+
+// combinatorial description of a shape: how many vertices have each degree
+// and how many faces have each size, enough to advance the rectification
+// without geometry when every vertex has at least 3 edges:
+//    - every edge becomes a vertex of degree 4
+//    - every vertex of degree d becomes a face of size d
+//    - every face of size n stays a face of size n
+class ShapeCounts {
+public:
+    std::map<size_t, uint64_t> degrees;    // degree -> number of vertices
+    std::map<size_t, uint64_t> face_sizes; // size -> number of faces, UNKNOWN_FACE_SIZE if not known
+
+public:
+    // constructors
+    ShapeCounts() {}
+    // if the faces of the solid are not known, their count is given by Euler's formula and their sizes are unknown
+    explicit ShapeCounts(const Solid3d &shape);
+
+    // others
+    uint64_t get_vertex_count() const;
+    uint64_t get_edge_count() const;
+    uint64_t get_face_count() const;
+    bool can_rectify() const;
+    ShapeCounts get_next() const;
+    std::string get_stats() const;
+
+    static ShapeCounts predict(const Solid3d &seed, const unsigned iterations);
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "shapeprogress.hpp"
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+void ShapeProgress::publish(std::vector<Segment3d> &batch) {
+    std::lock_guard<std::mutex> lock(producers);
+
+    published += batch.size();
+    if (pending.empty())
+        pending.swap(batch);
+    else
+        pending.insert(pending.end(), batch.begin(), batch.end());
+    batch.clear();
+
+    if (batches.push(pending))
+        pending.clear();
+}
+
+// the queued batches first, then the pending edges that the full queue refused, which would
+// never be delivered after the last publish() otherwise: the producers are not waited for, the
+// next poll() tries again
+bool ShapeProgress::poll(std::vector<Segment3d> &batch) {
+    if (batches.pop(batch))
+        return true;
+
+    std::unique_lock<std::mutex> lock(producers, std::try_to_lock);
+    if (! lock.owns_lock())
+        return false;
+
+    // a batch may have been queued before the lock was taken
+    if (batches.pop(batch))
+        return true;
+    if (pending.empty())
+        return false;
+
+    batch.clear();
+    batch.swap(pending);
+    return true;
+}
+
+void publishEdges(ShapeProgress *progress, std::vector<Segment3d> &batch, const bool last) {
+    if (progress == nullptr || batch.empty() || (! last && batch.size() < PROGRESS_BATCH_EDGES))
+        return;
+
+    progress -> publish(batch);
+}
@@ -0,0 +1,48 @@
+#ifndef SHAPEPROGRESS_HPP
+#define SHAPEPROGRESS_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "../geometry/segment3d.hpp"
+#include "../utils/spscqueue.hpp"
+
+#define PROGRESS_BATCH_EDGES 16384 // edges of the next shape handed to the window together
+#define PROGRESS_QUEUE_SIZE  64    // batches waiting for the window
+
+// edges of the next shape published while getNextShape() builds it, so that the window
+// draws the shape as it grows instead of waiting for the whole of it: finished batches
+// go through a lock-free queue that the main loop polls without ever blocking, a batch
+// that does not fit in the full queue is merged with the next one so the generation never
+// waits either, and is taken by poll() once the queue is empty if no batch follows it. The
+// exact mode publishes from several ranges at once, which only serialize among themselves
+class ShapeProgress {
+private:
+    SpscQueue<std::vector<Segment3d>, PROGRESS_QUEUE_SIZE> batches;
+    std::vector<Segment3d> pending; // not queued yet, the queue being full
+    std::mutex producers;
+    std::atomic<size_t> published;
+    size_t expected;
+
+public:
+    // constructors
+    explicit ShapeProgress(const size_t _expected = 0) : published(0), expected(_expected) {}
+    ShapeProgress(const ShapeProgress &) = delete;
+
+    // operators
+    ShapeProgress& operator=(const ShapeProgress &) = delete;
+
+    // producer side
+    void publish(std::vector<Segment3d> &batch);
+
+    // consumer side
+    bool poll(std::vector<Segment3d> &batch);
+    size_t get_published() const { return published; }
+    size_t get_expected() const { return expected; }
+};
+
+// publishes batch through progress (if any) once it holds PROGRESS_BATCH_EDGES edges, or
+// whatever its size when last is set, batch is emptied when it is published
+void publishEdges(ShapeProgress *progress, std::vector<Segment3d> &batch, const bool last = false);
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SHAREDLAYOUT_HPP
+#define SHAREDLAYOUT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// layout of the POSIX shared memory object written by SharedPublisher (--share NAME), to be
+// included by the processes reading it: they map it read-only with
+//    fd = shm_open(NAME, O_RDONLY, 0); mmap(nullptr, size of the object, PROT_READ, MAP_SHARED, fd, 0)
+// and find the current mesh and the latest frames at the offsets of SharedHeader
+//
+// every block is guarded by a seqlock: its sequence is odd while the engine writes it, a reader
+//    1. loads the sequence (acquire) and retries later if it is odd
+//    2. reads the counts and the data in place
+//    3. issues std::atomic_thread_fence(std::memory_order_acquire) and reloads the sequence,
+//       what it read is only valid if the sequence did not change
+// the engine never waits for the readers, a slow reader sees the sequence change and retries,
+// readSharedBlock() below does so
+
+#define SHARED_MAGIC          UINT64_C(0x4d48534e49474e45) // "ENGINSHM" in little endian
+#define SHARED_LAYOUT_VERSION 2
+#define SHARED_MESH_BYTES     (UINT64_C(128) << 20) // vertices and edges of the current mesh
+#define SHARED_FRAME_SLOTS    3                     // latest frames, written in turn
+#define SHARED_FRAME_BYTES    (UINT64_C(32) << 20)  // projected vertices of each frame
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the sequences are shared between processes, they must be lock-free");
+
+// vertex of the mesh block, in world coordinates
+struct SharedVertex {
+    double x, y, z;
+    uint8_t r, g, b, a;
+    uint32_t padding;
+};
+
+// current mesh, followed at SharedHeader::mesh_offset by vertex_count SharedVertex then by
+// edge_count pairs of uint32_t vertex indices; a mesh larger than SHARED_MESH_BYTES is
+// published with no vertex nor edge and truncated set
+struct SharedMesh {
+    std::atomic<uint64_t> sequence;
+    uint64_t version;   // grows with every mesh published
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint32_t iteration; // of the rectification, or the depth in adaptive mode
+    uint32_t truncated;
+};
+
+// frame drawn in a window of width x height pixels, followed by vertex_count vertices of the
+// sf::Vertex layout {float x, y; uint8_t r, g, b, a; float u, v}, two per line; the vertices
+// beyond SHARED_FRAME_BYTES are dropped
+struct SharedFrame {
+    std::atomic<uint64_t> sequence;
+    uint64_t number;     // frame number, from 0
+    int64_t sampled_ns;  // steady clock (CLOCK_MONOTONIC) time of the camera state of the frame
+    uint64_t vertex_count;
+    uint32_t width, height;
+};
+
+struct SharedHeader {
+    uint64_t magic;
+    uint32_t layout_version;
+    uint32_t frame_slots;
+    uint64_t mesh_offset;   // data of the mesh, from the start of the mapping
+    uint64_t frame_offset;  // first frame slot: its SharedFrame, then its vertices
+    uint64_t frame_stride;  // bytes between two frame slots
+    int64_t writer_pid;     // process of the engine, an object whose writer is dead may be replaced
+    std::atomic<uint64_t> frame_count; // frames published, the latest one in slot (frame_count - 1) % frame_slots
+    SharedMesh mesh;
+};
+
+// seqlock read of the block guarded by sequence: read() copies what the reader needs from the
+// block, it is called again until the sequence is even and unchanged around the copy. Returns the
+// number of attempts, a write in progress counting as one
+template <typename F>
+inline unsigned readSharedBlock(const std::atomic<uint64_t> &sequence, F read) {
+    for (unsigned attempts = 1; ; ++attempts) {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+            return attempts;
+    }
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "sharedpublisher.hpp"
+#include "../geometry/exactsolid3d.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+static_assert(sizeof(sf::Vertex) == 20, "the frames are published in the sf::Vertex layout of sharedlayout.hpp");
+
+// exact identity of a vertex: the bits of its coordinates (with -0 == 0)
+static LatticePoint get_bits(const Vector3d &v) {
+    LatticePoint bits;
+    const double coordinates[3] = {v.get<0>() + 0.0, v.get<1>() + 0.0, v.get<2>() + 0.0};
+
+    memcpy(&bits.x, &coordinates[0], 8);
+    memcpy(&bits.y, &coordinates[1], 8);
+    memcpy(&bits.z, &coordinates[2], 8);
+
+    return bits;
+}
+
+static size_t align64(const size_t bytes) {
+    return (bytes + 63) / 64 * 64;
+}
+
+// an existing object name left by an engine that is no longer running: its header is complete
+// (of this layout) and its writer process is gone, any other object is in use or not ours
+static bool isStale(const std::string &name) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return errno == ENOENT; // removed meanwhile
+
+    struct stat status;
+    void *shared = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(SharedHeader))
+        shared = mmap(nullptr, sizeof(SharedHeader), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED)
+        return false;
+
+    const SharedHeader *header = static_cast<const SharedHeader *>(shared);
+    const bool complete = header -> magic == SHARED_MAGIC && header -> layout_version == SHARED_LAYOUT_VERSION;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const pid_t writer = static_cast<pid_t>(header -> writer_pid);
+    munmap(shared, sizeof(SharedHeader));
+
+    return complete && writer > 0 && kill(writer, 0) != 0 && errno == ESRCH;
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+SharedPublisher::SharedPublisher() : mapping(nullptr), size(0), header(nullptr), mesh_version(0), frame_count(0), tasks(Scheduler::PRIORITY::BACKGROUND) {}
+
+// a mesh whose task failed is simply not published
+SharedPublisher::~SharedPublisher() {
+    try {
+        tasks.wait();
+    }
+    catch (...) {}
+
+    if (mapping) {
+        munmap(mapping, size);
+        shm_unlink(name.c_str());
+    }
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// creates the object /_name, its pages are only allocated by the system as they are written
+// an existing object is only replaced if the engine that wrote it is no longer running, the
+// object of another engine (or of another program) is never removed
+bool SharedPublisher::open(const std::string &_name, std::string &error) {
+    name = (! _name.empty() && _name[0] == '/') ? _name : "/" + _name;
+
+    const size_t mesh_offset  = align64(sizeof(SharedHeader));
+    const size_t frame_offset = mesh_offset + SHARED_MESH_BYTES;
+    const size_t frame_stride = align64(sizeof(SharedFrame) + SHARED_FRAME_BYTES);
+    const size_t total        = frame_offset + SHARED_FRAME_SLOTS * frame_stride;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST && isStale(name)) {
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0) {
+        error = errno == EEXIST ? "already exists, used by a running engine or another program" : strerror(errno);
+        return false;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        error = strerror(errno);
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *shared = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        error = strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    mapping = static_cast<uint8_t *>(shared);
+    size    = total;
+
+    SharedHeader *created = new (mapping) SharedHeader();
+    created -> layout_version = SHARED_LAYOUT_VERSION;
+    created -> frame_slots    = SHARED_FRAME_SLOTS;
+    created -> mesh_offset    = mesh_offset;
+    created -> frame_offset   = frame_offset;
+    created -> frame_stride   = frame_stride;
+    created -> writer_pid     = getpid();
+    for (unsigned slot = 0; slot < SHARED_FRAME_SLOTS; ++slot)
+        new (mapping + frame_offset + slot * frame_stride) SharedFrame();
+
+    // readers check the magic number last
+    std::atomic_thread_fence(std::memory_order_release);
+    created -> magic = SHARED_MAGIC;
+    header = created;
+
+    return true;
+}
+
+// main thread: the welding runs in the background, a mesh already superseded when its task
+// starts or ends is dropped
+void SharedPublisher::publish_mesh(const std::shared_ptr<const Solid3d> &shape, const unsigned iteration) {
+    if (! header)
+        return;
+
+    const uint64_t version = ++mesh_version;
+    tasks.run([this, shape, version, iteration]() {
+        if (version == mesh_version)
+            write_mesh(*shape, version, iteration);
+    });
+}
+
+void SharedPublisher::write_mesh(const Solid3d &shape, const uint64_t version, const uint32_t iteration) {
+    std::unordered_map<LatticePoint, uint32_t, LatticePointHash> indices;
+    indices.reserve(shape.edges.size());
+    std::vector<SharedVertex> vertices;
+    std::vector<uint32_t> edges;
+    edges.reserve(2 * shape.edges.size());
+
+    for (const auto &edge : shape.edges) {
+        for (const Vector3d *v : {&edge.a, &edge.b}) {
+            const auto inserted = indices.emplace(get_bits(*v), static_cast<uint32_t>(vertices.size()));
+            if (inserted.second) {
+                const sf::Color &color = v -> get_color();
+                vertices.push_back({v -> get<0>(), v -> get<1>(), v -> get<2>(), color.r, color.g, color.b, color.a, 0});
+            }
+            edges.push_back(inserted.first -> second);
+        }
+    }
+
+    const size_t vertex_bytes = vertices.size() * sizeof(SharedVertex);
+    const size_t edge_bytes = edges.size() * sizeof(uint32_t);
+    const bool fits = vertex_bytes + edge_bytes <= SHARED_MESH_BYTES;
+
+    std::lock_guard<std::mutex> lock(mesh_mutex);
+    if (version != mesh_version)
+        return;
+
+    SharedMesh &mesh = header -> mesh;
+    const uint64_t sequence = mesh.sequence.load(std::memory_order_relaxed);
+    mesh.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    mesh.version      = version;
+    mesh.iteration    = iteration;
+    mesh.truncated    = fits ? 0 : 1;
+    mesh.vertex_count = fits ? vertices.size() : 0;
+    mesh.edge_count   = fits ? shape.edges.size() : 0;
+    if (fits) {
+        uint8_t *data = mapping + header -> mesh_offset;
+        memcpy(data, vertices.data(), vertex_bytes);
+        memcpy(data + vertex_bytes, edges.data(), edge_bytes);
+    }
+
+    mesh.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// single producer: each frame goes to the next slot, the readers of that slot (three frames
+// old) see its sequence change
+void SharedPublisher::publish_frame(const sf::VertexArray &figure, const unsigned width, const unsigned height, const TimePoint sampled) {
+    if (! header)
+        return;
+
+    uint8_t *slot = mapping + header -> frame_offset + (frame_count % SHARED_FRAME_SLOTS) * header -> frame_stride;
+    SharedFrame &frame = *reinterpret_cast<SharedFrame *>(slot);
+    const size_t count = std::min<size_t>(figure.getVertexCount(), SHARED_FRAME_BYTES / sizeof(sf::Vertex) / 2 * 2);
+
+    const uint64_t sequence = frame.sequence.load(std::memory_order_relaxed);
+    frame.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    frame.number       = frame_count;
+    frame.sampled_ns   = std::chrono::duration_cast<std::chrono::nanoseconds>(sampled.time_since_epoch()).count();
+    frame.vertex_count = count;
+    frame.width        = width;
+    frame.height       = height;
+    if (count > 0)
+        memcpy(slot + sizeof(SharedFrame), &figure[0], count * sizeof(sf::Vertex));
+
+    frame.sequence.store(sequence + 2, std::memory_order_release);
+    header -> frame_count.store(++frame_count, std::memory_order_release);
+}
@@ -0,0 +1,53 @@
+#ifndef SHAREDPUBLISHER_HPP
+#define SHAREDPUBLISHER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "sharedlayout.hpp"
+#include "../geometry/solid3d.hpp"
+#include "../utils/scheduler.hpp"
+
+// writer of the POSIX shared memory object described in sharedlayout.hpp: other processes of
+// the host map the current mesh and the latest projected frames read-only, without copy nor
+// serialization. The mesh is welded into vertices and edges by a background task of the
+// scheduler, a newer mesh superseding an older one still waiting; the frames are copied by
+// their single producer (the render thread). Neither ever waits for the readers. The object is
+// created exclusively, replacing only the leftover of an engine no longer running, and is
+// unlinked when the publisher is destroyed, the readers keep their mapping
+class SharedPublisher {
+public:
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+private:
+    std::string name;
+    uint8_t *mapping;
+    size_t size;
+    SharedHeader *header;
+    std::mutex mesh_mutex;              // meshes are written by background tasks
+    std::atomic<uint64_t> mesh_version; // last version given to a mesh
+    uint64_t frame_count;               // owned by the frame producer
+    Scheduler::TaskGroup tasks;         // mesh tasks, waited for before the mapping goes
+
+    void write_mesh(const Solid3d &shape, const uint64_t version, const uint32_t iteration);
+
+public:
+    // constructors
+    SharedPublisher();
+    SharedPublisher(const SharedPublisher &) = delete;
+    ~SharedPublisher();
+
+    // operators
+    SharedPublisher& operator=(const SharedPublisher &) = delete;
+
+    // others
+    bool open(const std::string &_name, std::string &error);
+    bool is_open() const { return header != nullptr; }
+    void publish_mesh(const std::shared_ptr<const Solid3d> &shape, const unsigned iteration);
+    void publish_frame(const sf::VertexArray &figure, const unsigned width, const unsigned height, const TimePoint sampled);
+};
+
+#endif
@@ -101,3 +101,34 @@ Vector3d Camera3d::transform_vector(const Vector3d &v) const {
 Segment3d Camera3d::transform_segment(const Segment3d &s) const {
  	return Segment3d(transform_vector(s.a), transform_vector(s.b));
 }
+
+// same rotation as transform_vector() as a matrix: transform_vector(v) = get_rotation() * (v - position)
+Matrix3d Camera3d::get_rotation() const {
+	double cx = cos(theta_x), cy = cos(theta_y), cz = cos(theta_z);
+	double sx = sin(theta_x), sy = sin(theta_y), sz = sin(theta_z);
+
+	return Matrix3d(cy * cz                , cy * sz                , - sy   ,
+	                sx * sy * cz - cx * sz , sx * sy * sz + cx * cz , sx * cy,
+	                cx * sy * cz + sx * sz , cx * sy * sz - sx * cz , cx * cy);
+}
+
+// sphere given in camera coordinates (see transform_vector()), false when it lies entirely outside one side of the frustrum
+bool Camera3d::is_sphere_in_frustrum(const Vector3d &center, const double radius) const {
+	for (auto &side : frustrum)
+		if (side.get_signed_distance_from_point_to_plane(center) < - radius)
+			return false;
+
+	return true;
+}
+
+// s in camera coordinates (see transform_segment()) is clipped by the frustrum, its visible part is projected
+// in out[0] and out[1], returns the number of vertices written: 0 or 2
+unsigned Camera3d::write_projection(sf::Vertex *out, Segment3d s, const unsigned window_width, const unsigned window_height) const {
+	for (auto &side : frustrum)
+		if (side.handle_intersection_of_segment_with_plane(s))
+			return 0;
+
+	out[0] = frustrum[0].get_projection_on_plane(s.a, window_width, window_height);
+	out[1] = frustrum[0].get_projection_on_plane(s.b, window_width, window_height);
+	return 2;
+}
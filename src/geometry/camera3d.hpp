@@ -5,6 +5,7 @@
 #include "vector3d.hpp"
 #include "segment3d.hpp"
 #include "plane3d.hpp"
+#include "matrix3d.hpp"
 
 #define CAMERA_ROTATION_SENSIBILITY    0.25
 #define CAMERA_TRANSLATION_SENSIBILITY 4
@@ -21,6 +22,7 @@ private:
 
 public:
 	// constructors
+	Camera3d() : position(Vector3d()), theta_x(0.0), theta_y(0.0), theta_z(0.0) {}
 	Camera3d(const Vector3d &_position,
 		     const double _theta_x,
 		     const double _theta_y,
@@ -37,6 +39,10 @@ public:
 	void move(const DIRECTION direction);
 	Vector3d transform_vector(const Vector3d &v) const;
 	Segment3d transform_segment(const Segment3d &s) const;
+	Matrix3d get_rotation() const;
+	const Vector3d& get_position() const { return position; }
+	bool is_sphere_in_frustrum(const Vector3d &center, const double radius) const;
+	unsigned write_projection(sf::Vertex *out, Segment3d s, const unsigned window_width, const unsigned window_height) const;
 
 
 friend class Solid3d;
@@ -0,0 +1,77 @@
+#include "exactsolid3d.hpp"
+#include <unordered_map>
+
+// ##############################################
+// ### LatticePointHash #########################
+// ##############################################
+
+// see boost::hash_combine, with the 64 bits golden ratio constant
+size_t LatticePointHash::operator()(const LatticePoint &p) const {
+    uint64_t h = static_cast<uint64_t>(p.x);
+    h ^= static_cast<uint64_t>(p.y) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= static_cast<uint64_t>(p.z) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+
+    return static_cast<size_t>(h);
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// round every coordinate to the lattice of step 2^-_shift and weld equal points
+ExactSolid3d::ExactSolid3d(const Solid3d &solid, const int _shift) : shift(_shift) {
+    std::unordered_map<LatticePoint, uint32_t, LatticePointHash> indices;
+
+    auto get_index = [&](const Vector3d &v) {
+        LatticePoint p = get_lattice_point(v, shift);
+
+        auto inserted = indices.emplace(p, static_cast<uint32_t>(vertices.size()));
+        if (inserted.second)
+            vertices.push_back(p);
+
+        return inserted.first -> second;
+    };
+
+    edges.reserve(solid.edges.size());
+    for (const auto &s : solid.edges)
+        edges.push_back(std::make_pair(get_index(s.a), get_index(s.b)));
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+int64_t ExactSolid3d::get_max_magnitude() const {
+    int64_t magnitude = 0;
+
+    for (const auto &p : vertices)
+        magnitude = std::max<int64_t>(magnitude, std::max<int64_t>(std::abs(p.x), std::max<int64_t>(std::abs(p.y), std::abs(p.z))));
+
+    return magnitude;
+}
+
+Vector3d ExactSolid3d::get_vertex(const size_t i) const {
+    return Vector3d(std::ldexp(static_cast<double>(vertices[i].x), - shift),
+                    std::ldexp(static_cast<double>(vertices[i].y), - shift),
+                    std::ldexp(static_cast<double>(vertices[i].z), - shift),
+                    sf::Color::White);
+}
+
+// nearest point of the lattice of step 2^-shift
+LatticePoint ExactSolid3d::get_lattice_point(const Vector3d &v, const int shift) {
+    return LatticePoint{std::llround(std::ldexp(v.x, shift)),
+                        std::llround(std::ldexp(v.y, shift)),
+                        std::llround(std::ldexp(v.z, shift))};
+}
+
+Solid3d ExactSolid3d::to_solid() const {
+    Solid3d solid;
+
+    solid.edges.reserve(edges.size());
+    for (const auto &e : edges)
+        solid.add_segment(Segment3d(get_vertex(e.first), get_vertex(e.second)));
+
+    return solid;
+}
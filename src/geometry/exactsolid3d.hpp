@@ -0,0 +1,49 @@
+#ifndef EXACT_SOLID_3D_HPP
+#define EXACT_SOLID_3D_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "solid3d.hpp"
+
+#define EXACT_INITIAL_SHIFT 20 // seed coordinates are rounded to multiples of 2^-20
+#define EXACT_MAX_MAGNITUDE (INT64_C(1) << 61)
+
+// point of the dyadic lattice: the real coordinates are (x, y, z) * 2^-shift
+// where shift is shared by every point of an ExactSolid3d
+struct LatticePoint {
+    int64_t x, y, z;
+
+    bool operator==(const LatticePoint &p) const { return x == p.x && y == p.y && z == p.z; }
+    bool operator<(const LatticePoint &p) const { return x != p.x ? x < p.x : (y != p.y ? y < p.y : z < p.z); }
+};
+
+// hash of the integer coordinates, used to weld vertices exactly
+struct LatticePointHash {
+    size_t operator()(const LatticePoint &p) const;
+};
+
+// solid stored as indexed integer coordinates so that the midpoint of two
+// vertices is computed exactly: (a + b) * 0.5 at scale 2^-shift is a + b at
+// scale 2^-(shift + 1), hence no rounding and no tolerant vertex matching
+class ExactSolid3d {
+public:
+    std::vector<LatticePoint> vertices;
+    std::vector<std::pair<uint32_t, uint32_t>> edges; // indices in vertices
+    int shift;
+
+public:
+    // constructors
+    ExactSolid3d() : shift(0) {}
+    explicit ExactSolid3d(const Solid3d &solid, const int _shift = EXACT_INITIAL_SHIFT);
+
+    // others
+    int64_t get_max_magnitude() const;
+    bool can_rectify() const { return get_max_magnitude() < EXACT_MAX_MAGNITUDE; }
+    Vector3d get_vertex(const size_t i) const;
+    size_t get_memory_usage() const { return sizeof(ExactSolid3d) + vertices.capacity() * sizeof(LatticePoint) + edges.capacity() * sizeof(edges[0]); }
+    static LatticePoint get_lattice_point(const Vector3d &v, const int shift);
+    Solid3d to_solid() const;
+};
+
+#endif
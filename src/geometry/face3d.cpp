@@ -0,0 +1,48 @@
+#include "face3d.hpp"
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// centroid of the vertices and Newell normal of the polygon, oriented by the edge order
+Face3d::Face3d(const std::vector<Segment3d> &solid_edges, const std::vector<uint32_t> &_edges) : edges(_edges) {
+	std::vector<Vector3d> loop;
+	loop.reserve(edges.size());
+
+	for (size_t i = 0; i < edges.size(); ++i)
+		loop.push_back(get_shared_vertex(solid_edges[edges[i]], solid_edges[edges[(i + 1) % edges.size()]]));
+
+	double nx = 0, ny = 0, nz = 0;
+	for (size_t i = 0; i < loop.size(); ++i) {
+		const Vector3d &p = loop[i];
+		const Vector3d &q = loop[(i + 1) % loop.size()];
+
+		nx += (p.y - q.y) * (p.z + q.z);
+		ny += (p.z - q.z) * (p.x + q.x);
+		nz += (p.x - q.x) * (p.y + q.y);
+		centroid += p;
+	}
+
+	if (! loop.empty())
+		centroid *= 1.0 / loop.size();
+
+	normal = Vector3d(nx, ny, nz);
+	if (normal.norm() > 0)
+		normal.normalize();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// flip the normal if it points against outward
+void Face3d::orient(const Vector3d &outward) {
+	if (normal * outward < 0)
+		normal *= -1;
+}
+
+// vertex common to two consecutive edges of a face
+const Vector3d& Face3d::get_shared_vertex(const Segment3d &s, const Segment3d &t) {
+	return (s.a == t.a || s.a == t.b) ? s.a : s.b;
+}
@@ -0,0 +1,28 @@
+#ifndef FACE3D_HPP
+#define FACE3D_HPP
+
+#include <cstdint>
+#include <vector>
+#include "vector3d.hpp"
+#include "segment3d.hpp"
+
+// polygon of a solid given by the indices of its edges in Solid3d::edges, in order
+// around the face so that two consecutive edges share a vertex
+class Face3d {
+public:
+	std::vector<uint32_t> edges;
+	Vector3d normal;   // unit, outward once orient() has been called
+	Vector3d centroid;
+
+public:
+	// constructors
+	Face3d() {}
+	Face3d(const std::vector<Segment3d> &solid_edges, const std::vector<uint32_t> &_edges);
+
+	// others
+	void orient(const Vector3d &outward);
+	bool is_front_facing(const Vector3d &viewpoint) const { return (viewpoint - centroid) * normal > 0; }
+	static const Vector3d& get_shared_vertex(const Segment3d &s, const Segment3d &t);
+};
+
+#endif
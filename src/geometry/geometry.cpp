@@ -26,6 +26,19 @@ Cube3d::Cube3d(const Vector3d &_center, const double size) : Solid3d() {
         add_segment(Segment3d(points[i], points[i + 4]));               // links
     }
 
+    // edge 3i is front(i, i + 1), 3i + 1 back(i + 4, i + 5) and 3i + 2 link(i, i + 4)
+    std::vector<uint32_t> front, back;
+    for (uint32_t i = 0; i < 4; ++i) {
+        front.push_back(3 * i);
+        back.push_back(3 * i + 1);
+        add_face(Face3d(edges, {3 * i, 3 * ((i + 1) % 4) + 2, 3 * i + 1, 3 * i + 2}));
+    }
+    add_face(Face3d(edges, front));
+    add_face(Face3d(edges, back));
+
+    for (auto &f : faces)
+        f.orient(f.centroid);
+
     *this += _center;
 }
 
@@ -62,3 +75,33 @@ Sphere3d::Sphere3d(const Vector3d &_center,
 
     *this += _center;
 }
+
+
+// ##############################################
+// ### Tetrahedron3d ############################
+// ##############################################
+
+// regular tetrahedron of edge size, base triangle in the y = 0 plane and apex towards - y
+Tetrahedron3d::Tetrahedron3d(const double size) : Solid3d() {
+    const double half = size / 2;
+    Vector3d points[4];
+
+    points[0] = Vector3d(-half, 0, 0);
+    points[1] = Vector3d(half , 0, 0);
+    points[2] = Vector3d(0    , 0, half * sqrt(3));
+    points[3] = Vector3d(0, -sqrt(square(size) - square(half) - square(half * sqrt(3) / 3)), half * sqrt(3) / 3);
+
+    for (int i = 0; i < 3; ++i)
+        add_segment(Segment3d(points[i], points[(i + 1) % 3])); // base
+    for (int i = 0; i < 3; ++i)
+        add_segment(Segment3d(points[i], points[3]));           // apex
+
+    // edge i is base(i, i + 1) and 3 + i apex(i, 3)
+    add_face(Face3d(edges, {0, 1, 2}));
+    for (uint32_t i = 0; i < 3; ++i)
+        add_face(Face3d(edges, {i, 3 + (i + 1) % 3, 3 + i}));
+
+    Vector3d inside = (points[0] + points[1] + points[2] + points[3]) * 0.25;
+    for (auto &f : faces)
+        f.orient(f.centroid - inside);
+}
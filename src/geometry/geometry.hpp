@@ -30,4 +30,14 @@ public:
              const unsigned number_of_points_per_circle);
 };
 
+// ##############################################
+// ### Tetrahedron3d ############################
+// ##############################################
+
+class Tetrahedron3d : public Solid3d {
+
+public:
+    Tetrahedron3d(const double size);
+};
+
 #endif
@@ -0,0 +1,64 @@
+#include "instance3d.hpp"
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+Instance3d::Instance3d(const std::shared_ptr<const Solid3d> &_geometry, const Vector3d &_position, const double scale, const sf::Color &_tint) :
+	geometry(_geometry),
+	orientation(scale, 0.0, 0.0, 0.0, scale, 0.0, 0.0, 0.0, scale),
+	position(_position),
+	tint(_tint)
+{}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// rotation of theta degrees around axis going through the instance position
+void Instance3d::rotate(const Vector3d &axis, const double theta) {
+	orientation = Matrix3d::rotation(axis, theta) * orientation;
+}
+
+// camera position in the frame of the geometry, to test its faces with Solid3d::get_edge_visibility()
+// orientation is a rotation times a scale: its inverse is its transpose divided by the squared scale
+Vector3d Instance3d::get_viewpoint(const Camera3d &camera) const {
+	double squared_scale = square(orientation.get(0, 0)) + square(orientation.get(1, 0)) + square(orientation.get(2, 0));
+
+	return orientation.get_transposed() * (camera.get_position() - position) * (1 / squared_scale);
+}
+
+// bounding sphere of the geometry placed in the world
+void Instance3d::get_bounding_sphere(Vector3d &center, double &radius) const {
+	geometry -> get_bounding_sphere(center, radius);
+
+	center = orientation * center + position;
+	radius *= sqrt(square(orientation.get(0, 0)) + square(orientation.get(1, 0)) + square(orientation.get(2, 0)));
+}
+
+// same as Solid3d::write_figure() on the edges [begin, end) of the geometry:
+// camera.transform_vector(orientation * v + position) is folded into a single matrix and offset,
+// so that each shared vertex costs one matrix product before clipping
+size_t Instance3d::write_figure(sf::Vertex *out, const size_t begin, const size_t end, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const unsigned char *visibility, const double edge_ratio) const {
+	const uint32_t threshold = Solid3d::get_edge_threshold(edge_ratio);
+	Matrix3d camera_rotation = camera.get_rotation();
+	Matrix3d transform = camera_rotation * orientation;
+	Vector3d offset = camera_rotation * (position - camera.get_position());
+	size_t count = 0;
+
+	for (size_t i = begin; i < end; ++i) {
+		if ((visibility && visibility[i] == Solid3d::BACK_FACES) || ! Solid3d::is_edge_kept(i, threshold))
+			continue;
+
+		const Segment3d &s = geometry -> edges[i];
+		Vector3d a = transform * s.a + offset;
+		Vector3d b = transform * s.b + offset;
+		a.set_color(s.a.get_color() * tint);
+		b.set_color(s.b.get_color() * tint);
+
+		count += camera.write_projection(out + count, Segment3d(a, b), window_width, window_height);
+	}
+
+	return count;
+}
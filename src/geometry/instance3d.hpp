@@ -0,0 +1,36 @@
+#ifndef INSTANCE3D_HPP
+#define INSTANCE3D_HPP
+
+#include <memory>
+#include "vector3d.hpp"
+#include "matrix3d.hpp"
+#include "camera3d.hpp"
+#include "solid3d.hpp"
+
+// lightweight placement of a shared immutable solid: only a transform and a tint
+// are stored, the geometry is transformed on the fly when the figure is built
+// so that memory stays flat however many instances of the same solid are drawn
+class Instance3d {
+private:
+	std::shared_ptr<const Solid3d> geometry;
+	Matrix3d orientation; // scale included
+	Vector3d position;
+	sf::Color tint;
+
+public:
+	// constructors
+	Instance3d(const std::shared_ptr<const Solid3d> &_geometry,
+	           const Vector3d &_position,
+	           const double scale = 1.0,
+	           const sf::Color &_tint = sf::Color::White);
+
+	// others
+	const std::shared_ptr<const Solid3d>& get_geometry() const { return geometry; }
+	void set_geometry(const std::shared_ptr<const Solid3d> &_geometry) { geometry = _geometry; }
+	void rotate(const Vector3d &axis, const double theta);
+	Vector3d get_viewpoint(const Camera3d &camera) const;
+	void get_bounding_sphere(Vector3d &center, double &radius) const;
+	size_t write_figure(sf::Vertex *out, const size_t begin, const size_t end, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const unsigned char *visibility = nullptr, const double edge_ratio = 1.0) const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "matrix3d.hpp"
+
+const double precision = 0.000001;
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// identity matrix
+Matrix3d::Matrix3d() {
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned j = 0; j < 3; ++j)
+			m[i][j] = (i == j) ? 1.0 : 0.0;
+}
+
+Matrix3d::Matrix3d(const double m00, const double m01, const double m02,
+                   const double m10, const double m11, const double m12,
+                   const double m20, const double m21, const double m22) {
+	m[0][0] = m00; m[0][1] = m01; m[0][2] = m02;
+	m[1][0] = m10; m[1][1] = m11; m[1][2] = m12;
+	m[2][0] = m20; m[2][1] = m21; m[2][2] = m22;
+}
+
+
+// ##############################################
+// ### operators ################################
+// ##############################################
+
+Matrix3d Matrix3d::operator*(const Matrix3d &a) const {
+	Matrix3d product;
+
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned j = 0; j < 3; ++j)
+			product.m[i][j] = m[i][0] * a.m[0][j] + m[i][1] * a.m[1][j] + m[i][2] * a.m[2][j];
+
+	return product;
+}
+
+// the color of v is kept
+Vector3d Matrix3d::operator*(const Vector3d &v) const {
+	return Vector3d(m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+	                m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+	                m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z,
+	                v.color);
+}
+
+bool Matrix3d::operator==(const Matrix3d &a) const {
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned j = 0; j < 3; ++j)
+			if (std::abs(m[i][j] - a.m[i][j]) >= precision)
+				return false;
+
+	return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const Matrix3d &a) {
+	os << std::setprecision(3) << std::fixed;
+
+	for (unsigned i = 0; i < 3; ++i)
+		os << std::setw(7) << a.m[i][0] << " " << std::setw(7) << a.m[i][1] << " " << std::setw(7) << a.m[i][2] << std::endl;
+
+	return os;
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+Matrix3d Matrix3d::get_transposed() const {
+	return Matrix3d(m[0][0], m[1][0], m[2][0],
+	                m[0][1], m[1][1], m[2][1],
+	                m[0][2], m[1][2], m[2][2]);
+}
+
+// theta in degrees, same formula as Vector3d::rotate()
+// See https://en.wikipedia.org/wiki/Rotation_matrix#In_three_dimensions part "Rotation matrix from axis and angle"
+Matrix3d Matrix3d::rotation(const Vector3d &axis, const double theta) {
+	Vector3d ax = axis.get_normalized();
+	double ux = ax.x, uy = ax.y, uz = ax.z;
+	double c = cos(as_radians(theta)), s = sin(as_radians(theta));
+
+	return Matrix3d(c + square(ux) * (1 - c)  , ux * uy * (1 - c) - uz * s, ux * uz * (1 - c) + uy * s,
+	                uy * ux * (1 - c) + uz * s, c + square(uy) * (1 - c)  , uy * uz * (1 - c) - ux * s,
+	                uz * ux * (1 - c) - uy * s, uz * uy * (1 - c) + ux * s, c + square(uz) * (1 - c));
+}
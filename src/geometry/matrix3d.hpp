@@ -0,0 +1,32 @@
+#ifndef MATRIX3D_HPP
+#define MATRIX3D_HPP
+
+#include "vector3d.hpp"
+
+class Matrix3d {
+private:
+	double m[3][3];
+
+public:
+	// constructors
+	Matrix3d();
+	Matrix3d(const double m00, const double m01, const double m02,
+	         const double m10, const double m11, const double m12,
+	         const double m20, const double m21, const double m22);
+
+	// operators
+	Matrix3d operator*(const Matrix3d &a) const;
+	Vector3d operator*(const Vector3d &v) const;
+	bool operator==(const Matrix3d &a) const;
+
+	// others
+	double get(const unsigned row, const unsigned column) const { return m[row][column]; }
+	Matrix3d get_transposed() const;
+	static Matrix3d identity() { return Matrix3d(); }
+	static Matrix3d rotation(const Vector3d &axis, const double theta);
+
+
+friend std::ostream& operator<<(std::ostream& os, const Matrix3d &a);
+};
+
+#endif
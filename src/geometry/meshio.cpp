@@ -0,0 +1,749 @@
+#include "meshio.hpp"
+#include "exactsolid3d.hpp"
+#include "../utils/mappedfile.hpp"
+#include "../utils/scheduler.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+
+#define MESH_MAX_INDEX INT64_C(0xffffffff) // vertex indices of the files read, edge keys hold two of them
+
+typedef std::unordered_map<LatticePoint, uint32_t, LatticePointHash> VertexIndices;
+
+// exact identity of a vertex: the bits of its coordinates (with -0 == 0)
+static LatticePoint get_bits(const double x, const double y, const double z) {
+    LatticePoint bits;
+    const double coordinates[3] = {x + 0.0, y + 0.0, z + 0.0};
+
+    memcpy(&bits.x, &coordinates[0], 8);
+    memcpy(&bits.y, &coordinates[1], 8);
+    memcpy(&bits.z, &coordinates[2], 8);
+
+    return bits;
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+bool MeshIO::write(const Solid3d &solid, const std::string &path, const FORMAT format, uint64_t *bytes) {
+    if (format == FORMAT::OBJ)
+        return write_obj(solid, path, bytes);
+
+    return write_ply(solid, path, bytes);
+}
+
+// the mesh appended to memory, as it would be written to a file
+void MeshIO::write(const Solid3d &solid, std::vector<char> &memory, const FORMAT format) {
+    BufferedWriter out(memory);
+
+    if (format == FORMAT::OBJ)
+        write_obj(solid, out);
+    else
+        write_ply(solid, out);
+}
+
+bool MeshIO::write_obj(const Solid3d &solid, const std::string &path, uint64_t *bytes) {
+    BufferedWriter out(path);
+    if (! out.is_open())
+        return false;
+
+    write_obj(solid, out);
+    out.flush();
+    if (bytes)
+        *bytes = out.get_written_bytes();
+
+    return out.close();
+}
+
+bool MeshIO::write_ply(const Solid3d &solid, const std::string &path, uint64_t *bytes) {
+    BufferedWriter out(path);
+    if (! out.is_open())
+        return false;
+
+    write_ply(solid, out);
+    out.flush();
+    if (bytes)
+        *bytes = out.get_written_bytes();
+
+    return out.close();
+}
+
+// OBJ indices may refer to any previous vertex, so a vertex is written right before the first edge using it
+void MeshIO::write_obj(const Solid3d &solid, BufferedWriter &out) {
+    VertexIndices indices;
+    indices.reserve(solid.edges.size());
+
+    auto get_index = [&](const Vector3d &v) {
+        auto inserted = indices.emplace(get_bits(v.x, v.y, v.z), static_cast<uint32_t>(indices.size() + 1));
+
+        if (inserted.second) {
+            out.write("v ");
+            out.write_double(v.x);
+            out.write(' ');
+            out.write_double(v.y);
+            out.write(' ');
+            out.write_double(v.z);
+            out.write('\n');
+        }
+
+        return inserted.first -> second;
+    };
+
+    out.write("# 3D-engine\n");
+    for (const auto &s : solid.edges) {
+        uint32_t a = get_index(s.a);
+        uint32_t b = get_index(s.b);
+
+        out.write("l ");
+        out.write_uint(a);
+        out.write(' ');
+        out.write_uint(b);
+        out.write('\n');
+    }
+}
+
+// the header needs the vertex count: a first pass indexes the vertices, the
+// second one writes each of them when first met, then the edges are written
+void MeshIO::write_ply(const Solid3d &solid, BufferedWriter &out) {
+    VertexIndices indices;
+    indices.reserve(solid.edges.size());
+    for (const auto &s : solid.edges) {
+        indices.emplace(get_bits(s.a.x, s.a.y, s.a.z), static_cast<uint32_t>(indices.size()));
+        indices.emplace(get_bits(s.b.x, s.b.y, s.b.z), static_cast<uint32_t>(indices.size()));
+    }
+
+    out.write("ply\nformat binary_little_endian 1.0\ncomment 3D-engine\nelement vertex ");
+    out.write_uint(indices.size());
+    out.write("\nproperty double x\nproperty double y\nproperty double z\nelement edge ");
+    out.write_uint(solid.edges.size());
+    out.write("\nproperty int vertex1\nproperty int vertex2\nend_header\n");
+
+    uint32_t next_vertex = 0;
+    for (const auto &s : solid.edges) {
+        for (const Vector3d *v : {&s.a, &s.b}) {
+            if (indices[get_bits(v -> x, v -> y, v -> z)] == next_vertex) {
+                out.write_le_double(v -> x);
+                out.write_le_double(v -> y);
+                out.write_le_double(v -> z);
+                next_vertex++;
+            }
+        }
+    }
+
+    for (const auto &s : solid.edges) {
+        out.write_le_uint32(indices[get_bits(s.a.x, s.a.y, s.a.z)]);
+        out.write_le_uint32(indices[get_bits(s.b.x, s.b.y, s.b.z)]);
+    }
+}
+
+
+// ##############################################
+// ### import ###################################
+// ##############################################
+
+// an edge is stored as min index << 32 | max index, so sorting them removes duplicates,
+// the readers refuse the indices above MESH_MAX_INDEX that would not fit
+typedef std::vector<uint64_t> EdgeKeys;
+
+static inline uint64_t get_edge_key(const uint64_t a, const uint64_t b) {
+    return a < b ? (a << 32) | b : (b << 32) | a;
+}
+
+// runs task(0) .. task(threads - 1) in parallel, as background tasks of the scheduler
+static void run_parallel(const unsigned threads, const std::function<void(unsigned)> &task) {
+    Scheduler::get().parallel_for(0, threads, 1, [&task](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t)
+            task(static_cast<unsigned>(t));
+    }, Scheduler::PRIORITY::BACKGROUND);
+}
+
+// sorted union of the (sorted) keys of every chunk
+static void merge_edge_keys(std::vector<EdgeKeys> &chunks, EdgeKeys &keys) {
+    size_t count = 0;
+    for (const auto &chunk : chunks)
+        count += chunk.size();
+
+    keys.clear();
+    keys.reserve(count);
+    for (auto &chunk : chunks) {
+        size_t middle = keys.size();
+        keys.insert(keys.end(), chunk.begin(), chunk.end());
+        std::inplace_merge(keys.begin(), keys.begin() + middle, keys.end());
+        EdgeKeys().swap(chunk);
+    }
+
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+static void sort_edge_keys(EdgeKeys &keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+// fills solid with the indexed edges, in parallel
+static bool build_solid(const std::vector<Vector3d> &vertices, const EdgeKeys &keys, Solid3d &solid, std::string &error, const unsigned threads) {
+    for (auto key : keys) {
+        if ((key & 0xffffffff) >= vertices.size()) {
+            error = "edge referring to a missing vertex";
+            return false;
+        }
+    }
+
+    solid.clear();
+    solid.edges.resize(keys.size());
+
+    run_parallel(threads, [&](unsigned t) {
+        size_t begin = keys.size() * t / threads;
+        size_t end   = keys.size() * (t + 1) / threads;
+
+        for (size_t i = begin; i < end; ++i)
+            solid.edges[i] = Segment3d(vertices[keys[i] >> 32], vertices[keys[i] & 0xffffffff]);
+    });
+
+    return true;
+}
+
+static inline bool is_blank(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* skip_blanks(const char *p, const char *end) {
+    while (p < end && is_blank(*p))
+        ++p;
+
+    return p;
+}
+
+static inline const char* next_line(const char *p, const char *end) {
+    const void *newline = memchr(p, '\n', static_cast<size_t>(end - p));
+
+    return newline ? static_cast<const char *>(newline) + 1 : end;
+}
+
+// the magnitude stops at MESH_MAX_INDEX + 1 so that it never overflows, the index checks refuse it
+// and the exponents are clamped anyway
+static bool parse_int(const char *&p, const char *end, int64_t &x) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    if (p == end || *p < '0' || *p > '9')
+        return false;
+
+    x = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+        x = std::min(10 * x + (*p++ - '0'), MESH_MAX_INDEX + 1);
+
+    if (negative)
+        x = - x;
+
+    return true;
+}
+
+// decimal number without going through a null terminated string:
+// exact fast path when the mantissa and the power of 10 are exact doubles,
+// otherwise strtod() on a copy of the token kept on the stack
+static bool parse_double(const char *&p, const char *end, double &x) {
+    static const double powers_of_10[] = {1e0 , 1e1 , 1e2 , 1e3 , 1e4 , 1e5 , 1e6 , 1e7 , 1e8 , 1e9 , 1e10, 1e11,
+                                          1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *start = p;
+    bool negative = false, any_digit = false, truncated = false;
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    for (bool fraction = false; p < end; ++p) {
+        if (*p == '.' && ! fraction) {
+            fraction = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9')
+            break;
+
+        any_digit = true;
+        if (digits < 19) {
+            mantissa = 10 * mantissa + static_cast<uint64_t>(*p - '0');
+            if (mantissa != 0)
+                digits++;
+            if (fraction)
+                exponent--;
+        }
+        else {
+            truncated = truncated || *p != '0';
+            if (! fraction)
+                exponent++;
+        }
+    }
+
+    if (! any_digit)
+        return false;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int64_t e;
+
+        if (parse_int(q, end, e)) {
+            exponent += static_cast<int>(std::max<int64_t>(-400, std::min<int64_t>(400, e)));
+            p = q;
+        }
+    }
+
+    if (! truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        x = exponent < 0 ? mantissa / powers_of_10[- exponent] : mantissa * powers_of_10[exponent];
+        if (negative)
+            x = - x;
+    }
+    else {
+        char token[64];
+        size_t length = std::min<size_t>(static_cast<size_t>(p - start), sizeof(token) - 1);
+
+        memcpy(token, start, length);
+        token[length] = '\0';
+        x = strtod(token, nullptr);
+    }
+
+    return true;
+}
+
+// a chunk starts at the beginning of a line, t-th of threads chunks
+static const char* get_chunk_begin(const char *begin, const char *end, const unsigned t, const unsigned threads) {
+    if (t == 0)
+        return begin;
+    if (t == threads)
+        return end;
+
+    const char *p = begin + static_cast<size_t>(end - begin) * t / threads;
+    return next_line(p - 1, end);
+}
+
+static inline bool is_obj_vertex(const char *p, const char *end) {
+    return p + 1 < end && p[0] == 'v' && is_blank(p[1]);
+}
+
+// first pass counts the "v" lines of every chunk so that the second one knows
+// the index of the first vertex of its chunk, needed by relative (< 0) indices
+bool MeshIO::read_obj(const char *begin, const char *end, Solid3d &solid, std::string &error, const unsigned threads) {
+    std::vector<size_t> first_vertex(threads + 1, 0);
+
+    run_parallel(threads, [&](unsigned t) {
+        const char *chunk_end = get_chunk_begin(begin, end, t + 1, threads);
+
+        for (const char *p = get_chunk_begin(begin, end, t, threads); p < chunk_end; p = next_line(p, chunk_end))
+            if (is_obj_vertex(skip_blanks(p, chunk_end), chunk_end))
+                first_vertex[t + 1]++;
+    });
+
+    for (unsigned t = 0; t < threads; ++t)
+        first_vertex[t + 1] += first_vertex[t];
+
+    if (first_vertex[threads] > 0xffffffff) {
+        error = "too many vertices";
+        return false;
+    }
+
+    std::vector<Vector3d> vertices(first_vertex[threads]);
+    std::vector<EdgeKeys> chunk_edges(threads);
+    std::vector<const char *> chunk_errors(threads, nullptr);
+
+    run_parallel(threads, [&](unsigned t) {
+        const char *chunk_end = get_chunk_begin(begin, end, t + 1, threads);
+        size_t vertex = first_vertex[t];
+        std::vector<int64_t> indices;
+
+        for (const char *p = get_chunk_begin(begin, end, t, threads); p < chunk_end; p = next_line(p, chunk_end)) {
+            const char *line = p;
+            p = skip_blanks(p, chunk_end);
+
+            if (is_obj_vertex(p, chunk_end)) {
+                double x, y, z;
+                p = skip_blanks(p + 1, chunk_end);
+                bool valid = parse_double(p, chunk_end, x);
+                p = skip_blanks(p, chunk_end);
+                valid = valid && parse_double(p, chunk_end, y);
+                p = skip_blanks(p, chunk_end);
+                valid = valid && parse_double(p, chunk_end, z);
+
+                if (! valid) {
+                    chunk_errors[t] = line;
+                    return;
+                }
+
+                vertices[vertex++] = Vector3d(x, y, z, sf::Color::White);
+            }
+            else if (p + 1 < chunk_end && (p[0] == 'l' || p[0] == 'f') && is_blank(p[1])) {
+                const bool closed = p[0] == 'f';
+                indices.clear();
+
+                for (p = skip_blanks(p + 1, chunk_end); p < chunk_end && *p != '\n' && *p != '#'; p = skip_blanks(p, chunk_end)) {
+                    int64_t index;
+                    if (! parse_int(p, chunk_end, index) || index == 0) {
+                        chunk_errors[t] = line;
+                        return;
+                    }
+
+                    // "f v/vt/vn": only the vertex index matters
+                    while (p < chunk_end && ! is_blank(*p) && *p != '\n')
+                        ++p;
+
+                    indices.push_back(index > 0 ? index - 1 : static_cast<int64_t>(vertex) + index);
+                    if (indices.back() < 0 || indices.back() > MESH_MAX_INDEX) {
+                        chunk_errors[t] = line;
+                        return;
+                    }
+                }
+
+                size_t sides = (closed && indices.size() > 2) ? indices.size() : indices.size() - std::min<size_t>(1, indices.size());
+                for (size_t i = 0; i < sides; ++i) {
+                    uint64_t a = static_cast<uint64_t>(indices[i]);
+                    uint64_t b = static_cast<uint64_t>(indices[(i + 1) % indices.size()]);
+
+                    if (a != b)
+                        chunk_edges[t].push_back(get_edge_key(a, b));
+                }
+            }
+        }
+
+        sort_edge_keys(chunk_edges[t]);
+    });
+
+    for (unsigned t = 0; t < threads; ++t) {
+        if (chunk_errors[t]) {
+            size_t line = 1 + static_cast<size_t>(std::count(begin, chunk_errors[t], '\n'));
+            error = "invalid line " + std::to_string(line);
+            return false;
+        }
+    }
+
+    EdgeKeys keys;
+    merge_edge_keys(chunk_edges, keys);
+
+    return build_solid(vertices, keys, solid, error, threads);
+}
+
+// ##############################################
+// ### PLY import ###############################
+// ##############################################
+
+namespace {
+
+enum class PLY_TYPE {INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, INVALID};
+
+struct PlyProperty {
+    std::string name;
+    PLY_TYPE type;
+    bool is_list;
+    PLY_TYPE count_type; // type of the number of items of a list
+    size_t offset;       // in the record, only meaningful if the element has a fixed size
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+    bool fixed_size;
+    size_t record_size;
+
+    const PlyProperty* find(const char *property) const {
+        for (const auto &p : properties)
+            if (p.name == property)
+                return &p;
+
+        return nullptr;
+    }
+};
+
+PLY_TYPE get_ply_type(const std::string &name) {
+    if (name == "char"   || name == "int8")    return PLY_TYPE::INT8;
+    if (name == "uchar"  || name == "uint8")   return PLY_TYPE::UINT8;
+    if (name == "short"  || name == "int16")   return PLY_TYPE::INT16;
+    if (name == "ushort" || name == "uint16")  return PLY_TYPE::UINT16;
+    if (name == "int"    || name == "int32")   return PLY_TYPE::INT32;
+    if (name == "uint"   || name == "uint32")  return PLY_TYPE::UINT32;
+    if (name == "float"  || name == "float32") return PLY_TYPE::FLOAT32;
+    if (name == "double" || name == "float64") return PLY_TYPE::FLOAT64;
+
+    return PLY_TYPE::INVALID;
+}
+
+size_t get_ply_size(const PLY_TYPE type) {
+    switch (type) {
+        case PLY_TYPE::INT8:  case PLY_TYPE::UINT8:                         return 1;
+        case PLY_TYPE::INT16: case PLY_TYPE::UINT16:                        return 2;
+        case PLY_TYPE::INT32: case PLY_TYPE::UINT32: case PLY_TYPE::FLOAT32: return 4;
+        case PLY_TYPE::FLOAT64:                                             return 8;
+        case PLY_TYPE::INVALID:                                             break;
+    }
+
+    return 0;
+}
+
+// value of the given type stored at p
+double read_ply_value(const char *p, const PLY_TYPE type, const bool big_endian) {
+    unsigned char bytes[8];
+    size_t size = get_ply_size(type);
+
+    for (size_t i = 0; i < size; ++i)
+        bytes[i] = static_cast<unsigned char>(p[big_endian ? size - 1 - i : i]);
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i < size; ++i)
+        bits |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+
+    switch (type) {
+        case PLY_TYPE::INT8:    return static_cast<int8_t>(bits);
+        case PLY_TYPE::UINT8:   return static_cast<uint8_t>(bits);
+        case PLY_TYPE::INT16:   return static_cast<int16_t>(bits);
+        case PLY_TYPE::UINT16:  return static_cast<uint16_t>(bits);
+        case PLY_TYPE::INT32:   return static_cast<int32_t>(bits);
+        case PLY_TYPE::UINT32:  return static_cast<uint32_t>(bits);
+        case PLY_TYPE::FLOAT32: { uint32_t b = static_cast<uint32_t>(bits); float f; memcpy(&f, &b, 4); return f; }
+        case PLY_TYPE::FLOAT64: { double d; memcpy(&d, &bits, 8); return d; }
+        case PLY_TYPE::INVALID: break;
+    }
+
+    return 0.0;
+}
+
+// size of the property starting at p, 0 if it goes past end
+size_t get_property_size(const PlyProperty &property, const char *p, const char *end, const bool big_endian) {
+    size_t size = get_ply_size(property.type);
+
+    if (property.is_list) {
+        size_t count_size = get_ply_size(property.count_type);
+        if (p + count_size > end)
+            return 0;
+
+        // a negative count would not convert to a size
+        const double count = read_ply_value(p, property.count_type, big_endian);
+        if (! (count >= 0.0 && count <= double(UINT32_MAX)))
+            return 0;
+        size = count_size + static_cast<size_t>(count) * size;
+    }
+
+    return p + size <= end ? size : 0;
+}
+
+// vertex index stored at p, false if it is negative or above MESH_MAX_INDEX (it would not convert to
+// an unsigned integer or not fit in an edge key)
+static bool read_ply_index(const char *p, const PLY_TYPE type, const bool big_endian, uint64_t &index) {
+    const double value = read_ply_value(p, type, big_endian);
+    if (! (value >= 0.0 && value <= double(MESH_MAX_INDEX)))
+        return false;
+
+    index = static_cast<uint64_t>(value);
+    return true;
+}
+
+// size of the record of element starting at p, 0 if it goes past end
+size_t get_record_size(const PlyElement &element, const char *p, const char *end, const bool big_endian) {
+    if (element.fixed_size)
+        return p + element.record_size <= end ? element.record_size : 0;
+
+    size_t size = 0;
+    for (const auto &property : element.properties) {
+        size_t property_size = get_property_size(property, p + size, end, big_endian);
+        if (property_size == 0)
+            return 0;
+
+        size += property_size;
+    }
+
+    return size;
+}
+
+}
+
+// the header is small and parsed with streams, the data is binary: vertices and
+// edges have fixed size records read in parallel, faces are first scanned to
+// find where each thread starts
+bool MeshIO::read_ply(const char *begin, const char *end, Solid3d &solid, std::string &error, const unsigned threads) {
+    const char *data = begin;
+    std::vector<PlyElement> elements;
+    bool big_endian = false;
+
+    for (bool header_end = false; ! header_end; ) {
+        if (data >= end) {
+            error = "missing end_header";
+            return false;
+        }
+
+        const char *line_end = next_line(data, end);
+        std::istringstream line(std::string(data, line_end));
+        std::string keyword;
+        data = line_end;
+        line >> keyword;
+
+        if (keyword == "format") {
+            std::string format;
+            line >> format;
+
+            if (format == "ascii") {
+                error = "ascii PLY files are not supported";
+                return false;
+            }
+            big_endian = format == "binary_big_endian";
+        }
+        else if (keyword == "element") {
+            PlyElement element;
+            line >> element.name >> element.count;
+            element.fixed_size  = true;
+            element.record_size = 0;
+            elements.push_back(element);
+        }
+        else if (keyword == "property" && ! elements.empty()) {
+            PlyProperty property;
+            std::string type;
+            line >> type;
+
+            property.is_list = type == "list";
+            if (property.is_list) {
+                std::string count_type;
+                line >> count_type >> type;
+                property.count_type = get_ply_type(count_type);
+                elements.back().fixed_size = false;
+            }
+            line >> property.name;
+            property.type   = get_ply_type(type);
+            property.offset = elements.back().record_size;
+
+            if (property.type == PLY_TYPE::INVALID || (property.is_list && property.count_type == PLY_TYPE::INVALID)) {
+                error = "unknown property type in: " + line.str();
+                return false;
+            }
+
+            elements.back().record_size += get_ply_size(property.type);
+            elements.back().properties.push_back(property);
+        }
+        else if (keyword == "end_header")
+            header_end = true;
+    }
+
+    std::vector<Vector3d> vertices;
+    std::vector<EdgeKeys> chunk_edges;
+
+    for (const auto &element : elements) {
+        const PlyProperty *x = element.find("x"), *y = element.find("y"), *z = element.find("z");
+        const PlyProperty *vertex1 = element.find("vertex1"), *vertex2 = element.find("vertex2");
+        const PlyProperty *face = element.find("vertex_indices") ? element.find("vertex_indices") : element.find("vertex_index");
+
+        // start of the records of each thread
+        std::vector<const char *> starts(threads + 1, data);
+        if (element.fixed_size) {
+            if (element.record_size > 0 && element.count > static_cast<size_t>(end - data) / element.record_size) {
+                error = "truncated " + element.name + " element";
+                return false;
+            }
+            for (unsigned t = 0; t <= threads; ++t)
+                starts[t] = data + element.count * t / threads * element.record_size;
+        }
+        else {
+            for (size_t i = 0, t = 1; i < element.count; ++i) {
+                while (t < threads && i == element.count * t / threads)
+                    starts[t++] = data;
+
+                size_t size = get_record_size(element, data, end, big_endian);
+                if (size == 0) {
+                    error = "truncated " + element.name + " element";
+                    return false;
+                }
+                data += size;
+            }
+            starts[threads] = data;
+        }
+
+        if (element.name == "vertex" && x && y && z && ! x -> is_list && ! y -> is_list && ! z -> is_list && element.fixed_size) {
+            vertices.resize(element.count);
+
+            run_parallel(threads, [&](unsigned t) {
+                size_t i = element.count * t / threads;
+                for (const char *p = starts[t]; p < starts[t + 1]; p += element.record_size, ++i)
+                    vertices[i] = Vector3d(read_ply_value(p + x -> offset, x -> type, big_endian),
+                                           read_ply_value(p + y -> offset, y -> type, big_endian),
+                                           read_ply_value(p + z -> offset, z -> type, big_endian),
+                                           sf::Color::White);
+            });
+        }
+        else if ((element.name == "edge" && vertex1 && vertex2 && element.fixed_size) || (element.name == "face" && face && face -> is_list)) {
+            std::vector<EdgeKeys> edges(threads);
+            std::vector<char> invalid(threads, 0);
+
+            run_parallel(threads, [&](unsigned t) {
+                for (const char *p = starts[t]; p < starts[t + 1]; ) {
+                    size_t size = get_record_size(element, p, starts[t + 1], big_endian);
+
+                    if (face) {
+                        // the list starts after the previous properties
+                        const char *q = p;
+                        for (size_t i = 0; &element.properties[i] != face; ++i)
+                            q += get_property_size(element.properties[i], q, p + size, big_endian);
+
+                        size_t count = static_cast<size_t>(read_ply_value(q, face -> count_type, big_endian));
+                        const char *items = q + get_ply_size(face -> count_type);
+                        size_t item_size = get_ply_size(face -> type);
+
+                        for (size_t i = 0; i < count && count > 1; ++i) {
+                            uint64_t a, b;
+                            if (! read_ply_index(items + i * item_size, face -> type, big_endian, a) || ! read_ply_index(items + (i + 1) % count * item_size, face -> type, big_endian, b)) {
+                                invalid[t] = 1;
+                                return;
+                            }
+                            if (a != b)
+                                edges[t].push_back(get_edge_key(a, b));
+                        }
+                    }
+                    else {
+                        uint64_t a, b;
+                        if (! read_ply_index(p + vertex1 -> offset, vertex1 -> type, big_endian, a) || ! read_ply_index(p + vertex2 -> offset, vertex2 -> type, big_endian, b)) {
+                            invalid[t] = 1;
+                            return;
+                        }
+                        if (a != b)
+                            edges[t].push_back(get_edge_key(a, b));
+                    }
+
+                    p += size;
+                }
+
+                sort_edge_keys(edges[t]);
+            });
+
+            if (std::find(invalid.begin(), invalid.end(), 1) != invalid.end()) {
+                error = "invalid vertex index in " + element.name + " element";
+                return false;
+            }
+            chunk_edges.insert(chunk_edges.end(), edges.begin(), edges.end());
+        }
+
+        data = starts[threads];
+    }
+
+    EdgeKeys keys;
+    merge_edge_keys(chunk_edges, keys);
+
+    return build_solid(vertices, keys, solid, error, threads);
+}
+
+bool MeshIO::read(const std::string &path, Solid3d &solid, std::string &error, unsigned threads) {
+    MappedFile file(path);
+    if (! file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    if (threads == 0)
+        threads = Scheduler::get().get_concurrency();
+
+    // small files are not worth the threads
+    threads = static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, file.get_size() >> 16)));
+
+    if (file.get_size() >= 4 && memcmp(file.begin(), "ply", 3) == 0 && (file.begin()[3] == '\n' || file.begin()[3] == '\r'))
+        return read_ply(file.begin(), file.end(), solid, error, threads);
+
+    return read_obj(file.begin(), file.end(), solid, error, threads);
+}
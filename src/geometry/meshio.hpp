@@ -0,0 +1,35 @@
+#ifndef MESHIO_HPP
+#define MESHIO_HPP
+
+#include <cstdint>
+#include <string>
+#include "solid3d.hpp"
+#include "../utils/bufferedwriter.hpp"
+
+// export of the edges of a solid as a mesh, to a file or in memory, vertices having
+// exactly the same coordinates are written once and the edges refer to them by index:
+//    - OBJ: "v x y z" and "l i j" lines, streamed in a single pass
+//    - PLY: binary little endian, vertex and edge elements
+// import of the edges of an OBJ ("v", "l" and "f" lines) or binary PLY (vertex,
+// edge and face elements) file: the file is memory mapped and parsed in
+// parallel chunks, each edge shared by several faces is kept once
+class MeshIO {
+public:
+    enum class FORMAT {OBJ, PLY};
+
+private:
+    static bool read_obj(const char *begin, const char *end, Solid3d &solid, std::string &error, const unsigned threads);
+    static bool read_ply(const char *begin, const char *end, Solid3d &solid, std::string &error, const unsigned threads);
+    static void write_obj(const Solid3d &solid, BufferedWriter &out);
+    static void write_ply(const Solid3d &solid, BufferedWriter &out);
+
+public:
+    static bool write(const Solid3d &solid, const std::string &path, const FORMAT format, uint64_t *bytes = nullptr);
+    static bool write_obj(const Solid3d &solid, const std::string &path, uint64_t *bytes = nullptr);
+    static bool write_ply(const Solid3d &solid, const std::string &path, uint64_t *bytes = nullptr);
+    static void write(const Solid3d &solid, std::vector<char> &memory, const FORMAT format);
+    static bool read(const std::string &path, Solid3d &solid, std::string &error, unsigned threads = 0);
+    static const char* get_extension(const FORMAT format) { return format == FORMAT::OBJ ? "obj" : "ply"; }
+};
+
+#endif
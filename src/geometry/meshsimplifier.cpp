@@ -0,0 +1,352 @@
+#include "meshsimplifier.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include "exactsolid3d.hpp"
+
+#define NO_EDGE UINT32_MAX
+
+// exact identity of a vertex: the bits of its coordinates (with -0 == 0)
+static LatticePoint get_bits(const Vector3d &v) {
+    LatticePoint bits;
+    const double coordinates[3] = {v.get<0>() + 0.0, v.get<1>() + 0.0, v.get<2>() + 0.0};
+
+    memcpy(&bits.x, &coordinates[0], 8);
+    memcpy(&bits.y, &coordinates[1], 8);
+    memcpy(&bits.z, &coordinates[2], 8);
+
+    return bits;
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// squared distance to the plane ax + by + cz + d = 0, (a, b, c) being unit
+MeshSimplifier::Quadric::Quadric(const double a, const double b, const double c, const double d) {
+    q[0] = a * a; q[1] = a * b; q[2] = a * c; q[3] = a * d;
+    q[4] = b * b; q[5] = b * c; q[6] = b * d;
+    q[7] = c * c; q[8] = c * d;
+    q[9] = d * d;
+}
+
+// the vertices are welded on the bits of their coordinates, the edges linked around them once
+// each, then every vertex gets the quadric of its faces or, without faces, of its edges
+MeshSimplifier::MeshSimplifier(const Solid3d &shape) : center(shape.center), edge_count(0), clock(0), error(0.0) {
+    std::unordered_map<LatticePoint, uint32_t, LatticePointHash> indices;
+    indices.reserve(shape.edges.size());
+
+    auto get_index = [&](const Vector3d &v) {
+        auto inserted = indices.emplace(get_bits(v), static_cast<uint32_t>(colors.size()));
+
+        if (inserted.second) {
+            positions.insert(positions.end(), {v.get<0>(), v.get<1>(), v.get<2>()});
+            colors.push_back(v.get_color());
+        }
+
+        return inserted.first -> second;
+    };
+
+    std::vector<uint32_t> ends(2 * shape.edges.size());
+    links.reserve(shape.edges.size());
+    for (size_t i = 0; i < shape.edges.size(); ++i) {
+        const uint32_t a = get_index(shape.edges[i].a);
+        const uint32_t b = get_index(shape.edges[i].b);
+        ends[2 * i] = a;
+        ends[2 * i + 1] = b;
+        heads.resize(colors.size(), NO_EDGE);
+
+        if (a == b)
+            continue;
+
+        bool known = false;
+        for_each_edge(a, [&](const uint32_t, const uint32_t w) { known = known || w == b; });
+        if (known)
+            continue;
+
+        const uint32_t e = static_cast<uint32_t>(links.size());
+        links.push_back(Link{{a, b}, {heads[a], heads[b]}});
+        heads[a] = e;
+        heads[b] = e;
+        removed.push_back(0);
+    }
+    edge_count = links.size();
+    dirty.assign(links.size(), 0);
+
+    const size_t vertex_count = colors.size();
+    quadrics.resize(vertex_count);
+    marks.assign(vertex_count, 0);
+
+    if (! shape.faces.empty()) {
+        std::vector<uint32_t> face_vertices;
+
+        for (const auto &face : shape.faces) {
+            const double norm = face.normal.norm();
+            if (! (norm > 0))
+                continue;
+
+            const Vector3d n = face.normal * (1.0 / norm);
+            const Quadric plane(n.get<0>(), n.get<1>(), n.get<2>(), -(n * face.centroid));
+
+            face_vertices.clear();
+            for (const uint32_t i : face.edges)
+                face_vertices.insert(face_vertices.end(), {ends[2 * i], ends[2 * i + 1]});
+            std::sort(face_vertices.begin(), face_vertices.end());
+            face_vertices.erase(std::unique(face_vertices.begin(), face_vertices.end()), face_vertices.end());
+
+            for (const uint32_t v : face_vertices)
+                quadrics[v] += plane;
+        }
+    }
+    else {
+        // squared distance to the line of the edge: |x - p|^2 - (d.(x - p))^2, d being unit
+        for (const auto &link : links) {
+            const double *p = &positions[3 * link.ends[0]];
+            const double *r = &positions[3 * link.ends[1]];
+            double d[3] = {r[0] - p[0], r[1] - p[1], r[2] - p[2]};
+            const double length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            if (! (length > 0))
+                continue;
+            for (unsigned c = 0; c < 3; ++c)
+                d[c] /= length;
+
+            Quadric line;
+            const double a[3][3] = {{1 - d[0] * d[0],    -d[0] * d[1],    -d[0] * d[2]},
+                                    {   -d[1] * d[0], 1 - d[1] * d[1],    -d[1] * d[2]},
+                                    {   -d[2] * d[0],    -d[2] * d[1], 1 - d[2] * d[2]}};
+            double b[3];
+            for (unsigned c = 0; c < 3; ++c)
+                b[c] = -(a[c][0] * p[0] + a[c][1] * p[1] + a[c][2] * p[2]);
+
+            line.q[0] = a[0][0]; line.q[1] = a[0][1]; line.q[2] = a[0][2]; line.q[3] = b[0];
+            line.q[4] = a[1][1]; line.q[5] = a[1][2]; line.q[6] = b[1];
+            line.q[7] = a[2][2]; line.q[8] = b[2];
+            line.q[9] = -(p[0] * b[0] + p[1] * b[1] + p[2] * b[2]);
+
+            quadrics[link.ends[0]] += line;
+            quadrics[link.ends[1]] += line;
+        }
+    }
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric &other) {
+    for (unsigned i = 0; i < 10; ++i)
+        q[i] += other.q[i];
+
+    return *this;
+}
+
+// sum of the squared distances of (x, y, z) to the planes or lines of the quadric
+double MeshSimplifier::Quadric::get_error(const double x, const double y, const double z) const {
+    const double e = q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+                   + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+                   + q[7] * z * z + 2 * q[8] * z
+                   + q[9];
+
+    return std::max(0.0, e);
+}
+
+// calls f(edge, other end) for the edges around v, unlinking the removed ones met on the
+// way, returns the last edge of the list or NO_EDGE
+template <typename F>
+uint32_t MeshSimplifier::for_each_edge(const uint32_t v, F f) {
+    uint32_t *slot = &heads[v];
+    uint32_t last = NO_EDGE;
+
+    while (*slot != NO_EDGE) {
+        const uint32_t e = *slot;
+        Link &link = links[e];
+        const unsigned side = link.ends[0] == v ? 0 : 1;
+
+        if (removed[e]) {
+            *slot = link.next[side];
+            continue;
+        }
+
+        f(e, link.ends[1 - side]);
+        last = e;
+        slot = &link.next[side];
+    }
+
+    return last;
+}
+
+// the point minimizing the quadric of both ends, solved by Cramer's rule; a singular system
+// (flat or straight neighborhood) or a point beyond the edge falls back to the best of both
+// ends and the midpoint
+double MeshSimplifier::get_collapse(const uint32_t e, double *point) const {
+    const Link &link = links[e];
+    Quadric sum = quadrics[link.ends[0]];
+    sum += quadrics[link.ends[1]];
+    const double *q = sum.q;
+    const double *p = &positions[3 * link.ends[0]];
+    const double *r = &positions[3 * link.ends[1]];
+    const double middle[3] = {(p[0] + r[0]) / 2, (p[1] + r[1]) / 2, (p[2] + r[2]) / 2};
+    const double length2 = (r[0] - p[0]) * (r[0] - p[0]) + (r[1] - p[1]) * (r[1] - p[1]) + (r[2] - p[2]) * (r[2] - p[2]);
+
+    const double c00 = q[4] * q[7] - q[5] * q[5], c01 = q[2] * q[5] - q[1] * q[7], c02 = q[1] * q[5] - q[2] * q[4];
+    const double c11 = q[0] * q[7] - q[2] * q[2], c12 = q[1] * q[2] - q[0] * q[5], c22 = q[0] * q[4] - q[1] * q[1];
+    const double det = q[0] * c00 + q[1] * c01 + q[2] * c02;
+    const double trace = q[0] + q[4] + q[7];
+
+    bool solved = false;
+    if (std::fabs(det) > 1e-9 * trace * trace * trace) {
+        const double b[3] = {-q[3], -q[6], -q[8]};
+        point[0] = (c00 * b[0] + c01 * b[1] + c02 * b[2]) / det;
+        point[1] = (c01 * b[0] + c11 * b[1] + c12 * b[2]) / det;
+        point[2] = (c02 * b[0] + c12 * b[1] + c22 * b[2]) / det;
+
+        const double offset2 = (point[0] - middle[0]) * (point[0] - middle[0]) + (point[1] - middle[1]) * (point[1] - middle[1]) + (point[2] - middle[2]) * (point[2] - middle[2]);
+        solved = offset2 <= length2;
+    }
+
+    if (! solved) {
+        double best = INFINITY;
+        for (const double *candidate : {middle, p, r}) {
+            const double candidate_error = sum.get_error(candidate[0], candidate[1], candidate[2]);
+            if (candidate_error < best) {
+                best = candidate_error;
+                std::copy(candidate, candidate + 3, point);
+            }
+        }
+    }
+
+    return sum.get_error(point[0], point[1], point[2]);
+}
+
+// the end nearest to point is kept there, the other one is removed and its edges moved to
+// the kept end, an edge to a vertex the kept end already reaches (a triangle around the
+// collapsed edge) being removed as well; the errors of the edges left around the kept end
+// are only computed again when they reach the top of the heap
+void MeshSimplifier::collapse(const uint32_t e, const double *point) {
+    const Link &link = links[e];
+    const double *p = &positions[3 * link.ends[0]];
+    const double *r = &positions[3 * link.ends[1]];
+    const double dp = (point[0] - p[0]) * (point[0] - p[0]) + (point[1] - p[1]) * (point[1] - p[1]) + (point[2] - p[2]) * (point[2] - p[2]);
+    const double dr = (point[0] - r[0]) * (point[0] - r[0]) + (point[1] - r[1]) * (point[1] - r[1]) + (point[2] - r[2]) * (point[2] - r[2]);
+    const uint32_t u = dp <= dr ? link.ends[0] : link.ends[1];
+    const uint32_t v = dp <= dr ? link.ends[1] : link.ends[0];
+
+    std::copy(point, point + 3, &positions[3 * u]);
+    quadrics[u] += quadrics[v];
+
+    const uint32_t stamp = ++clock;
+    const uint32_t tail = for_each_edge(u, [&](const uint32_t, const uint32_t w) { marks[w] = stamp; });
+
+    // the edges of v still needed, chained around u in their order around v
+    uint32_t moved_head = NO_EDGE, moved_tail = NO_EDGE;
+    for (uint32_t f = heads[v]; f != NO_EDGE; ) {
+        Link &moved = links[f];
+        const unsigned side = moved.ends[0] == v ? 0 : 1;
+        const uint32_t next = moved.next[side];
+
+        if (! removed[f]) {
+            const uint32_t w = moved.ends[1 - side];
+            if (w == u || marks[w] == stamp) {
+                removed[f] = 1;
+                edge_count--;
+            }
+            else {
+                marks[w] = stamp;
+                moved.ends[side] = u;
+                moved.next[side] = NO_EDGE;
+                if (moved_tail == NO_EDGE)
+                    moved_head = f;
+                else
+                    links[moved_tail].next[links[moved_tail].ends[0] == u ? 0 : 1] = f;
+                moved_tail = f;
+            }
+        }
+
+        f = next;
+    }
+    heads[v] = NO_EDGE;
+
+    if (tail == NO_EDGE)
+        heads[u] = moved_head;
+    else
+        links[tail].next[links[tail].ends[0] == u ? 0 : 1] = moved_head;
+
+    for_each_edge(u, [&](const uint32_t f, const uint32_t) { dirty[f] = 1; });
+}
+
+// collapses edges until at most target_edges remain (0: no target) or the next collapse would
+// move the shape by more than max_error (0: no bound), returns false if cancel was set
+bool MeshSimplifier::simplify(const size_t target_edges, const double max_error, const std::atomic_bool &cancel) {
+    if (target_edges == 0 && ! (max_error > 0))
+        return true;
+
+    heap.clear();
+    heap.reserve(edge_count);
+    for (uint32_t e = 0; e < links.size(); ++e) {
+        if (! removed[e]) {
+            double point[3];
+            const double collapse_error = get_collapse(e, point);
+            heap.push_back(Collapse{static_cast<float>(collapse_error), e});
+            dirty[e] = 0;
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<Collapse>());
+
+    size_t steps = 0;
+    while (edge_count > target_edges && ! heap.empty()) {
+        if ((++steps & 0xfff) == 0 && cancel)
+            return false;
+
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Collapse>());
+        const Collapse c = heap.back();
+        heap.pop_back();
+        if (removed[c.edge])
+            continue;
+
+        // lazy update of the queue: an edge whose ends moved is collapsed if it is still the
+        // cheapest, otherwise it waits for its turn again (the quadrics only add up, so most
+        // errors went up)
+        double point[3];
+        const double collapse_error = get_collapse(c.edge, point);
+        if (dirty[c.edge]) {
+            dirty[c.edge] = 0;
+            if (! heap.empty() && collapse_error > static_cast<double>(heap.front().error)) {
+                heap.push_back(Collapse{static_cast<float>(collapse_error), c.edge});
+                std::push_heap(heap.begin(), heap.end(), std::greater<Collapse>());
+                continue;
+            }
+        }
+
+        // the error sums squared distances, each of them is at most that sum
+        if (max_error > 0 && collapse_error > max_error * max_error)
+            break;
+
+        error = std::max(error, std::sqrt(collapse_error));
+        collapse(c.edge, point);
+    }
+
+    std::vector<Collapse>().swap(heap);
+    return ! cancel;
+}
+
+// the remaining edges in the order of the solid, without faces nor clusters
+Solid3d MeshSimplifier::get_shape() const {
+    Solid3d shape;
+    shape.edges.reserve(edge_count);
+
+    for (uint32_t e = 0; e < links.size(); ++e) {
+        if (removed[e])
+            continue;
+
+        const uint32_t a = links[e].ends[0], b = links[e].ends[1];
+        shape.add_segment(Segment3d(Vector3d(positions[3 * a], positions[3 * a + 1], positions[3 * a + 2], colors[a]),
+                                    Vector3d(positions[3 * b], positions[3 * b + 1], positions[3 * b + 2], colors[b])));
+    }
+    shape.center = center;
+
+    return shape;
+}
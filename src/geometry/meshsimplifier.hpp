@@ -0,0 +1,70 @@
+#ifndef MESHSIMPLIFIER_HPP
+#define MESHSIMPLIFIER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "solid3d.hpp"
+
+// lighter copy of a solid for the display, by edge collapses in order of their quadric error
+// (Garland and Heckbert): every vertex carries the sum of the squared distances to the planes
+// of the faces around it (to the lines of its edges when the faces are not known), a collapse
+// moves the two ends of an edge to the point minimizing the sum of their quadrics and the
+// cheapest collapse is done first. The edges stay in the order of the solid, so that the
+// spatial order and the clusters still hold, the faces are dropped
+class MeshSimplifier {
+private:
+    // symmetric 4x4 matrix: xx, xy, xz, xw, yy, yz, yw, zz, zw, ww
+    struct Quadric {
+        double q[10];
+
+        Quadric() : q() {}
+        Quadric(const double a, const double b, const double c, const double d);
+        Quadric& operator+=(const Quadric &other);
+        double get_error(const double x, const double y, const double z) const;
+    };
+
+    // edge linked in the lists of both its ends: next[i] follows it around ends[i]
+    struct Link {
+        uint32_t ends[2];
+        uint32_t next[2];
+    };
+
+    // candidate collapse, one per edge in the heap, whose order needs no more than a float
+    struct Collapse {
+        float error;
+        uint32_t edge;
+
+        bool operator>(const Collapse &c) const { return error > c.error; }
+    };
+
+    std::vector<double> positions;    // 3 per vertex
+    std::vector<sf::Color> colors;
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> heads;      // first edge around each vertex
+    std::vector<uint32_t> marks;      // neighbors of the vertex kept by the current collapse
+    std::vector<Link> links;
+    std::vector<unsigned char> removed;
+    std::vector<unsigned char> dirty; // an end moved since the error in the heap was computed
+    std::vector<Collapse> heap;
+    Vector3d center;
+    size_t edge_count;
+    uint32_t clock;                   // collapses done, marks the neighbors of each one
+    double error;                     // largest distance bound of the collapses done
+
+    template <typename F> uint32_t for_each_edge(const uint32_t v, F f);
+    double get_collapse(const uint32_t e, double *point) const;
+    void collapse(const uint32_t e, const double *point);
+
+public:
+    // constructors
+    explicit MeshSimplifier(const Solid3d &shape);
+
+    // others
+    bool simplify(const size_t target_edges, const double max_error, const std::atomic_bool &cancel);
+    size_t get_edge_count() const { return edge_count; }
+    double get_error() const { return error; }
+    Solid3d get_shape() const;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "occlusion.hpp"
+#include "solid3d.hpp"
+#include "camera3d.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// rasterize the front faces of occluders seen from camera and rebuild the hierarchy
+void OcclusionBuffer::update(const Solid3d &occluders, const Camera3d &camera, const unsigned _window_width, const unsigned _window_height) {
+	window_width  = _window_width;
+	window_height = _window_height;
+
+	widths.assign(1, (window_width  + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+	heights.assign(1, (window_height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE);
+	levels.resize(1);
+	levels[0].assign(widths[0] * heights[0], std::numeric_limits<float>::max());
+
+	std::vector<Vector3d> loop;
+	for (const auto &f : occluders.faces) {
+		if (! f.is_front_facing(camera.get_position()))
+			continue;
+
+		loop.clear();
+		for (size_t i = 0; i < f.edges.size(); ++i)
+			loop.push_back(camera.transform_vector(Face3d::get_shared_vertex(occluders.edges[f.edges[i]], occluders.edges[f.edges[(i + 1) % f.edges.size()]])));
+
+		rasterize(loop);
+	}
+
+	dilate();
+	build_hierarchy();
+}
+
+// loop: convex polygon in camera coordinates, written with the depth of its farthest
+// vertex in every texel whose center it covers
+void OcclusionBuffer::rasterize(const std::vector<Vector3d> &loop) {
+	if (loop.size() < 3)
+		return;
+
+	float depth = 0;
+	for (const auto &p : loop) {
+		if (p.z < OCCLUSION_NEAR_DEPTH)
+			return;
+		depth = std::max(depth, static_cast<float>(p.z));
+	}
+
+	// texel coordinates of the projected polygon, texel (i, j) is centered on (i + 0.5, j + 0.5)
+	px.resize(loop.size());
+	py.resize(loop.size());
+	double min_x = std::numeric_limits<double>::max(), max_x = - min_x;
+	double min_y = min_x, max_y = - min_x;
+	double area = 0;
+	for (size_t i = 0; i < loop.size(); ++i) {
+		px[i] = (PROJECTION_FACTOR * loop[i].x / loop[i].z + window_width  / 2.0) / OCCLUSION_TILE_SIZE - 0.5;
+		py[i] = (PROJECTION_FACTOR * loop[i].y / loop[i].z + window_height / 2.0) / OCCLUSION_TILE_SIZE - 0.5;
+		min_x = std::min(min_x, px[i]); max_x = std::max(max_x, px[i]);
+		min_y = std::min(min_y, py[i]); max_y = std::max(max_y, py[i]);
+	}
+	for (size_t i = 0; i < loop.size(); ++i) {
+		size_t j = (i + 1) % loop.size();
+		area += px[i] * py[j] - px[j] * py[i];
+	}
+	if (std::abs(area) < OCCLUSION_MIN_AREA)
+		return;
+	const double side = area > 0 ? 1 : -1;
+
+	const int x0 = static_cast<int>(std::ceil(std::max(0.0, min_x)));
+	const int y0 = static_cast<int>(std::ceil(std::max(0.0, min_y)));
+	const int x1 = static_cast<int>(std::floor(std::min(widths[0]  - 1.0, max_x)));
+	const int y1 = static_cast<int>(std::floor(std::min(heights[0] - 1.0, max_y)));
+
+	for (int y = y0; y <= y1; ++y)
+		for (int x = x0; x <= x1; ++x) {
+			bool inside = true;
+			for (size_t i = 0; i < loop.size() && inside; ++i) {
+				size_t j = (i + 1) % loop.size();
+				inside = side * ((px[j] - px[i]) * (y - py[i]) - (py[j] - py[i]) * (x - px[i])) >= 0;
+			}
+
+			if (inside) {
+				float &texel = levels[0][y * widths[0] + x];
+				texel = std::min(texel, depth);
+			}
+		}
+}
+
+// texels are only sampled at their center: every texel takes the farthest depth of its
+// 3 x 3 neighbourhood, so that texels on the silhouette, partly uncovered, become uncovered
+// and the depth of the faces partly covering a texel without covering its center is bounded
+void OcclusionBuffer::dilate() {
+	const unsigned width = widths[0], height = heights[0];
+	std::vector<float> &depths = levels[0];
+
+	dilated.resize(depths.size());
+	for (unsigned y = 0; y < height; ++y)
+		for (unsigned x = 0; x < width; ++x) {
+			float depth = depths[y * width + x];
+			for (unsigned v = (y > 0 ? y - 1 : y); v <= std::min(y + 1, height - 1); ++v)
+				for (unsigned u = (x > 0 ? x - 1 : x); u <= std::min(x + 1, width - 1); ++u)
+					depth = std::max(depth, depths[v * width + u]);
+			dilated[y * width + x] = depth;
+		}
+
+	depths.swap(dilated);
+}
+
+// missing children on odd borders count as uncovered
+void OcclusionBuffer::build_hierarchy() {
+	while (widths.back() > 1 || heights.back() > 1) {
+		const std::vector<float> &fine = levels.back();
+		const unsigned fine_width = widths.back(), fine_height = heights.back();
+		const unsigned width = (fine_width + 1) / 2, height = (fine_height + 1) / 2;
+
+		std::vector<float> coarse(width * height);
+		for (unsigned y = 0; y < height; ++y)
+			for (unsigned x = 0; x < width; ++x) {
+				float depth = fine[2 * y * fine_width + 2 * x];
+				depth = std::max(depth, 2 * x + 1 < fine_width  ? fine[2 * y * fine_width + 2 * x + 1]       : std::numeric_limits<float>::max());
+				depth = std::max(depth, 2 * y + 1 < fine_height ? fine[(2 * y + 1) * fine_width + 2 * x]     : std::numeric_limits<float>::max());
+				depth = std::max(depth, 2 * x + 1 < fine_width && 2 * y + 1 < fine_height ? fine[(2 * y + 1) * fine_width + 2 * x + 1] : std::numeric_limits<float>::max());
+				coarse[y * width + x] = depth;
+			}
+
+		levels.push_back(coarse);
+		widths.push_back(width);
+		heights.push_back(height);
+	}
+}
+
+// screen rectangle in window pixels, depth of its nearest point: the level where the
+// rectangle spans at most 2 x 2 texels is read, parts out of the window are clipped anyway
+bool OcclusionBuffer::is_occluded(double min_x, double min_y, double max_x, double max_y, const double depth) const {
+	if (levels.empty() || max_x < 0 || max_y < 0 || min_x >= window_width || min_y >= window_height)
+		return false;
+
+	const unsigned x0 = static_cast<unsigned>(std::max(0.0, min_x)) / OCCLUSION_TILE_SIZE;
+	const unsigned y0 = static_cast<unsigned>(std::max(0.0, min_y)) / OCCLUSION_TILE_SIZE;
+	const unsigned x1 = static_cast<unsigned>(std::min(max_x, window_width  - 1.0)) / OCCLUSION_TILE_SIZE;
+	const unsigned y1 = static_cast<unsigned>(std::min(max_y, window_height - 1.0)) / OCCLUSION_TILE_SIZE;
+
+	unsigned l = 0;
+	while ((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1)
+		++l;
+
+	for (unsigned y = y0 >> l; y <= y1 >> l; ++y)
+		for (unsigned x = x0 >> l; x <= x1 >> l; ++x)
+			if (static_cast<double>(levels[l][y * widths[l] + x]) * (1 + OCCLUSION_DEPTH_BIAS) >= depth)
+				return false;
+
+	return true;
+}
+
+// s in camera coordinates (see Camera3d::transform_segment())
+bool OcclusionBuffer::is_occluded(const Segment3d &s) const {
+	if (s.a.z < OCCLUSION_NEAR_DEPTH || s.b.z < OCCLUSION_NEAR_DEPTH)
+		return false;
+
+	const double ax = PROJECTION_FACTOR * s.a.x / s.a.z + window_width  / 2.0;
+	const double ay = PROJECTION_FACTOR * s.a.y / s.a.z + window_height / 2.0;
+	const double bx = PROJECTION_FACTOR * s.b.x / s.b.z + window_width  / 2.0;
+	const double by = PROJECTION_FACTOR * s.b.y / s.b.z + window_height / 2.0;
+
+	return is_occluded(std::min(ax, bx), std::min(ay, by), std::max(ax, bx), std::max(ay, by), std::min(s.a.z, s.b.z));
+}
+
+// the projection of the box is bounded by the one of its 8 corners when they are all in front of the camera
+bool OcclusionBuffer::is_occluded(const EdgeCluster &cluster, const Camera3d &camera) const {
+	double min_x = std::numeric_limits<double>::max(), max_x = - min_x;
+	double min_y = min_x, max_y = - min_x;
+	double depth = min_x;
+
+	for (unsigned i = 0; i < 8; ++i) {
+		Vector3d corner = camera.transform_vector(Vector3d(i & 1 ? cluster.max.x : cluster.min.x,
+		                                                   i & 2 ? cluster.max.y : cluster.min.y,
+		                                                   i & 4 ? cluster.max.z : cluster.min.z));
+		if (corner.z < OCCLUSION_NEAR_DEPTH)
+			return false;
+
+		const double x = PROJECTION_FACTOR * corner.x / corner.z + window_width  / 2.0;
+		const double y = PROJECTION_FACTOR * corner.y / corner.z + window_height / 2.0;
+		min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+		min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+		depth = std::min(depth, corner.z);
+	}
+
+	return is_occluded(min_x, min_y, max_x, max_y, depth);
+}
@@ -0,0 +1,53 @@
+#ifndef OCCLUSION_HPP
+#define OCCLUSION_HPP
+
+#include <cstdint>
+#include <vector>
+#include "vector3d.hpp"
+#include "segment3d.hpp"
+
+#define OCCLUSION_TILE_SIZE    4    // window pixels per texel of the depth buffer
+#define OCCLUSION_NEAR_DEPTH   1.0  // geometry closer than this to the camera is never culled nor occluding
+#define OCCLUSION_DEPTH_BIAS   0.01 // relative depth margin before something is considered behind
+#define OCCLUSION_CLUSTER_SIZE 64   // consecutive edges sharing a bounding box
+#define OCCLUSION_MIN_AREA     1e-9 // texels (twice the area), a smaller face has no reliable winding and is skipped
+
+class Solid3d;
+class Camera3d;
+
+// world bounding box of the edges [begin, end) of a solid
+struct EdgeCluster {
+	Vector3d min, max;
+	uint32_t begin, end;
+};
+
+// low resolution depth buffer of the faces turned towards the camera, with a
+// max-depth mip hierarchy: level l + 1 holds the farthest depth of 2 x 2 texels
+// of level l, uncovered texels are infinitely far
+// a texel receives the farthest depth of the faces around it (see dilate()), so
+// an edge whose nearest point is behind every texel under its screen bounds is
+// hidden and can be rejected before clipping and projection
+class OcclusionBuffer {
+private:
+	unsigned window_width, window_height;
+	std::vector<unsigned> widths, heights;
+	std::vector<std::vector<float>> levels;
+	std::vector<double> px, py;  // scratch of rasterize()
+	std::vector<float> dilated; // scratch of dilate()
+
+	void rasterize(const std::vector<Vector3d> &loop);
+	void dilate();
+	void build_hierarchy();
+	bool is_occluded(double min_x, double min_y, double max_x, double max_y, const double depth) const;
+
+public:
+	// constructors
+	OcclusionBuffer() : window_width(0), window_height(0) {}
+
+	// others
+	void update(const Solid3d &occluders, const Camera3d &camera, const unsigned _window_width, const unsigned _window_height);
+	bool is_occluded(const Segment3d &s) const;
+	bool is_occluded(const EdgeCluster &cluster, const Camera3d &camera) const;
+};
+
+#endif
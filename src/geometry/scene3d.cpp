@@ -0,0 +1,135 @@
+#include "scene3d.hpp"
+#include "../utils/scheduler.hpp"
+#include <cstring>
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// objects are the solids then the instances
+const Solid3d& Scene3d::get_geometry(const size_t object) const {
+	return object < solids.size() ? *solids[object] : *instances[object - solids.size()].get_geometry();
+}
+
+size_t Scene3d::get_edge_count() const {
+	size_t count = 0;
+
+	for (size_t object = 0; object < solids.size() + instances.size(); ++object)
+		count += get_geometry(object).edges.size();
+
+	return count;
+}
+
+void Scene3d::build_figure(sf::VertexArray &target, const std::vector<Viewport> &viewports, const bool hidden_lines, bool parallel) {
+	const size_t objects = solids.size() + instances.size();
+	const size_t views = viewports.size();
+
+	// world-space work, done once whatever the number of viewports
+	bounds.resize(objects);
+	for (size_t object = 0; object < objects; ++object) {
+		if (object < solids.size())
+			solids[object] -> get_bounding_sphere(bounds[object].center, bounds[object].radius);
+		else
+			instances[object - solids.size()].get_bounding_sphere(bounds[object].center, bounds[object].radius);
+	}
+
+	// chunks of the objects in view and their slice of the buffer
+	tasks.clear();
+	in_view.assign(objects * views, 0);
+	size_t vertices = 0;
+	for (size_t viewport = 0; viewport < views; ++viewport) {
+		const Camera3d &camera = viewports[viewport].camera;
+
+		for (size_t object = 0; object < objects; ++object) {
+			if (! camera.is_sphere_in_frustrum(camera.transform_vector(bounds[object].center), bounds[object].radius))
+				continue;
+
+			in_view[object * views + viewport] = 1;
+			const size_t edges = get_geometry(object).edges.size();
+			for (size_t begin = 0; begin < edges; begin += SCENE_CHUNK_SIZE) {
+				size_t end = std::min(edges, begin + SCENE_CHUNK_SIZE);
+				tasks.push_back({object, viewport, begin, end, vertices, 0});
+				vertices += 2 * (end - begin);
+			}
+		}
+	}
+
+	if (tasks.empty()) {
+		target.clear();
+		return;
+	}
+
+	target.resize(vertices);
+	visibilities.resize(objects * views);
+
+	// frame tasks of the scheduler, which the calling thread takes part in
+	parallel = parallel && vertices >= 2 * SCENE_PARALLEL_EDGES;
+	Scheduler &scheduler = Scheduler::get();
+
+	// the faces of every object in view are tested first, then the chunks are projected
+	sf::Vertex *buffer = &target[0];
+
+	auto test_faces = [&](const size_t begin, const size_t end) {
+		for (size_t pair = begin; pair < end; ++pair) {
+			const size_t object = pair / views;
+			const Camera3d &camera = viewports[pair % views].camera;
+			const Solid3d &geometry = get_geometry(object);
+
+			visibilities[pair].clear();
+			if (in_view[pair] && ! geometry.faces.empty())
+				geometry.get_edge_visibility(object < solids.size() ? camera.get_position() : instances[object - solids.size()].get_viewpoint(camera), visibilities[pair]);
+		}
+	};
+
+	auto project = [&](const size_t begin, const size_t end) {
+		for (size_t t = begin; t < end; ++t) {
+			Task &task = tasks[t];
+			const Viewport &viewport = viewports[task.viewport];
+			const std::vector<unsigned char> &visibility = visibilities[task.object * views + task.viewport];
+			const unsigned char *edge_visibility = hidden_lines && ! visibility.empty() ? visibility.data() : nullptr;
+
+			if (task.object < solids.size())
+				task.count = solids[task.object] -> write_figure(buffer + task.offset, task.begin, task.end, viewport.width, viewport.height, viewport.camera, edge_visibility, nullptr, edge_ratio);
+			else
+				task.count = instances[task.object - solids.size()].write_figure(buffer + task.offset, task.begin, task.end, viewport.width, viewport.height, viewport.camera, edge_visibility, edge_ratio);
+
+			if (viewport.left != 0 || viewport.top != 0)
+				for (size_t i = 0; i < task.count; ++i)
+					buffer[task.offset + i].position += sf::Vector2f(static_cast<float>(viewport.left), static_cast<float>(viewport.top));
+		}
+	};
+
+	if (hidden_lines) {
+		if (parallel)
+			scheduler.parallel_for(0, in_view.size(), 1, test_faces, Scheduler::PRIORITY::FRAME);
+		else
+			test_faces(0, in_view.size());
+	}
+
+	if (parallel)
+		scheduler.parallel_for(0, tasks.size(), 1, project, Scheduler::PRIORITY::FRAME);
+	else
+		project(0, tasks.size());
+
+	// pack the slices
+	size_t count = 0;
+	for (const auto &task : tasks) {
+		if (count != task.offset)
+			memmove(buffer + count, buffer + task.offset, task.count * sizeof(sf::Vertex));
+		count += task.count;
+	}
+
+	target.resize(count);
+}
+
+// single viewport covering the window, camera having its frustrum built for it
+void Scene3d::build_figure(sf::VertexArray &target, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines, const bool parallel) {
+	build_figure(target, std::vector<Viewport>(1, {camera, 0, 0, window_width, window_height}), hidden_lines, parallel);
+}
+
+// one draw call for the whole scene
+void Scene3d::render(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines) {
+	build_figure(figure, window_width, window_height, camera, hidden_lines);
+
+	window.draw(figure);
+}
@@ -0,0 +1,68 @@
+#ifndef SCENE3D_HPP
+#define SCENE3D_HPP
+
+#include <memory>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "camera3d.hpp"
+#include "solid3d.hpp"
+#include "instance3d.hpp"
+
+#define SCENE_CHUNK_SIZE     4096  // edges per task, a multiple of OCCLUSION_CLUSTER_SIZE
+#define SCENE_PARALLEL_EDGES 16384 // below this edge count the figure is built on the calling thread alone
+
+// every object of a frame, solids and instances, projected into one vertex array drawn with
+// a single call: each object is cut in chunks of edges, the chunks are processed in parallel
+// and write to disjoint slices of the shared buffer (2 vertices per edge at most), which are
+// then packed in object order
+// several viewports share the buffer: the bounding spheres of the objects are computed once
+// per frame, then only the chunks of the objects in the frustrum of a viewport are clipped and
+// projected for its camera, the frustrum bounding them to its rectangle of the window
+class Scene3d {
+public:
+	// camera drawing in a rectangle of the window, its frustrum built for width x height
+	struct Viewport {
+		Camera3d camera;
+		unsigned left, top, width, height;
+	};
+
+private:
+	// chunk of edges [begin, end) of object seen from viewport, written from vertex offset of the figure
+	struct Task {
+		size_t object, viewport, begin, end, offset, count;
+	};
+
+	struct Bounds {
+		Vector3d center;
+		double radius;
+	};
+
+public:
+	std::vector<std::shared_ptr<const Solid3d>> solids;
+	std::vector<Instance3d> instances;
+	double edge_ratio; // fraction of the edges of every object drawn, see Solid3d::get_edge_threshold()
+
+private:
+	sf::VertexArray figure;
+	std::vector<Task> tasks;                               // scratch of build_figure()
+	std::vector<Bounds> bounds;                            // world bounding sphere of each object
+	std::vector<unsigned char> in_view;                    // object in the frustrum of a viewport, object * viewports + viewport
+	std::vector<std::vector<unsigned char>> visibilities; // same index, in hidden-line mode
+
+	const Solid3d& get_geometry(const size_t object) const;
+
+public:
+	// constructors
+	Scene3d() : edge_ratio(1.0), figure(sf::Lines) {}
+
+	// others
+	void clear() { solids.clear(); instances.clear(); }
+	void add(const std::shared_ptr<const Solid3d> &solid) { solids.push_back(solid); }
+	void add(const Instance3d &instance) { instances.push_back(instance); }
+	size_t get_edge_count() const;
+	void build_figure(sf::VertexArray &target, const std::vector<Viewport> &viewports, const bool hidden_lines = false, const bool parallel = true);
+	void build_figure(sf::VertexArray &target, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines = false, const bool parallel = true);
+	void render(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines = false);
+};
+
+#endif
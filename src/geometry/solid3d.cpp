@@ -1,13 +1,71 @@
 #include "solid3d.hpp"
+#include <algorithm>
+#include <limits>
+
+// bits of x moved to every third bit: the 21 low bits of x spread over 63 bits
+static uint64_t spread_bits(uint64_t x) {
+    x &= 0x1fffff;
+    x = (x | x << 32) & UINT64_C(0x1f00000000ffff);
+    x = (x | x << 16) & UINT64_C(0x1f0000ff0000ff);
+    x = (x | x << 8)  & UINT64_C(0x100f00f00f00f00f);
+    x = (x | x << 4)  & UINT64_C(0x10c30c30c30c30c3);
+    x = (x | x << 2)  & UINT64_C(0x1249249249249249);
+    return x;
+}
+
+// position of the cell along the curve: the Z order interleaves the bits of the coordinates,
+// the Hilbert order first transforms them so that consecutive cells are always adjacent
+// (J. Skilling, "Programming the Hilbert curve", 2004)
+// cell: coordinates of bits bits
+static uint64_t get_curve_key(uint32_t cell[3], const unsigned bits, const Solid3d::CURVE curve) {
+    if (curve == Solid3d::CURVE::HILBERT) {
+        const uint32_t top = 1u << (bits - 1);
+
+        // without branches: cell[0] is inverted below bit q if bit q of cell[i] is set,
+        // otherwise the bits below q of cell[0] and cell[i] are exchanged
+        for (uint32_t q = top; q > 1; q >>= 1) {
+            const uint32_t p = q - 1;
+            for (unsigned i = 0; i < 3; ++i) {
+                const uint32_t set = 0u - ((cell[i] & q) != 0);
+                const uint32_t t = (cell[0] ^ cell[i]) & p & ~set;
+                cell[0] ^= (p & set) | t;
+                cell[i] ^= t;
+            }
+        }
+
+        for (unsigned i = 1; i < 3; ++i)
+            cell[i] ^= cell[i - 1];
+
+        uint32_t t = 0;
+        for (uint32_t q = top; q > 1; q >>= 1)
+            if (cell[2] & q)
+                t ^= q - 1;
+        for (unsigned i = 0; i < 3; ++i)
+            cell[i] ^= t;
+    }
+
+    return spread_bits(cell[0]) << 2 | spread_bits(cell[1]) << 1 | spread_bits(cell[2]);
+}
 
 // ##############################################
 // ### operators ################################
 // ##############################################
 
 Solid3d Solid3d::operator+=(const Solid3d &solid) {
+    uint32_t offset = static_cast<uint32_t>(edges.size());
+
     for (auto s : solid.edges)
         this -> add_segment(s);
 
+    for (auto f : solid.faces) {
+        for (auto &e : f.edges)
+            e += offset;
+        this -> add_face(f);
+    }
+
+    if (! clusters.empty())
+        build_clusters();
+
     return *this;
 }
 
@@ -17,6 +75,14 @@ Solid3d Solid3d::operator+(const Vector3d &v) const {
     for (auto &s : new_solid.edges)
         s += v;
 
+    for (auto &f : new_solid.faces)
+        f.centroid += v;
+
+    for (auto &c : new_solid.clusters) {
+        c.min += v;
+        c.max += v;
+    }
+
     new_solid.center += v;
 
     return new_solid;
@@ -26,6 +92,14 @@ Solid3d Solid3d::operator+=(const Vector3d &v) {
     for (auto &s : edges)
         s += v;
 
+    for (auto &f : faces)
+        f.centroid += v;
+
+    for (auto &c : clusters) {
+        c.min += v;
+        c.max += v;
+    }
+
     center += v;
 
     return *this;
@@ -41,26 +115,213 @@ void Solid3d::set_center(const Vector3d &_center) {
     center = _center;
 }
 
-// #TODO: missing comment
-void Solid3d::render_solid(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera) {
-    figure.clear();
+// an edge is hidden when all the faces it belongs to are facing away from viewpoint,
+// edges of no face are always visible
+void Solid3d::get_edge_visibility(const Vector3d &viewpoint, std::vector<unsigned char> &visibility) const {
+    visibility.assign(edges.size(), NO_FACE);
+
+    for (const auto &f : faces) {
+        unsigned char side = f.is_front_facing(viewpoint) ? FRONT_FACE : BACK_FACES;
+
+        for (auto e : f.edges)
+            visibility[e] = std::max(visibility[e], side);
+    }
+}
+
+// bounding boxes of every OCCLUSION_CLUSTER_SIZE consecutive edges, to be called once the
+// solid is not modified anymore, edges generated face after face are close to each other
+void Solid3d::build_clusters() {
+    clusters.clear();
+
+    for (size_t begin = 0; begin < edges.size(); begin += OCCLUSION_CLUSTER_SIZE) {
+        EdgeCluster c;
+        c.begin = static_cast<uint32_t>(begin);
+        c.end   = static_cast<uint32_t>(std::min(edges.size(), begin + OCCLUSION_CLUSTER_SIZE));
+        c.min   = edges[begin].a;
+        c.max   = edges[begin].a;
+
+        for (size_t i = c.begin; i < c.end; ++i)
+            for (const Vector3d *v : {&edges[i].a, &edges[i].b}) {
+                c.min = Vector3d(std::min(c.min.x, v -> x), std::min(c.min.y, v -> y), std::min(c.min.z, v -> z));
+                c.max = Vector3d(std::max(c.max.x, v -> x), std::max(c.max.y, v -> y), std::max(c.max.z, v -> z));
+            }
 
-    for (auto s : edges) {
-        bool outside_frustrum = false;
-        s = camera.transform_segment(s);
+        clusters.push_back(c);
+    }
+}
+
+// edges sorted by the cell of their midpoint along curve, on a grid over the bounding box of
+// about 512 cells per edge (2^CURVE_MAX_BITS per axis at most), so that the edges close in memory are close in space (the clusters get
+// tight and the projection streams through the edges); faces are sorted by their centroid and
+// their edge indices renumbered, the clusters are rebuilt if there were any
+void Solid3d::sort_spatially(const CURVE curve) {
+    if (curve == CURVE::NONE || edges.size() < 2)
+        return;
 
-        for (auto side : camera.frustrum) {
-            outside_frustrum = side.handle_intersection_of_segment_with_plane(s);
-            if (outside_frustrum)
-                break;
+    Vector3d min = edges[0].a, max = edges[0].a;
+    for (const auto &s : edges)
+        for (const Vector3d *v : {&s.a, &s.b}) {
+            min = Vector3d(std::min(min.x, v -> x), std::min(min.y, v -> y), std::min(min.z, v -> z));
+            max = Vector3d(std::max(max.x, v -> x), std::max(max.y, v -> y), std::max(max.z, v -> z));
         }
 
-        if (! outside_frustrum) {
-            figure.append(camera.frustrum[0].get_projection_on_plane(s.a, window_width, window_height));
-            figure.append(camera.frustrum[0].get_projection_on_plane(s.b, window_width, window_height));
+    const double extent = std::max(max.x - min.x, std::max(max.y - min.y, max.z - min.z));
+    unsigned bits = 3;
+    while (bits < CURVE_MAX_BITS && (size_t(1) << (3 * (bits - 3))) < edges.size())
+        bits++;
+    const double scale = extent > 0 ? ((1u << bits) - 1) / extent : 0.0;
+    auto get_key = [&](const double x, const double y, const double z) {
+        uint32_t cell[3] = {static_cast<uint32_t>((x - min.x) * scale), static_cast<uint32_t>((y - min.y) * scale), static_cast<uint32_t>((z - min.z) * scale)};
+        return get_curve_key(cell, bits, curve);
+    };
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i)
+        keys[i] = {get_key((edges[i].a.x + edges[i].b.x) * 0.5, (edges[i].a.y + edges[i].b.y) * 0.5, (edges[i].a.z + edges[i].b.z) * 0.5), static_cast<uint32_t>(i)};
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Segment3d> sorted;
+    sorted.reserve(edges.size());
+    std::vector<uint32_t> index(edges.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        sorted.push_back(edges[keys[i].second]);
+        index[keys[i].second] = static_cast<uint32_t>(i);
+    }
+    edges.swap(sorted);
+
+    keys.resize(faces.size());
+    for (size_t f = 0; f < faces.size(); ++f) {
+        const Vector3d &c = faces[f].centroid;
+        keys[f] = {get_key(std::min(std::max(c.x, min.x), max.x), std::min(std::max(c.y, min.y), max.y), std::min(std::max(c.z, min.z), max.z)), static_cast<uint32_t>(f)};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Face3d> sorted_faces;
+    sorted_faces.reserve(faces.size());
+    for (const auto &key : keys) {
+        sorted_faces.push_back(std::move(faces[key.second]));
+        for (auto &e : sorted_faces.back().edges)
+            e = index[e];
+    }
+    faces.swap(sorted_faces);
+
+    if (! clusters.empty())
+        build_clusters();
+}
+
+// sphere around the box of the clusters, or of the edges when they have not been clustered
+void Solid3d::get_bounding_sphere(Vector3d &sphere_center, double &radius) const {
+    Vector3d min(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Vector3d max = - min;
+
+    auto extend = [&](const Vector3d &low, const Vector3d &high) {
+        min = Vector3d(std::min(min.x, low.x), std::min(min.y, low.y), std::min(min.z, low.z));
+        max = Vector3d(std::max(max.x, high.x), std::max(max.y, high.y), std::max(max.z, high.z));
+    };
+
+    if (! clusters.empty())
+        for (const auto &c : clusters)
+            extend(c.min, c.max);
+    else
+        for (const auto &s : edges) {
+            extend(s.a, s.a);
+            extend(s.b, s.b);
         }
+
+    if (edges.empty()) {
+        sphere_center = Vector3d();
+        radius = 0.0;
+        return;
+    }
+
+    sphere_center = (min + max) * 0.5;
+    radius = (max - min).norm() * 0.5;
+}
+
+// bytes allocated for the solid, heap blocks of the faces included
+size_t Solid3d::get_memory_usage() const {
+    size_t bytes = sizeof(Solid3d)
+                 + edges.capacity()    * sizeof(Segment3d)
+                 + faces.capacity()    * sizeof(Face3d)
+                 + clusters.capacity() * sizeof(EdgeCluster)
+                 + figure.getVertexCount() * sizeof(sf::Vertex);
+
+    for (const auto &f : faces)
+        bytes += f.edges.capacity() * sizeof(uint32_t) + MEMORY_BLOCK_OVERHEAD;
+
+    return bytes;
+}
+
+// every edge from a ratio of 1
+uint32_t Solid3d::get_edge_threshold(const double edge_ratio) {
+    if (edge_ratio >= 1.0)
+        return std::numeric_limits<uint32_t>::max();
+
+    return edge_ratio > 0.0 ? static_cast<uint32_t>(edge_ratio * 4294967296.0) : 0;
+}
+
+// clip the edges [begin, end) against the camera frustrum and write the projected visible parts
+// to out, at most 2 (end - begin) vertices, returns the number of vertices written
+// const so that it can be called from another thread than the one owning the window, and from
+// several threads on disjoint ranges
+// clusters (see build_clusters()) outside the frustrum are skipped as a whole
+// visibility: see get_edge_visibility(), edges between back faces are dropped before clipping
+// occlusion: clusters then edges hidden behind the faces rasterized in it are dropped before clipping
+// edge_ratio: fraction of the edges drawn, see get_edge_threshold()
+size_t Solid3d::write_figure(sf::Vertex *out, const size_t begin, const size_t end, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const unsigned char *visibility, const OcclusionBuffer *occlusion, const double edge_ratio) const {
+    const uint32_t threshold = get_edge_threshold(edge_ratio);
+    size_t count = 0;
+
+    auto write_edge = [&](const size_t i) {
+        if ((visibility && visibility[i] == BACK_FACES) || ! is_edge_kept(i, threshold))
+            return;
+
+        Segment3d s = camera.transform_segment(edges[i]);
+        if (occlusion && occlusion -> is_occluded(s))
+            return;
+
+        count += camera.write_projection(out + count, s, window_width, window_height);
+    };
+
+    auto is_cluster_visible = [&](const EdgeCluster &c) {
+        if (! camera.is_sphere_in_frustrum(camera.transform_vector((c.min + c.max) * 0.5), (c.max - c.min).norm() * 0.5))
+            return false;
+
+        return ! (occlusion && occlusion -> is_occluded(c, camera));
+    };
+
+    if (! clusters.empty()) {
+        for (size_t c = begin / OCCLUSION_CLUSTER_SIZE; c < clusters.size() && clusters[c].begin < end; ++c)
+            if (is_cluster_visible(clusters[c]))
+                for (size_t i = std::max<size_t>(begin, clusters[c].begin); i < std::min<size_t>(end, clusters[c].end); ++i)
+                    write_edge(i);
+    }
+    else {
+        for (size_t i = begin; i < end; ++i)
+            write_edge(i);
+    }
+
+    return count;
+}
+
+// whole solid in target
+void Solid3d::build_figure(sf::VertexArray &target, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines, const OcclusionBuffer *occlusion, const double edge_ratio) const {
+    if (edges.empty()) {
+        target.clear();
+        return;
     }
 
+    std::vector<unsigned char> visibility;
+    if (hidden_lines && ! faces.empty())
+        get_edge_visibility(camera.get_position(), visibility);
+
+    target.resize(2 * edges.size());
+    target.resize(write_figure(&target[0], 0, edges.size(), window_width, window_height, camera, visibility.empty() ? nullptr : visibility.data(), occlusion, edge_ratio));
+}
+
+void Solid3d::render_solid(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines) {
+    build_figure(figure, window_width, window_height, camera, hidden_lines);
+
     window.draw(figure);
 }
 
@@ -76,5 +337,13 @@ void Solid3d::rotate(const Vector3d &rotation_center, const Vector3d &axis, cons
         s.b.rotate(center_of_rotation, axis, theta);
     }
 
+    for (auto &f : faces) {
+        f.centroid.rotate(center_of_rotation, axis, theta);
+        f.normal.rotate(Vector3d(), axis, theta);
+    }
+
+    if (! clusters.empty())
+        build_clusters();
+
     center.rotate(center_of_rotation, axis, theta);
 }
@@ -6,13 +6,26 @@
 #include "segment3d.hpp"
 #include "plane3d.hpp"
 #include "camera3d.hpp"
+#include "face3d.hpp"
+#include "occlusion.hpp"
+#include "../utils/memory.hpp"
+
+#define CURVE_MAX_BITS 21 // cells per axis of the grid of sort_spatially(): at most 2^21, the keys fit in 63 bits
 
 class Solid3d {
 public:
     enum class SOLID_TYPE {CUBE, SPHERE};
 
+    // space filling curve ordering the edges, see sort_spatially()
+    enum class CURVE {NONE, MORTON, HILBERT};
+
+    // visibility of an edge for the hidden-line mode
+    enum EDGE_VISIBILITY : unsigned char {NO_FACE, BACK_FACES, FRONT_FACE};
+
 public:
     std::vector<Segment3d> edges;
+    std::vector<Face3d> faces; // empty when only the edges are known
+    std::vector<EdgeCluster> clusters; // bounding boxes of consecutive edges, see build_clusters()
     sf::VertexArray figure;
     Vector3d center;
 
@@ -28,9 +41,23 @@ public:
     // others
     void set_center(const Vector3d &_center);
     void add_segment(const Segment3d &s) { edges.push_back(s); }
-    void render_solid(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera);
-    void clear() { edges.clear(); }
+    void add_face(const Face3d &f) { faces.push_back(f); }
+    void get_edge_visibility(const Vector3d &viewpoint, std::vector<unsigned char> &visibility) const;
+    void build_clusters();
+    void sort_spatially(const CURVE curve);
+    void get_bounding_sphere(Vector3d &sphere_center, double &radius) const;
+    size_t get_memory_usage() const;
+    size_t write_figure(sf::Vertex *out, const size_t begin, const size_t end, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const unsigned char *visibility = nullptr, const OcclusionBuffer *occlusion = nullptr, const double edge_ratio = 1.0) const;
+    void build_figure(sf::VertexArray &target, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines = false, const OcclusionBuffer *occlusion = nullptr, const double edge_ratio = 1.0) const;
+    void render_solid(sf::RenderWindow &window, const unsigned window_width, const unsigned window_height, const Camera3d &camera, const bool hidden_lines = false);
+    void clear() { edges.clear(); faces.clear(); clusters.clear(); }
     void rotate(const Vector3d &rotation_center, const Vector3d &axis, const double theta, const bool object_axis = false);
+
+    // edges drawn at an edge ratio below 1: edge i is kept when its Weyl hash i * 2654435761 mod 2^32,
+    // evenly spread along the edges, is at most the threshold of the ratio, so that the edges of a
+    // ratio are a subset of those of any higher one and no edge flickers as the ratio changes
+    static uint32_t get_edge_threshold(const double edge_ratio);
+    static bool is_edge_kept(const size_t i, const uint32_t threshold) { return static_cast<uint32_t>(i * 2654435761u) <= threshold; }
 };
 
 #endif
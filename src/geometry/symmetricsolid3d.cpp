@@ -0,0 +1,188 @@
+#include "symmetricsolid3d.hpp"
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <set>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// the copies of the vertices of solid are told apart at the precision of the group, which is done
+// once for the seed, then the edges are sorted into orbits from these copies as in add_polygon(),
+// the next iterations get their orbits from getNextShape()
+SymmetricSolid3d::SymmetricSolid3d(const Solid3d &solid, const SymmetryGroup &_group) : group(_group) {
+    typedef std::pair<VertexCopy, VertexCopy> EdgeCopy;
+
+    PointIndex index(group.get_key_shift());
+    std::vector<VertexCopy> copies; // copies[i] is the i-th point of index
+    std::set<EdgeCopy> orbit_keys;  // smallest copy of each stored orbit
+
+    // a new vertex is the representative of its orbit, the rotations are tried in increasing order
+    // so that each copy is given by the smallest rotation yielding it
+    auto get_copy = [&](const Vector3d &v) {
+        const uint32_t found = index.find(v);
+        if (found != PointIndex::NONE)
+            return copies[found];
+
+        const uint32_t orbit = static_cast<uint32_t>(vertices.size());
+        uint64_t stabilizer = 0;
+        for (size_t g = 0; g < group.get_order(); ++g) {
+            const uint32_t id = index.insert(group.apply(g, v));
+            if (id == copies.size())
+                copies.push_back(VertexCopy{orbit, static_cast<uint32_t>(g)});
+            if (copies[id] == VertexCopy{orbit, 0})
+                stabilizer |= uint64_t(1) << g;
+        }
+
+        vertices.push_back(v);
+        vertex_stabilizers.push_back(stabilizer);
+        return VertexCopy{orbit, 0};
+    };
+
+    for (const auto &s : solid.edges) {
+        const VertexCopy a = get_copy(s.a), b = get_copy(s.b);
+        const EdgeCopy edge = get_image(0, a, b);
+
+        EdgeCopy key = edge;
+        uint64_t stabilizer = 0;
+        for (size_t g = 0; g < group.get_order(); ++g) {
+            const EdgeCopy image = get_image(g, a, b);
+            if (image == edge)
+                stabilizer |= uint64_t(1) << g;
+            key = std::min(key, image);
+        }
+
+        if (! orbit_keys.insert(key).second)
+            continue;
+
+        edges.push_back(s);
+        ends.push_back(std::make_pair(a, b));
+        stabilizers.push_back(stabilizer);
+        images.push_back(get_images(stabilizer));
+    }
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// the copies of an edge fixed by the rotations of stabilizer are its images by the smallest
+// rotation of each coset g * stabilizer, few stabilizers occur so their images are kept
+uint64_t SymmetricSolid3d::get_images(const uint64_t stabilizer) {
+    for (const auto &known : image_masks)
+        if (known.first == stabilizer)
+            return known.second;
+
+    uint64_t mask = 0;
+    for (size_t g = 0; g < group.get_order(); ++g) {
+        size_t smallest = g;
+        for_each_element(stabilizer, [&](const size_t t) { smallest = std::min(smallest, group.compose(g, t)); });
+        if (smallest == g)
+            mask |= uint64_t(1) << g;
+    }
+
+    image_masks.push_back(std::make_pair(stabilizer, mask));
+    return mask;
+}
+
+// image of the edge from a to b by rotation g, as canonical copies in increasing order
+std::pair<SymmetricSolid3d::VertexCopy, SymmetricSolid3d::VertexCopy> SymmetricSolid3d::get_image(const size_t g, const VertexCopy &a, const VertexCopy &b) const {
+    VertexCopy ia = get_canonical(VertexCopy{a.orbit, static_cast<uint32_t>(group.compose(g, a.element))});
+    VertexCopy ib = get_canonical(VertexCopy{b.orbit, static_cast<uint32_t>(group.compose(g, b.element))});
+    return ib < ia ? std::make_pair(ib, ia) : std::make_pair(ia, ib);
+}
+
+// same point given by the smallest rotation, the rotations fixing its vertex giving the same point
+SymmetricSolid3d::VertexCopy SymmetricSolid3d::get_canonical(const VertexCopy &c) const {
+    VertexCopy canonical = c;
+
+    for_each_element(vertex_stabilizers[c.orbit], [&](const size_t t) {
+        canonical.element = std::min(canonical.element, static_cast<uint32_t>(group.compose(c.element, t)));
+    });
+
+    return canonical;
+}
+
+Vector3d SymmetricSolid3d::get_position(const VertexCopy &c) const {
+    return Vector3d(group.apply(c.element, vertices[c.orbit]), vertices[c.orbit].get_color());
+}
+
+// edges joining the consecutive (canonical) copies of polygon, which is invariant under the
+// rotations of around: one edge per orbit of these rotations is stored, the polygons around
+// two vertices of different orbits having no edge in the same orbit. Returns the edges added
+size_t SymmetricSolid3d::add_polygon(const std::vector<VertexCopy> &polygon, const uint64_t around) {
+    typedef std::pair<VertexCopy, VertexCopy> EdgeCopy;
+
+    std::vector<EdgeCopy> orbit_keys;
+    const size_t first = edges.size();
+
+    for (size_t i = 0; i < polygon.size(); ++i) {
+        const VertexCopy &a = polygon[i];
+        const VertexCopy &b = polygon[(i + 1) % polygon.size()];
+        const EdgeCopy edge = get_image(0, a, b);
+
+        EdgeCopy key = edge;
+        uint64_t stabilizer = 0;
+        for_each_element(around, [&](const size_t s) {
+            const EdgeCopy image = get_image(s, a, b);
+            if (image == edge)
+                stabilizer |= uint64_t(1) << s;
+            key = std::min(key, image);
+        });
+
+        if (std::find(orbit_keys.begin(), orbit_keys.end(), key) != orbit_keys.end())
+            continue;
+        orbit_keys.push_back(key);
+
+        edges.push_back(Segment3d(get_position(a), get_position(b)));
+        ends.push_back(std::make_pair(a, b));
+        stabilizers.push_back(stabilizer);
+        images.push_back(get_images(stabilizer));
+    }
+
+    return edges.size() - first;
+}
+
+size_t SymmetricSolid3d::get_edge_count() const {
+    size_t count = 0;
+
+    for (auto mask : images)
+        count += std::bitset<64>(mask).count();
+
+    return count;
+}
+
+// every copy of every representative edge, for rendering and exporting
+// the copies of a vertex are welded by their canonical copy so that they have bit-identical coordinates
+Solid3d SymmetricSolid3d::expand() const {
+    Solid3d solid;
+    std::map<VertexCopy, Vector3d> welded;
+
+    auto weld = [&](const VertexCopy &c, const size_t g, const Vector3d &v) {
+        const VertexCopy image = get_canonical(VertexCopy{c.orbit, static_cast<uint32_t>(group.compose(g, c.element))});
+        return welded.emplace(image, v).first -> second;
+    };
+
+    solid.edges.reserve(get_edge_count());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        for_each_element(images[i], [&](const size_t g) {
+            Segment3d image = group.apply(g, edges[i]);
+            solid.add_segment(Segment3d(weld(ends[i].first, g, image.a), weld(ends[i].second, g, image.b)));
+        });
+    }
+
+    return solid;
+}
+
+// representatives, their ends and orbits, the group itself is negligible
+size_t SymmetricSolid3d::get_memory_usage() const {
+    return sizeof(SymmetricSolid3d)
+         + vertices.capacity() * sizeof(Vector3d)
+         + vertex_stabilizers.capacity() * sizeof(uint64_t)
+         + edges.capacity() * sizeof(Segment3d)
+         + ends.capacity() * sizeof(ends[0])
+         + images.capacity() * sizeof(uint64_t)
+         + stabilizers.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,60 @@
+#ifndef SYMMETRIC_SOLID_3D_HPP
+#define SYMMETRIC_SOLID_3D_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "solid3d.hpp"
+#include "symmetrygroup.hpp"
+
+// solid invariant under a rotation group, only one vertex and one edge per orbit are stored:
+// the full solid is {group.apply(g, edges[i]) for every g set in images[i]}, and the ends of
+// the edges are given as copies of the stored vertices, so that the next iteration is built
+// from the stored elements and the group table without expanding the solid
+class SymmetricSolid3d {
+public:
+    // the point group.apply(element, vertices[orbit])
+    struct VertexCopy {
+        uint32_t orbit;
+        uint32_t element;
+
+        bool operator==(const VertexCopy &c) const { return orbit == c.orbit && element == c.element; }
+        bool operator<(const VertexCopy &c) const { return orbit != c.orbit ? orbit < c.orbit : element < c.element; }
+    };
+
+private:
+    std::vector<std::pair<uint64_t, uint64_t>> image_masks; // images of the stabilizers met so far
+
+    uint64_t get_images(const uint64_t stabilizer);
+    std::pair<VertexCopy, VertexCopy> get_image(const size_t g, const VertexCopy &a, const VertexCopy &b) const;
+
+public:
+    SymmetryGroup group;
+    std::vector<Vector3d> vertices;                      // one representative per vertex orbit
+    std::vector<uint64_t> vertex_stabilizers;            // bit g set if rotation g fixes vertices[i]
+    std::vector<Segment3d> edges;                        // one representative per edge orbit
+    std::vector<std::pair<VertexCopy, VertexCopy>> ends; // the ends of edges[i]
+    std::vector<uint64_t> images;                        // bit g set if rotation g gives a new copy of the edge
+    std::vector<uint64_t> stabilizers;                   // bit g set if rotation g maps edges[i] onto itself
+
+public:
+    // constructors
+    SymmetricSolid3d() {}
+    SymmetricSolid3d(const Solid3d &solid, const SymmetryGroup &_group);
+
+    // others
+    VertexCopy get_canonical(const VertexCopy &c) const;
+    Vector3d get_position(const VertexCopy &c) const;
+    size_t add_polygon(const std::vector<VertexCopy> &polygon, const uint64_t around);
+    size_t get_edge_count() const;
+    Solid3d expand() const;
+    size_t get_memory_usage() const;
+
+    // f(g) for every rotation g set in mask
+    template <typename F> static void for_each_element(uint64_t mask, F f) {
+        for (; mask; mask &= mask - 1)
+            f(static_cast<size_t>(__builtin_ctzll(mask)));
+    }
+};
+
+#endif
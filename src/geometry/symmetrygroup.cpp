@@ -0,0 +1,178 @@
+#include "symmetrygroup.hpp"
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+// ##############################################
+// ### PointIndex ###############################
+// ##############################################
+
+// a point within a quarter of a cell of v is in the cell of v, or in the next one along the axes
+// where v is more than a quarter of a cell off center
+uint32_t PointIndex::find(const Vector3d &v) const {
+    const double scaled[3] = {std::ldexp(v.x, shift), std::ldexp(v.y, shift), std::ldexp(v.z, shift)};
+    int64_t low[3], high[3];
+
+    for (unsigned c = 0; c < 3; ++c) {
+        const double rounded = std::round(scaled[c]);
+        low[c] = high[c] = static_cast<int64_t>(rounded);
+        if (scaled[c] - rounded >= 0.25)
+            high[c]++;
+        if (rounded - scaled[c] >= 0.25)
+            low[c]--;
+    }
+
+    for (int64_t x = low[0]; x <= high[0]; ++x) {
+        for (int64_t y = low[1]; y <= high[1]; ++y) {
+            for (int64_t z = low[2]; z <= high[2]; ++z) {
+                const auto range = cells.equal_range(LatticePoint{x, y, z});
+                for (auto cell = range.first; cell != range.second; ++cell) {
+                    const Vector3d &p = points[cell -> second];
+                    if (std::max({std::abs(p.x - v.x), std::abs(p.y - v.y), std::abs(p.z - v.z)}) < std::ldexp(0.25, -shift))
+                        return cell -> second;
+                }
+            }
+        }
+    }
+
+    return NONE;
+}
+
+uint32_t PointIndex::insert(const Vector3d &v) {
+    const uint32_t found = find(v);
+    if (found != NONE)
+        return found;
+
+    cells.emplace(ExactSolid3d::get_lattice_point(v, shift), static_cast<uint32_t>(points.size()));
+    points.push_back(v);
+    return static_cast<uint32_t>(points.size() - 1);
+}
+
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// closure of the generators under composition
+SymmetryGroup::SymmetryGroup(const Vector3d &_center, const std::vector<Matrix3d> &generators, const int _key_shift) : center(_center), key_shift(_key_shift), rotations(1, Matrix3d::identity()) {
+    for (size_t i = 0; i < rotations.size(); ++i) {
+        for (const auto &generator : generators) {
+            Matrix3d product = generator * rotations[i];
+
+            if (std::find(rotations.begin(), rotations.end(), product) == rotations.end())
+                rotations.push_back(product);
+
+            // not a finite rotation group we can handle, keep the identity only
+            if (rotations.size() > SYMMETRY_MAX_ORDER) {
+                rotations.resize(1);
+                build_table();
+                return;
+            }
+        }
+    }
+
+    build_table();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// products and inverses by index, so that the rectification composes rotations without matrices
+void SymmetryGroup::build_table() {
+    const size_t order = rotations.size();
+    products.assign(order * order, 0);
+    inverses.assign(order, 0);
+
+    for (size_t g = 0; g < order; ++g) {
+        for (size_t h = 0; h < order; ++h) {
+            const Matrix3d product = rotations[g] * rotations[h];
+            products[g * order + h] = static_cast<uint8_t>(std::find(rotations.begin(), rotations.end(), product) - rotations.begin());
+            if (products[g * order + h] == 0)
+                inverses[g] = static_cast<uint8_t>(h);
+        }
+    }
+}
+
+Vector3d SymmetryGroup::apply(const size_t g, const Vector3d &v) const {
+    return rotations[g] * (v - center) + center;
+}
+
+Segment3d SymmetryGroup::apply(const size_t g, const Segment3d &s) const {
+    return Segment3d(apply(g, s.a), apply(g, s.b));
+}
+
+// rotations of order 2 to 6 around the axes going through the center and a
+// vertex or an edge midpoint, kept if they map the solid onto itself, then
+// closed under composition (which also yields the axes through face centers)
+SymmetryGroup SymmetryGroup::detect(const Solid3d &solid) {
+    if (solid.edges.empty())
+        return SymmetryGroup();
+
+    // the points are told apart at 2^-SYMMETRY_KEY_BITS of the size of the solid, whatever its scale
+    double size = 0;
+    for (const auto &s : solid.edges)
+        for (const Vector3d &v : {s.a, s.b})
+            size = std::max({size, std::abs(v.x - solid.edges[0].a.x), std::abs(v.y - solid.edges[0].a.y), std::abs(v.z - solid.edges[0].a.z)});
+    const int key_shift = SYMMETRY_KEY_BITS - (size > 0 ? std::ilogb(size) : 0);
+
+    PointIndex index(key_shift);
+    std::vector<Vector3d> vertices;
+    std::set<std::pair<uint32_t, uint32_t>> edges;
+
+    for (const auto &s : solid.edges) {
+        uint32_t ids[2];
+        for (unsigned i = 0; i < 2; ++i) {
+            const Vector3d &v = i ? s.b : s.a;
+            ids[i] = index.insert(v);
+            if (ids[i] == vertices.size())
+                vertices.push_back(v);
+        }
+
+        edges.insert(std::make_pair(std::min(ids[0], ids[1]), std::max(ids[0], ids[1])));
+    }
+
+    Vector3d centroid;
+    for (const auto &v : vertices)
+        centroid += v;
+    centroid *= 1.0 / vertices.size();
+
+    std::vector<Vector3d> axes;
+    for (const auto &v : vertices)
+        axes.push_back(v - centroid);
+    for (const auto &s : solid.edges)
+        axes.push_back((s.a + s.b) * 0.5 - centroid);
+
+    auto is_symmetry = [&](const Matrix3d &rotation) {
+        for (const auto &s : solid.edges) {
+            uint32_t a = index.find(rotation * (s.a - centroid) + centroid);
+            uint32_t b = index.find(rotation * (s.b - centroid) + centroid);
+
+            if (a == PointIndex::NONE || b == PointIndex::NONE || ! edges.count(std::make_pair(std::min(a, b), std::max(a, b))))
+                return false;
+        }
+
+        return true;
+    };
+
+    std::vector<Matrix3d> generators;
+    for (const auto &axis : axes) {
+        if (axis.norm() < std::ldexp(1.0, -key_shift))
+            continue;
+
+        for (unsigned order = 6; order >= 2; --order) {
+            Matrix3d rotation = Matrix3d::rotation(axis, 360.0 / order);
+
+            if (std::find(generators.begin(), generators.end(), rotation) != generators.end())
+                break;
+
+            if (is_symmetry(rotation)) {
+                generators.push_back(rotation);
+                break;
+            }
+        }
+    }
+
+    return SymmetryGroup(centroid, generators, key_shift);
+}
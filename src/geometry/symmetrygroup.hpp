@@ -0,0 +1,67 @@
+#ifndef SYMMETRY_GROUP_HPP
+#define SYMMETRY_GROUP_HPP
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "vector3d.hpp"
+#include "matrix3d.hpp"
+#include "solid3d.hpp"
+#include "exactsolid3d.hpp"
+
+#define SYMMETRY_KEY_BITS  30 // points closer than 2^-32 times the size of the solid are the same
+#define SYMMETRY_MAX_ORDER 64 // orbits are stored as 64 bits masks
+
+// points told apart up to a quarter of 2^-shift: each one is kept in the cell of its coordinates
+// rounded to multiples of 2^-shift, a lookup also visits the neighbouring cells the point is
+// close to, so that the round-off of a rotation never moves a point to another cell unnoticed
+class PointIndex {
+private:
+    int shift;
+    std::unordered_multimap<LatticePoint, uint32_t, LatticePointHash> cells;
+    std::vector<Vector3d> points;
+
+public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    // constructors
+    explicit PointIndex(const int _shift) : shift(_shift) {}
+
+    // others
+    uint32_t find(const Vector3d &v) const;
+    uint32_t insert(const Vector3d &v); // index of the point of v, added if new
+    size_t size() const { return points.size(); }
+};
+
+// finite group of rotations around center, rotations[0] is the identity
+// two points are the same for the group when a PointIndex of key_shift does not tell them apart,
+// key_shift following the size of the solid it was detected on
+class SymmetryGroup {
+private:
+    Vector3d center;
+    int key_shift;
+    std::vector<Matrix3d> rotations;
+    std::vector<uint8_t> products; // products[g * order + h] is the rotation g applied after h
+    std::vector<uint8_t> inverses;
+
+    void build_table();
+
+public:
+    // constructors
+    SymmetryGroup() : center(Vector3d()), key_shift(SYMMETRY_KEY_BITS), rotations(1, Matrix3d::identity()), products(1, 0), inverses(1, 0) {}
+    SymmetryGroup(const Vector3d &_center, const std::vector<Matrix3d> &generators, const int _key_shift = SYMMETRY_KEY_BITS);
+
+    // others
+    size_t get_order() const { return rotations.size(); }
+    const Vector3d& get_center() const { return center; }
+    int get_key_shift() const { return key_shift; }
+    const Matrix3d& get_rotation(const size_t g) const { return rotations[g]; }
+    Vector3d apply(const size_t g, const Vector3d &v) const;
+    Segment3d apply(const size_t g, const Segment3d &s) const;
+    size_t compose(const size_t g, const size_t h) const { return products[g * rotations.size() + h]; }
+    size_t inverse(const size_t g) const { return inverses[g]; }
+
+    static SymmetryGroup detect(const Solid3d &solid);
+};
+
+#endif
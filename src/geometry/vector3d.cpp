@@ -17,43 +17,7 @@ Vector3d& Vector3d::operator=(const Vector3d &v) {
 	return *this;
 }
 
-Vector3d Vector3d::operator+(const Vector3d &v) const {
-	return Vector3d(x + v.x, y + v.y, z + v.z, color);
-}
-
-Vector3d Vector3d::operator+=(const Vector3d &v) {
-	x += v.x;
-	y += v.y;
-	z += v.z;
-
-	return *this;
-}
-
-Vector3d Vector3d::operator-(const Vector3d &v) const {
-	return Vector3d(x - v.x, y - v.y, z - v.z, color);
-}
-
-Vector3d Vector3d::operator-=(const Vector3d &v) {
-	x -= v.x;
-	y -= v.y;
-	z -= v.z;
-
-	return *this;
-}
-
-Vector3d Vector3d::operator-() {
-	x = - x;
-	y = - y;
-	z = - z;
-
-	return *this;
-}
-
-Vector3d Vector3d::operator*(const double factor) const {
-	return Vector3d(x * factor, y * factor, z * factor, color);
-}
-
-Vector3d Vector3d::operator*=(const double factor) {
+Vector3d& Vector3d::operator*=(const double factor) {
 	x *= factor;
 	y *= factor;
 	z *= factor;
@@ -61,10 +25,6 @@ Vector3d Vector3d::operator*=(const double factor) {
 	return *this;
 }
 
-double Vector3d::operator*(const Vector3d &v) const {
-	return x * v.x + y * v.y + z * v.z;
-}
-
 std::ostream& operator<<(std::ostream& os, const Vector3d &v) {
 	os << std::setprecision(2) << std::fixed;
 
@@ -91,7 +51,7 @@ bool Vector3d::operator<(const Vector3d& v) const {
 }
 
 bool Vector3d::operator==(const Vector3d& v) const {
-	return abs(x - v.x) < precision && abs(y - v.y) < precision && abs(z - v.z) < precision;
+	return std::abs(x - v.x) < precision && std::abs(y - v.y) < precision && std::abs(z - v.z) < precision;
 }
 
 
@@ -109,17 +69,13 @@ double Vector3d::distance_to(const Vector3d &v) const {
 
 // See https://en.wikipedia.org/wiki/Rotation_matrix#In_three_dimensions part "Rotation matrix from axis and angle"
 void Vector3d::rotate(const Vector3d &center, const Vector3d &axis, const double theta) {
-	Vector3d temp(*this);
-
-	*this -= center;
-
-	Vector3d ax = axis.get_normalized();
-	double ux = ax.x, uy = ax.y, uz = ax.z;
-	double c = cos(as_radians(theta)), s = sin(as_radians(theta));
+	const double px = x - center.x, py = y - center.y, pz = z - center.z;
 
-	temp.x = x * (c + square(ux) * (1 - c))   + y * (ux * uy * (1 - c) - uz * s) + z * (ux * uz * (1 - c) + uy * s);
-	temp.y = x * (uy * ux * (1 - c) + uz * s) + y * (c + square(uy) * (1 - c))   + z * (uy * uz * (1 - c) - ux * s);
-	temp.z = x * (uz * ux * (1 - c) - uy * s) + y * (uz * uy * (1 - c) + ux * s) + z * (c + square(uz) * (1 - c));
+	const double n = axis.norm();
+	const double ux = axis.x / n, uy = axis.y / n, uz = axis.z / n;
+	const double c = cos(as_radians(theta)), s = sin(as_radians(theta));
 
-	*this = temp + center;
+	x = px * (c + square(ux) * (1 - c))   + py * (ux * uy * (1 - c) - uz * s) + pz * (ux * uz * (1 - c) + uy * s) + center.x;
+	y = px * (uy * ux * (1 - c) + uz * s) + py * (c + square(uy) * (1 - c))   + pz * (uy * uz * (1 - c) - ux * s) + center.y;
+	z = px * (uz * ux * (1 - c) - uy * s) + py * (uz * uy * (1 - c) + ux * s) + pz * (c + square(uz) * (1 - c))   + center.z;
 }
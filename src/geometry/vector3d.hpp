@@ -2,11 +2,12 @@
 #define VECTOR3D_HPP
 
 #include "../utils/tools.hpp"
+#include "vectorexpression.hpp"
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <iomanip> // for std::setprecision and std::setw
 
-class Vector3d {
+class Vector3d : public VectorExpression<Vector3d> {
 private:
 	double x, y, z;
 	sf::Color color;
@@ -18,23 +19,23 @@ public:
 	Vector3d(const double _x, const double _y, const double _z, const sf::Color _color) : x(_x), y(_y), z(_z), color(_color) {}
 	Vector3d(const Vector3d &v) : x(v.x), y(v.y), z(v.z), color(v.color) {}
 	Vector3d(const Vector3d &v, const sf::Color _color) : x(v.x), y(v.y), z(v.z), color(_color) {}
+	template <typename E>
+	Vector3d(const VectorExpression<E> &e) : x(e.template get<0>()), y(e.template get<1>()), z(e.template get<2>()), color(e.get_color()) {}
 
-	// operators
+	// operators, +, -, * (by a factor or dot product) and unary - are in vectorexpression.hpp
 	Vector3d& operator=(const Vector3d &v);
-	Vector3d operator+(const Vector3d &v) const;
-	Vector3d operator+=(const Vector3d &v);
-	Vector3d operator-(const Vector3d &v) const;
-	Vector3d operator-=(const Vector3d &v);
-	Vector3d operator-();
-	Vector3d operator*(const double factor) const;
-	Vector3d operator*=(const double factor);
-	double operator*(const Vector3d &v) const;
+	template <typename E> Vector3d& operator=(const VectorExpression<E> &e);
+	template <typename E> Vector3d& operator+=(const VectorExpression<E> &e);
+	template <typename E> Vector3d& operator-=(const VectorExpression<E> &e);
+	Vector3d& operator*=(const double factor);
 
 	bool operator<(const Vector3d& v) const;
 	bool operator==(const Vector3d& v) const;
 
 	// others
+	template <unsigned I> double get() const { return I == 0 ? x : (I == 1 ? y : z); }
 	void set_color(const sf::Color &_color) { color = _color; }
+	const sf::Color& get_color() const { return color; }
 	double norm() const { return sqrt(x * x + y * y + z * z); }
 	void normalize() { *this = (*this) * (1 / this->norm()); }
 	Vector3d get_normalized() const;
@@ -47,6 +48,44 @@ friend class Segment3d;
 friend class Plane3d;
 friend class Solid3d;
 friend class Camera3d;
+friend class ExactSolid3d;
+friend class Matrix3d;
+friend class MeshIO;
+friend class Face3d;
+friend class OcclusionBuffer;
+friend class AdaptiveRectifier;
+friend class PointIndex;
+friend class SymmetryGroup;
 };
 
+// every component only depends on the same component of the operands, so the vector
+// can appear in the expression assigned to it
+template <typename E>
+Vector3d& Vector3d::operator=(const VectorExpression<E> &e) {
+	x = e.template get<0>();
+	y = e.template get<1>();
+	z = e.template get<2>();
+	color = e.get_color();
+
+	return *this;
+}
+
+template <typename E>
+Vector3d& Vector3d::operator+=(const VectorExpression<E> &e) {
+	x += e.template get<0>();
+	y += e.template get<1>();
+	z += e.template get<2>();
+
+	return *this;
+}
+
+template <typename E>
+Vector3d& Vector3d::operator-=(const VectorExpression<E> &e) {
+	x -= e.template get<0>();
+	y -= e.template get<1>();
+	z -= e.template get<2>();
+
+	return *this;
+}
+
 #endif
@@ -0,0 +1,111 @@
+#ifndef VECTOR_EXPRESSION_HPP
+#define VECTOR_EXPRESSION_HPP
+
+#include <cmath>
+#include <SFML/Graphics.hpp>
+
+class Vector3d;
+
+// arithmetic on vectors builds a tree of these nodes instead of intermediate Vector3d:
+// (a + b) * 0.5 is only evaluated when it is assigned to a Vector3d, one component at a
+// time through the whole tree, so a chain of operations makes no temporary vector and
+// copies a single color, the one of its leftmost vector.
+// A node refers to the vectors of the full expression it is written in and must not
+// outlive it: the result of an operation is stored in a Vector3d, never in an auto
+template <typename E>
+class VectorExpression {
+public:
+	const E& self() const { return static_cast<const E&>(*this); }
+
+	template <unsigned I> double get() const { return self().template get<I>(); }
+	const sf::Color& get_color() const { return self().get_color(); }
+	double norm() const { return std::sqrt(get<0>() * get<0>() + get<1>() * get<1>() + get<2>() * get<2>()); }
+};
+
+// vectors are held by reference, nodes (a few references and a factor) by value
+template <typename E> struct VectorOperand { typedef const E type; };
+template <> struct VectorOperand<Vector3d> { typedef const Vector3d &type; };
+
+template <typename L, typename R>
+class VectorSum : public VectorExpression<VectorSum<L, R>> {
+private:
+	typename VectorOperand<L>::type l;
+	typename VectorOperand<R>::type r;
+
+public:
+	VectorSum(const L &_l, const R &_r) : l(_l), r(_r) {}
+
+	template <unsigned I> double get() const { return l.template get<I>() + r.template get<I>(); }
+	const sf::Color& get_color() const { return l.get_color(); }
+};
+
+template <typename L, typename R>
+class VectorDifference : public VectorExpression<VectorDifference<L, R>> {
+private:
+	typename VectorOperand<L>::type l;
+	typename VectorOperand<R>::type r;
+
+public:
+	VectorDifference(const L &_l, const R &_r) : l(_l), r(_r) {}
+
+	template <unsigned I> double get() const { return l.template get<I>() - r.template get<I>(); }
+	const sf::Color& get_color() const { return l.get_color(); }
+};
+
+template <typename E>
+class VectorScale : public VectorExpression<VectorScale<E>> {
+private:
+	typename VectorOperand<E>::type e;
+	double factor;
+
+public:
+	VectorScale(const E &_e, const double _factor) : e(_e), factor(_factor) {}
+
+	template <unsigned I> double get() const { return e.template get<I>() * factor; }
+	const sf::Color& get_color() const { return e.get_color(); }
+};
+
+template <typename E>
+class VectorNegation : public VectorExpression<VectorNegation<E>> {
+private:
+	typename VectorOperand<E>::type e;
+
+public:
+	explicit VectorNegation(const E &_e) : e(_e) {}
+
+	template <unsigned I> double get() const { return - e.template get<I>(); }
+	const sf::Color& get_color() const { return e.get_color(); }
+};
+
+
+// ##############################################
+// ### operators ################################
+// ##############################################
+
+template <typename L, typename R>
+inline VectorSum<L, R> operator+(const VectorExpression<L> &l, const VectorExpression<R> &r) {
+	return VectorSum<L, R>(l.self(), r.self());
+}
+
+template <typename L, typename R>
+inline VectorDifference<L, R> operator-(const VectorExpression<L> &l, const VectorExpression<R> &r) {
+	return VectorDifference<L, R>(l.self(), r.self());
+}
+
+template <typename E>
+inline VectorScale<E> operator*(const VectorExpression<E> &e, const double factor) {
+	return VectorScale<E>(e.self(), factor);
+}
+
+template <typename E>
+inline VectorNegation<E> operator-(const VectorExpression<E> &e) {
+	return VectorNegation<E>(e.self());
+}
+
+// dot product
+template <typename L, typename R>
+inline double operator*(const VectorExpression<L> &l, const VectorExpression<R> &r) {
+	return l.template get<0>() * r.template get<0>() + l.template get<1>() * r.template get<1>() + l.template get<2>() * r.template get<2>();
+}
+
+#endif
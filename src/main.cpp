@@ -1,106 +1,148 @@
 #include "utils/mouse.hpp"
 #include "utils/parameters.hpp"
+#include "utils/inputrecorder.hpp"
+#include "utils/scheduler.hpp"
 #include "geometry/camera3d.hpp"
 #include "geometry/solid3d.hpp"
 #include "geometry/geometry.hpp"
+#include "geometry/instance3d.hpp"
+#include "geometry/scene3d.hpp"
+#include "geometry/meshsimplifier.hpp"
+#include "engine/renderpreparer.hpp"
+#include "engine/rectification.hpp"
+#include "engine/shapecounts.hpp"
+#include "engine/options.hpp"
+#include "engine/batch.hpp"
+#include "engine/memorybudget.hpp"
+#include "engine/adaptiverectifier.hpp"
+#include "engine/iterationhistory.hpp"
+#include "engine/sharedpublisher.hpp"
+#include "engine/qualitycontroller.hpp"
+#include "engine/rectificationserver.hpp"
+#include "engine/distributedrectifier.hpp"
 
 #include <future>
 
 #define USAGE
+#define RENDER_THREAD // prepare the vertex buffer of the next frame on a producer thread
 
 enum class State { Running, Paused };
 
 std::atomic_bool shapeReady = false;
 std::atomic_bool quit = false;
 
-std::string getStats(const Solid3d& shape) {
-  std::string stats;
+sf::Vector2f getLoadingTextPosition() { return sf::Vector2f(Parameters::window_width / 2.f, Parameters::window_height - 50.f); }
 
-  size_t faces, edges, vertices;
-  std::map<Vector3d, size_t> edgesPerVertex;
-  
-  edges = shape.edges.size();
-  for (const Segment3d& edge : shape.edges) {
-    edgesPerVertex[edge.a]++;
-    edgesPerVertex[edge.b]++;
-  }
-  vertices = edgesPerVertex.size();
-  faces = edges - vertices + 2;
+sf::Vector2f getPausePosition() { return sf::Vector2f(Parameters::window_width / 2.f, Parameters::window_height / 2.f); }
+
+// count instances of shape on a grid in front of the camera, each one with its own spin and tint
+static std::vector<Instance3d> getGallery(const std::shared_ptr<const Solid3d> &shape, const unsigned count) {
+  static const sf::Color tints[] = { sf::Color::White, sf::Color::Cyan, sf::Color::Yellow, sf::Color::Magenta, sf::Color::Green, sf::Color::Red };
 
-  std::map<size_t, size_t> edgesPerVertexOccurences;
-  for (const auto& vertex : edgesPerVertex) {
-    edgesPerVertexOccurences[vertex.second]++;
+  double radius = 0.0;
+  for (const auto &edge : shape->edges) {
+    radius = std::max(radius, std::max(edge.a.norm(), edge.b.norm()));
   }
 
-  stats += "# of faces: " + std::to_string(faces) + "\n";
-  stats += "# of edges: " + std::to_string(edges) + "\n";
-  stats += "# of vertices: " + std::to_string(vertices) + "\n";
-  stats += "Edges per vertex:\n";
-  for (const auto& edgesCount : edgesPerVertexOccurences) {
-    stats += "\t" + std::to_string(edgesCount.first) + " edges: " + std::to_string(edgesCount.second) + " occurences\n";
+  const unsigned columns = static_cast<unsigned>(std::ceil(std::sqrt(static_cast<double>(count))));
+  const double spacing = 2.5 * radius;
+
+  std::vector<Instance3d> gallery;
+  gallery.reserve(count);
+  for (unsigned i = 0; i < count; i++) {
+    Vector3d position(((i % columns) - (columns - 1) / 2.0) * spacing, 0, (i / columns) * spacing);
+    gallery.emplace_back(shape, position, 1.0, tints[i % (sizeof(tints) / sizeof(tints[0]))]);
+    gallery.back().rotate(Vector3d(0, 1, 0), 360.0 * i / count);
   }
 
-  return stats;
+  return gallery;
 }
 
-Solid3d getNextShape(const Solid3d& shape) {
-  std::map<Vector3d, std::vector<Vector3d>> kMap;
-  for (const Segment3d& edge : shape.edges) {
-    if (quit) {
-      return shape;
-    }
-
-    Vector3d midpoint = (edge.a + edge.b) * 0.5;
-    midpoint.set_color(sf::Color::White);
-    kMap[edge.a].push_back(midpoint);
-    kMap[edge.b].push_back(midpoint);
+// the camera on the whole window, or in multi-view on its top left quarter next to fixed
+// front, side and top views of the sphere [center, distance / 2.5]
+static std::vector<Scene3d::Viewport> getViewports(const Camera3d &camera, const bool multiView, const Vector3d &center, const double distance) {
+  const unsigned width = Parameters::window_width, height = Parameters::window_height;
+  if (!multiView) {
+    return { {camera, 0, 0, width, height} };
   }
 
-  Solid3d nextShape;
-  for (const auto& vertex : kMap) {
-    if (quit) {
-      return shape;
-    }
-
-    std::vector<Vector3d> midpoints = vertex.second;
+  const unsigned w = width / 2, h = height / 2;
+  Camera3d perspective(camera);
+  perspective.reload_frustrum(w, h);
 
-    // order points to be connected in correct order to create polygon
-    for (size_t i = 0; i < midpoints.size() - 1; i++) {
-      size_t nextVertex = i + 1;
-      double length = (midpoints[i] - midpoints[nextVertex]).norm();
+  return {
+    {perspective, 0, 0, w, h},
+    {Camera3d(center + Vector3d(0, 0, -distance), 0, 0, 0, w, h), w, 0, w, h},   // front, looking along z
+    {Camera3d(center + Vector3d(-distance, 0, 0), 0, 90, 0, w, h), 0, h, w, h},  // side, looking along x
+    {Camera3d(center + Vector3d(0, -distance, 0), -90, 0, 0, w, h), w, h, w, h}  // top, looking down along y
+  };
+}
 
-      for (size_t j = i + 2; j < midpoints.size(); j++) {
-        double currentLength = (midpoints[i] - midpoints[j]).norm();
-        if (currentLength < length) {
-          nextVertex = j;
-          length = currentLength;
-        }
-      }
+// target the figure is drawn in when the quality controller lowers its antialiasing or resolution
+struct OffscreenTarget {
+  sf::RenderTexture texture;
+  unsigned width = 0, height = 0, antialiasing = 0;
+};
+
+// the figure in the window, or in the offscreen target at the antialiasing and resolution of
+// quality then stretched over the window, the target being only created again when they change
+static void drawFigure(sf::RenderWindow &window, OffscreenTarget &offscreen, const sf::VertexArray &figure, const QualityController &quality) {
+  const QualityController::Settings &settings = quality.get_settings();
+  const unsigned width = Parameters::window_width, height = Parameters::window_height;
+  if (settings.resolution >= 1.0 && settings.antialiasing >= window.getSettings().antialiasingLevel) {
+    window.draw(figure);
+    return;
+  }
 
-      if (nextVertex != i + 1) {
-        std::swap(midpoints[i + 1], midpoints[nextVertex]);
-      }
+  const unsigned w = std::max(1u, static_cast<unsigned>(width * settings.resolution));
+  const unsigned h = std::max(1u, static_cast<unsigned>(height * settings.resolution));
+  if (offscreen.width != w || offscreen.height != h || offscreen.antialiasing != settings.antialiasing) {
+    sf::ContextSettings context;
+    context.antialiasingLevel = settings.antialiasing;
+    if (!offscreen.texture.create(w, h, context)) {
+      window.draw(figure);
+      return;
     }
+    offscreen.texture.setSmooth(true);
+    offscreen.width = w;
+    offscreen.height = h;
+    offscreen.antialiasing = settings.antialiasing;
+  }
 
-    // connect midpoints of vertex
-    for (size_t i = 0; i < midpoints.size(); i++) {
-      Segment3d edge = Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]);
+  // the figure keeps its window coordinates, the view maps them to the target
+  offscreen.texture.setView(sf::View(sf::FloatRect(0.f, 0.f, width, height)));
+  offscreen.texture.clear();
+  offscreen.texture.draw(figure);
+  offscreen.texture.display();
 
-      if (std::find(nextShape.edges.begin(), nextShape.edges.end(), edge) == nextShape.edges.end()) {
-        nextShape.add_segment(Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]));
-      }
-    }
+  sf::Sprite sprite(offscreen.texture.getTexture());
+  sprite.setScale(static_cast<float>(width) / w, static_cast<float>(height) / h);
+  window.draw(sprite);
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parseOptions(argc, argv, options)) {
+    printUsage(std::cerr, argv[0]);
+    return EXIT_FAILURE;
   }
 
-  shapeReady = true;
-  return nextShape;
-}
+  if (!options.worker.empty()) {
+    return runWorker();
+  }
 
-sf::Vector2f getLoadingTextPosition() { return sf::Vector2f(Parameters::window_width / 2.f, Parameters::window_height - 50.f); }
+  if (options.batch) {
+    return runBatch(options);
+  }
 
-sf::Vector2f getPausePosition() { return sf::Vector2f(Parameters::window_width / 2.f, Parameters::window_height / 2.f); }
+  if (options.predict) {
+    return runPrediction(options);
+  }
+
+  if (!options.serve.empty()) {
+    return runServer(options);
+  }
 
-int main() {
   // setup window
   sf::ContextSettings window_settings;
   window_settings.antialiasingLevel = 8;
@@ -111,6 +153,9 @@ int main() {
   Mouse::setPosition(sf::Vector2i(Parameters::window_width, Parameters::window_height) / 2, window);
 
   State state = State::Running;
+  bool hiddenLines = false; // toggled with H, only the edges of faces turned towards the camera are drawn
+  bool occlusionCulling = false; // toggled with O, edges hidden behind the nearest faces are not drawn
+  bool multiView = false; // toggled with V, perspective, front, side and top views in the four quarters of the window
 
   // create camera
   Camera3d camera(Vector3d(0, -120, -230), -10, 0, 0, Parameters::window_width, Parameters::window_height);
@@ -121,13 +166,46 @@ int main() {
   loop_timer.restart();
   load_timer.restart();
 
-  Solid3d k;
-  k.add_segment(Segment3d(Vector3d(-100, 0, 0, sf::Color::White), Vector3d(100, 0, 0, sf::Color::White)));
-  k.add_segment(Segment3d(Vector3d(100, 0, 0, sf::Color::White), Vector3d(0, 0, 100 * sqrt(3), sf::Color::White)));
-  k.add_segment(Segment3d(Vector3d(0, 0, 100 * sqrt(3), sf::Color::White), Vector3d(-100, 0, 0, sf::Color::White)));
-  k.add_segment(Segment3d(Vector3d(-100, 0, 0, sf::Color::White), Vector3d(0, -sqrt(square(200) - square(100) - square(100 * sqrt(3) / 3)), 100 * sqrt(3) / 3, sf::Color::White)));
-  k.add_segment(Segment3d(Vector3d(100, 0, 0, sf::Color::White), Vector3d(0, -sqrt(square(200) - square(100) - square(100 * sqrt(3) / 3)), 100 * sqrt(3) / 3, sf::Color::White)));
-  k.add_segment(Segment3d(Vector3d(0, 0, 100 * sqrt(3), sf::Color::White), Vector3d(0, -sqrt(square(200) - square(100) - square(100 * sqrt(3) / 3)), 100 * sqrt(3) / 3, sf::Color::White)));
+  Solid3d seed;
+  if (!getSeed(options.seed, seed)) {
+    return EXIT_FAILURE;
+  }
+
+  // the fixed views of the multi-view mode frame the seed, the iterations stay inside it
+  Vector3d viewCenter;
+  double viewDistance;
+  seed.get_bounding_sphere(viewCenter, viewDistance);
+  viewDistance *= 2.5;
+
+  // exact iterations split among worker processes (--processes), stopped when the last rectifier goes
+  std::shared_ptr<DistributedRectifier> workers;
+  if (options.processes) {
+    std::string error;
+    workers = std::make_shared<DistributedRectifier>(options.processes);
+    if (!workers->start(error)) {
+      std::cerr << "cannot start the workers: " << error << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  Rectifier rectifier = Rectifier(seed, options.mode).with_curve(options.curve).with_workers(workers);
+  if (options.mode == Rectifier::MODE::SYMMETRIC) {
+    std::cout << "Symmetry group order: " << rectifier.get_symmetry_order() << std::endl;
+  }
+  std::shared_ptr<const Solid3d> k = rectifier.get_shape();
+
+  // view-dependent mode: the shape is refined around the camera every frame instead of by the rectifier
+  std::unique_ptr<AdaptiveRectifier> adaptive;
+  if (options.adaptive) {
+    if (!AdaptiveRectifier::can_refine(seed)) {
+      std::cerr << options.seed << ": --adaptive needs a closed seed whose faces are known" << std::endl;
+      return EXIT_FAILURE;
+    }
+    adaptive.reset(new AdaptiveRectifier(seed, options.adaptive));
+    adaptive->update(camera);
+    k = adaptive->get_shape();
+  }
+  std::vector<Instance3d> gallery = getGallery(k, options.gallery);
 
   sf::Font font;
   font.loadFromFile("../Resources/arial.ttf");
@@ -138,8 +216,13 @@ int main() {
   sf::Text statHeader("Shape statistics", font, 32);
   statHeader.setStyle(sf::Text::Underlined);
   statHeader.setPosition(5.f, 70.f);
-  sf::Text statText(getStats(k), font, 32);
+  sf::Text statText(getStats(*k), font, 32);
+  std::vector<ShapeCounts> predictedCounts(1, ShapeCounts(*k)); // combinatorial prediction of every iteration, validates the geometric path
   statText.setPosition(5.f, 105.f);
+  if (adaptive) {
+    iterText.setString(std::to_string(adaptive->get_depth()));
+    statText.setString(adaptive->get_stats());
+  }
 
   sf::Text loadingText("Loading next shape...", font, 32);
   loadingText.setFillColor(sf::Color(80, 80, 80));
@@ -155,11 +238,89 @@ int main() {
   pause.setPosition(getPausePosition());
   pause.setScale(0.5f, 0.5f);
 
-  std::future<Solid3d> newK;
+  std::future<Rectifier> newK;
+  std::shared_ptr<ShapeProgress> progress;                  // edges of the next shape published while it is built
+  std::vector<std::shared_ptr<const Solid3d>> partialShape; // its batches received so far, drawn over the current shape
+  const sf::Color previousShapeTint(70, 70, 70);
+
+  // every iteration is compressed in the background once shown, the left arrow steps back
+  // through them and the right arrow (or Space) forward, computing only the iterations never met
+  IterationHistory history;
+  Scheduler::TaskGroup historyTasks(Scheduler::PRIORITY::BACKGROUND); // waited for before the history is destroyed
+  if (!adaptive) {
+    historyTasks.run([&history, rectifier]() { history.store(rectifier); });
+  }
+
+  // the current mesh and every frame for the other processes of the host, see sharedlayout.hpp
+  SharedPublisher publisher;
+  if (!options.share.empty()) {
+    std::string error;
+    if (!publisher.open(options.share, error)) {
+      std::cerr << options.share << ": " << error << std::endl;
+      return EXIT_FAILURE;
+    }
+    publisher.publish_mesh(k, adaptive ? adaptive->get_depth() : rectifier.get_iteration());
+  }
+
+#ifdef RENDER_THREAD
+  RenderPreparer preparer(publisher.is_open() ? &publisher : nullptr);
+#else
+  sf::VertexArray figure(sf::Lines);
+  OcclusionBuffer occlusion;
+  Scene3d scene;
+#endif
+
+  // input recording / replay, a replay runs uncapped and reports the frame time distribution
+  InputRecorder recorder;
+  std::vector<InputRecorder::Frame> replayFrames;
+  size_t replayFrame = 0;
+  const bool replaying = !options.replay.empty();
+  std::vector<double> frameTimes;
+  double generationTime = 0.0;
+
+  if (!options.record.empty() && !recorder.open(options.record)) {
+    std::cerr << options.record << ": cannot open file" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (replaying) {
+    std::string error;
+    if (!InputRecorder::load(options.replay, replayFrames, error) || replayFrames.empty()) {
+      std::cerr << options.replay << ": " << (error.empty() ? "no frame recorded" : error) << std::endl;
+      return EXIT_FAILURE;
+    }
+    window.setVerticalSyncEnabled(false);
+  }
+
+  // quality knobs following the frame time, off in a replay which measures the full detail
+  const bool adaptiveQuality = options.adaptive_quality && !replaying;
+  QualityController quality(window.getSettings().antialiasingLevel);
+  OffscreenTarget offscreen;
+  std::shared_ptr<const Solid3d> fallbackShape;                 // older iteration drawn instead of k
+  std::future<std::shared_ptr<const Solid3d>> newFallback;      // being decompressed
+  unsigned fallbackIteration = 0;                               // of fallbackShape, or of newFallback while valid
+
+  sf::Text qualityText("", font, 24);
+  qualityText.setFillColor(sf::Color(140, 140, 140));
+  qualityText.setPosition(5.f, Parameters::window_height - 35.f);
+
+  // lighter copy of k drawn instead of it (--simplify), computed in the background for every new shape,
+  // the one superseded being cancelled
+  std::shared_ptr<const Solid3d> simplifiedShape;
+  std::future<std::shared_ptr<const Solid3d>> newSimplified;
+  std::shared_ptr<const Solid3d> simplifiedSource;           // the k of simplifiedShape or newSimplified
+  std::shared_ptr<std::atomic_bool> cancelSimplification;
+  const bool simplifying = (options.simplify > 0 || options.simplify_error > 0) && gallery.empty();
+
+  sf::Text simplifiedText("", font, 24);
+  simplifiedText.setFillColor(sf::Color(140, 140, 140));
+  simplifiedText.setPosition(5.f, Parameters::window_height - 65.f);
 
   while (window.isOpen())
   {
+    std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+    double frameGenerationTime = 0.0;
     sf::Event event;
+    InputRecorder::Frame input;
 
     // handle events
     while (window.pollEvent(event)) {
@@ -178,8 +339,10 @@ int main() {
         camera.reload_frustrum(Parameters::window_width, Parameters::window_height);
         loadingText.setPosition(getLoadingTextPosition());
         pause.setPosition(getPausePosition());
+        qualityText.setPosition(5.f, Parameters::window_height - 35.f);
+        simplifiedText.setPosition(5.f, Parameters::window_height - 65.f);
       }
-      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape) {
+      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape && !replaying) {
         if (state == State::Running) {
           state = State::Paused;
           window.setMouseCursorVisible(true);
@@ -191,45 +354,323 @@ int main() {
         }
       }
 
-      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Space && !newK.valid() && state == State::Running) {
-        newK = std::async(std::launch::async, getNextShape, k);
-        load_timer.restart();
+      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::H) {
+        input.pressed |= InputRecorder::HIDDEN_LINES;
+      }
+      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::O) {
+        input.pressed |= InputRecorder::OCCLUSION;
+      }
+      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::V) {
+        input.pressed |= InputRecorder::MULTI_VIEW;
+      }
+      if (event.type == sf::Event::KeyPressed && (event.key.code == sf::Keyboard::Space || event.key.code == sf::Keyboard::Right) && state == State::Running) {
+        input.pressed |= InputRecorder::NEXT_SHAPE;
+      }
+      if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Left && state == State::Running) {
+        input.pressed |= InputRecorder::PREVIOUS_SHAPE;
       }
     }
 
-    if (state == State::Running) {
-      // rotate camera
-      camera.rotate(Mouse::get_move_x(window), Mouse::get_move_y(window));
+    // live input, or the recorded one when replaying
+    if (replaying) {
+      input = replayFrames[replayFrame++];
+    }
+    else if (state == State::Running) {
+      input.move_x = Mouse::get_move_x(window);
+      input.move_y = Mouse::get_move_y(window);
       Mouse::setPosition(sf::Vector2i(Parameters::window_width, Parameters::window_height) / 2, window);
 
-      // move camera
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        camera.move(Camera3d::DIRECTION::FRONT);
+        input.held |= InputRecorder::FRONT;
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        camera.move(Camera3d::DIRECTION::BACK);
+        input.held |= InputRecorder::BACK;
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        camera.move(Camera3d::DIRECTION::RIGHT);
+        input.held |= InputRecorder::RIGHT;
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        camera.move(Camera3d::DIRECTION::LEFT);
+        input.held |= InputRecorder::LEFT;
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        camera.move(Camera3d::DIRECTION::UP);
+        input.held |= InputRecorder::UP;
       if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        camera.move(Camera3d::DIRECTION::DOWN);
+        input.held |= InputRecorder::DOWN;
+    }
+
+    // only the presses that start a new shape are recorded, the replay waits for every shape
+    if (newK.valid() || adaptive) {
+      input.pressed &= ~InputRecorder::PREVIOUS_SHAPE;
+    }
+    if (newK.valid()) {
+      input.pressed &= ~InputRecorder::NEXT_SHAPE;
+    }
+    if (recorder.is_open()) {
+      recorder.record(input);
+    }
+
+    if (input.pressed & InputRecorder::HIDDEN_LINES) {
+      hiddenLines = !hiddenLines;
+    }
+    if (input.pressed & InputRecorder::OCCLUSION) {
+      occlusionCulling = !occlusionCulling;
+    }
+    if (input.pressed & InputRecorder::MULTI_VIEW) {
+      multiView = !multiView;
+    }
+    if ((input.pressed & InputRecorder::NEXT_SHAPE) && adaptive) {
+      // one more iteration for the regions in view, reached over the next updates
+      adaptive->set_depth(adaptive->get_depth() + 1);
+      iterText.setString(std::to_string(adaptive->get_depth()));
+      input.pressed &= ~InputRecorder::NEXT_SHAPE;
+    }
+    // an iteration met before is decompressed instead of being computed again, a replay
+    // waits for the compressions so that it finds the same iterations as the recording
+    std::shared_ptr<const CompressedIteration> stored;
+    if (replaying && (input.pressed & (InputRecorder::PREVIOUS_SHAPE | InputRecorder::NEXT_SHAPE))) {
+      historyTasks.wait();
+    }
+    if ((input.pressed & InputRecorder::PREVIOUS_SHAPE) && rectifier.get_iteration() > 0) {
+      stored = history.find(rectifier.get_iteration() - 1);
+    }
+    else if (input.pressed & InputRecorder::NEXT_SHAPE) {
+      stored = history.find(rectifier.get_iteration() + 1);
+    }
+    if (stored) {
+      input.pressed &= ~InputRecorder::NEXT_SHAPE;
+      progress.reset();
+      partialShape.clear();
+      newK = Scheduler::get().async(Scheduler::PRIORITY::BACKGROUND, [stored, workers]() {
+        Rectifier restored = stored->restore().with_workers(workers);
+        shapeReady = true;
+        return restored;
+      });
+      loadingText.setString("Restoring iteration " + std::to_string(stored->get_iteration()) + "...");
+      load_timer.restart();
+
+      if (replaying) {
+        newK.wait();
+        frameGenerationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        generationTime += frameGenerationTime;
+      }
+    }
+    std::string budgetMessage;
+    if ((input.pressed & InputRecorder::NEXT_SHAPE) && !fitMemoryBudget(rectifier, options.memory_budget, budgetMessage, gallery.empty() && !replaying)) {
+      input.pressed &= ~InputRecorder::NEXT_SHAPE;
+    }
+    if (!budgetMessage.empty()) {
+      std::cout << budgetMessage << std::endl;
+    }
+    if (input.pressed & InputRecorder::NEXT_SHAPE) {
+      // background task of the scheduler: the frames keep their tasks ahead of it
+      // the single shape is drawn as it grows, a gallery or a replay waits for the whole of it
+      progress.reset();
+      if (gallery.empty() && !replaying) {
+        progress = std::make_shared<ShapeProgress>(2 * k->edges.size());
+      }
+      partialShape.clear();
+      newK = Scheduler::get().async(Scheduler::PRIORITY::BACKGROUND, [rectifier, progress]() {
+        Rectifier next = rectifier.get_next(quit, progress.get());
+        shapeReady = true;
+        return next;
+      });
+      load_timer.restart();
+
+      if (replaying) {
+        newK.wait();
+        frameGenerationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        generationTime += frameGenerationTime;
+      }
+    }
+
+    // rotate camera
+    camera.rotate(input.move_x, input.move_y);
+
+    // move camera
+    if (input.held & InputRecorder::FRONT)
+      camera.move(Camera3d::DIRECTION::FRONT);
+    if (input.held & InputRecorder::BACK)
+      camera.move(Camera3d::DIRECTION::BACK);
+    if (input.held & InputRecorder::RIGHT)
+      camera.move(Camera3d::DIRECTION::RIGHT);
+    if (input.held & InputRecorder::LEFT)
+      camera.move(Camera3d::DIRECTION::LEFT);
+    if (input.held & InputRecorder::UP)
+      camera.move(Camera3d::DIRECTION::UP);
+    if (input.held & InputRecorder::DOWN)
+      camera.move(Camera3d::DIRECTION::DOWN);
+
+    // refine or merge the regions whose view changed
+    if (adaptive && adaptive->update(camera)) {
+      k = adaptive->get_shape();
+      statText.setString(adaptive->get_stats());
+      publisher.publish_mesh(k, adaptive->get_depth());
     }
 
     // update shape (if needed)
     if (shapeReady) {
-      k = newK.get();
-      iterText.setString(std::to_string(std::stoi(iterText.getString().toAnsiString()) + 1));
-      statText.setString(getStats(k));
+      rectifier = newK.get();
+      k = rectifier.get_shape();
+      publisher.publish_mesh(k, rectifier.get_iteration());
+      if (!history.find(rectifier.get_iteration())) {
+        historyTasks.run([&history, rectifier]() { history.store(rectifier); });
+      }
+      for (auto &instance : gallery) {
+        instance.set_geometry(k);
+      }
+      iterText.setString(std::to_string(rectifier.get_iteration()));
+      statText.setString(getStats(*k));
+      const unsigned iteration = rectifier.get_iteration();
+      while (predictedCounts.size() <= iteration && predictedCounts.back().can_rectify()) {
+        predictedCounts.push_back(predictedCounts.back().get_next());
+      }
+      if (iteration < predictedCounts.size() && predictedCounts[iteration].get_stats() != statText.getString().toAnsiString()) {
+        std::cout << "Iteration " << iteration << " differs from the combinatorial prediction:\n" << predictedCounts[iteration].get_stats();
+      }
       loadingText.setString("Loading next shape...");
+      progress.reset();
+      partialShape.clear();
       shapeReady = false;
     }
+    else if (progress) {
+      // every batch becomes an immutable part of the preview, never copied again
+      std::vector<Segment3d> batch;
+      size_t received = 0;
+      while (progress->poll(batch)) {
+        std::shared_ptr<Solid3d> part = std::make_shared<Solid3d>();
+        part->edges.swap(batch);
+        part->build_clusters();
+        received += part->edges.size();
+        partialShape.push_back(part);
+      }
+
+      if (received > 0 && progress->get_expected() > 0) {
+        std::string loading = loadingText.getString().toAnsiString();
+        size_t dots = loading.find('.');
+        size_t percent = std::min<size_t>(99, 100 * progress->get_published() / progress->get_expected());
+        loadingText.setString("Loading next shape " + std::to_string(percent) + "%" + (dots == std::string::npos ? "" : loading.substr(dots)));
+      }
+    }
+
+    // spin the gallery instances, only their transforms change
+    for (size_t i = 0; i < gallery.size(); i++) {
+      gallery[i].rotate(i % 2 ? Vector3d(0, 1, 0) : Vector3d(1, 1, 0), 1);
+    }
+
+    // an older iteration while the current one is too heavy, decompressed in the background from
+    // the history, the current one being drawn meanwhile
+    quality.set_max_fallback(adaptive || !gallery.empty() ? 0 : rectifier.get_iteration());
+    const unsigned fallback = quality.get_settings().fallback;
+    if (newFallback.valid() && newFallback.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      fallbackShape = newFallback.get();
+    }
+    if (fallback == 0) {
+      fallbackShape.reset();
+    }
+    else if (!newFallback.valid() && (!fallbackShape || fallbackIteration != rectifier.get_iteration() - fallback)) {
+      std::shared_ptr<const CompressedIteration> older = history.find(rectifier.get_iteration() - fallback);
+      if (older) {
+        fallbackIteration = older->get_iteration();
+        newFallback = Scheduler::get().async(Scheduler::PRIORITY::BACKGROUND, [older]() {
+          std::shared_ptr<Solid3d> shape = std::make_shared<Solid3d>(older->get_shape());
+          shape->build_clusters();
+          return std::shared_ptr<const Solid3d>(shape);
+        });
+      }
+    }
+    const bool drawFallback = fallback > 0 && fallbackShape && !newFallback.valid() && fallbackIteration == rectifier.get_iteration() - fallback;
+
+    // the full shape is drawn until its simplified copy is ready, and with hidden lines or occlusion
+    // culling which need its faces
+    if (simplifying && simplifiedSource != k) {
+      if (cancelSimplification) {
+        *cancelSimplification = true;
+      }
+      simplifiedShape.reset();
+      newSimplified = std::future<std::shared_ptr<const Solid3d>>();
+      simplifiedSource = k;
+      if (options.simplify == 0 || k->edges.size() > options.simplify) {
+        std::shared_ptr<const Solid3d> source = k;
+        std::shared_ptr<std::atomic_bool> cancel = cancelSimplification = std::make_shared<std::atomic_bool>(false);
+        const size_t targetEdges = options.simplify;
+        const double maxError = options.simplify_error;
+        newSimplified = Scheduler::get().async(Scheduler::PRIORITY::BACKGROUND, [source, cancel, targetEdges, maxError]() {
+          Vector3d center;
+          double radius;
+          source->get_bounding_sphere(center, radius);
+
+          MeshSimplifier simplifier(*source);
+          if (!simplifier.simplify(targetEdges, maxError * radius, *cancel)) {
+            return std::shared_ptr<const Solid3d>();
+          }
+          std::shared_ptr<Solid3d> shape = std::make_shared<Solid3d>(simplifier.get_shape());
+          shape->build_clusters();
+          return std::shared_ptr<const Solid3d>(shape);
+        });
+      }
+    }
+    if (newSimplified.valid() && newSimplified.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      simplifiedShape = newSimplified.get();
+      if (simplifiedShape) {
+        simplifiedText.setString("Simplified: " + std::to_string(simplifiedShape->edges.size()) + " of " + std::to_string(k->edges.size()) + " edges");
+      }
+    }
+    const bool drawSimplified = simplifiedShape && !drawFallback && !hiddenLines && !occlusionCulling;
+    const std::shared_ptr<const Solid3d> &drawn = drawFallback ? fallbackShape : (drawSimplified ? simplifiedShape : k);
+    const double edgeRatio = quality.get_settings().edge_ratio;
 
     // rendering
     window.clear();
 
-    k.render_solid(window, Parameters::window_width, Parameters::window_height, camera);
+    std::vector<Scene3d::Viewport> viewports = getViewports(camera, multiView, viewCenter, viewDistance);
+
+#ifdef RENDER_THREAD
+    // draw the last prepared frame while the producer thread prepares the next one
+    preparer.set_edge_ratio(edgeRatio);
+    if (!partialShape.empty()) {
+      preparer.submit(viewports, std::vector<Instance3d>(1, Instance3d(k, Vector3d(), 1.0, previousShapeTint)), partialShape, hiddenLines);
+    }
+    else if (gallery.empty()) {
+      preparer.submit(viewports, drawn, hiddenLines, occlusionCulling);
+    }
+    else {
+      preparer.submit(viewports, gallery, hiddenLines);
+    }
+    // a replay waits for the frame of its own input, whose preparation is part of the frame time
+    const RenderPreparer::PreparedFrame *frame = replaying ? preparer.wait() : preparer.acquire();
+    if (frame)
+      drawFigure(window, offscreen, frame->figure, quality);
+    RenderPreparer::TimePoint sampled = frame ? frame->sampled : std::chrono::steady_clock::now();
+#else
+    RenderPreparer::TimePoint sampled = std::chrono::steady_clock::now();
+    if (gallery.empty() && partialShape.empty() && occlusionCulling && !multiView) {
+      occlusion.update(*drawn, camera, Parameters::window_width, Parameters::window_height);
+      drawn->build_figure(figure, Parameters::window_width, Parameters::window_height, camera, hiddenLines, &occlusion, edgeRatio);
+    }
+    else {
+      // the shape alone or its gallery, processed in parallel and drawn at once for every viewport
+      scene.clear();
+      scene.instances = gallery;
+      scene.edge_ratio = edgeRatio;
+      if (!partialShape.empty()) {
+        // the shape being built over the current one dimmed
+        scene.instances.push_back(Instance3d(k, Vector3d(), 1.0, previousShapeTint));
+        for (const auto &part : partialShape) {
+          scene.add(part);
+        }
+      }
+      else if (gallery.empty()) {
+        scene.add(drawn);
+      }
+      scene.build_figure(figure, viewports, hiddenLines);
+    }
+    publisher.publish_frame(figure, Parameters::window_width, Parameters::window_height, sampled);
+    drawFigure(window, offscreen, figure, quality);
+#endif
+
+    if (multiView) {
+      const float w = Parameters::window_width, h = Parameters::window_height;
+      const sf::Color grey(80, 80, 80);
+      sf::Vertex borders[] = { sf::Vertex(sf::Vector2f(w / 2.f, 0.f), grey), sf::Vertex(sf::Vector2f(w / 2.f, h), grey),
+                               sf::Vertex(sf::Vector2f(0.f, h / 2.f), grey), sf::Vertex(sf::Vector2f(w, h / 2.f), grey) };
+      window.draw(borders, 4, sf::Lines);
+    }
 
     window.draw(iterText);
     window.draw(statHeader);
@@ -249,18 +690,52 @@ int main() {
       window.draw(loadingText);
     }
 
+    if (!quality.is_finest()) {
+      window.draw(qualityText);
+    }
+    if (drawSimplified && gallery.empty() && partialShape.empty()) {
+      window.draw(simplifiedText);
+    }
+
     if (state == State::Paused) {
       window.draw(pause);
     }
 
+    // the time the engine spent on the frame, the producer thread preparing it in parallel
+    double workTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count() - frameGenerationTime;
+#ifdef RENDER_THREAD
+    if (frame)
+      workTime = std::max(workTime, frame->duration);
+#endif
+
     window.display();
 
+    if (adaptiveQuality && quality.update(loop_timer.getElapsedTime().asMicroseconds() / 1000.0, workTime)) {
+      qualityText.setString(quality.get_description());
+    }
+
     // other
 #ifdef USAGE
     Parameters::print_mean_CPU_usage(std::cout, loop_timer.getElapsedTime().asMilliseconds());
+    Parameters::print_mean_latency(std::cout, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sampled).count());
 #endif
 
-    sf::sleep(sf::milliseconds(MAX_MAIN_LOOP_DURATION - loop_timer.getElapsedTime().asMilliseconds()));
+    if (replaying) {
+      // frame time without the wait for a new shape, at least the preparation of the frame
+      double frameTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count() - frameGenerationTime;
+#ifdef RENDER_THREAD
+      if (frame)
+        frameTime = std::max(frameTime, frame->duration);
+#endif
+      frameTimes.push_back(frameTime);
+      if (replayFrame == replayFrames.size()) {
+        Parameters::print_frame_times(std::cout, frameTimes, generationTime);
+        window.close();
+      }
+    }
+    else {
+      sf::sleep(sf::milliseconds(MAX_MAIN_LOOP_DURATION - loop_timer.getElapsedTime().asMilliseconds()));
+    }
     loop_timer.restart();
   }
 
@@ -268,6 +743,15 @@ int main() {
   if (newK.valid()) {
     newK.wait();
   }
+  if (newFallback.valid()) {
+    newFallback.wait();
+  }
+  if (cancelSimplification) {
+    *cancelSimplification = true;
+  }
+  if (newSimplified.valid()) {
+    newSimplified.wait();
+  }
   return EXIT_SUCCESS;
 }
 
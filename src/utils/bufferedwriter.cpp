@@ -0,0 +1,119 @@
+#include "bufferedwriter.hpp"
+#include <cstring>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+BufferedWriter::BufferedWriter(const std::string &path, const size_t capacity) : file(fopen(path.c_str(), "wb")),
+                                                                                 memory(nullptr),
+                                                                                 buffer(capacity),
+                                                                                 used(0),
+                                                                                 written(0),
+                                                                                 failed(file == nullptr) {}
+
+BufferedWriter::BufferedWriter(std::vector<char> &_memory, const size_t capacity) : file(nullptr),
+                                                                                    memory(&_memory),
+                                                                                    buffer(capacity),
+                                                                                    used(0),
+                                                                                    written(0),
+                                                                                    failed(false) {}
+
+// close() reports the errors, here they can only be dropped
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+// make room for size bytes, size must not exceed the capacity
+void BufferedWriter::reserve(const size_t size) {
+    if (used + size > buffer.size())
+        flush();
+}
+
+void BufferedWriter::flush() {
+    if (file && used > 0 && fwrite(buffer.data(), 1, used, file) != used)
+        failed = true;
+    else if (memory && used > 0)
+        memory -> insert(memory -> end(), buffer.data(), buffer.data() + used);
+
+    written += used;
+    used = 0;
+}
+
+// flushes and closes the file, false if anything was not written (a full disk shows up at fclose() at the latest)
+bool BufferedWriter::close() {
+    flush();
+    if (file && fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    memory = nullptr;
+
+    return ! failed;
+}
+
+void BufferedWriter::write(const char *text) {
+    write_bytes(text, strlen(text));
+}
+
+void BufferedWriter::write(const char c) {
+    reserve(1);
+    buffer[used++] = c;
+}
+
+void BufferedWriter::write_uint(uint64_t x) {
+    char digits[20];
+    size_t n = 0;
+
+    do {
+        digits[n++] = static_cast<char>('0' + x % 10);
+        x /= 10;
+    } while (x > 0);
+
+    reserve(n);
+    while (n > 0)
+        buffer[used++] = digits[--n];
+}
+
+// 17 significant digits, enough to read back the same double
+void BufferedWriter::write_double(const double x) {
+    reserve(32);
+    used += static_cast<size_t>(snprintf(&buffer[used], 32, "%.17g", x));
+}
+
+void BufferedWriter::write_bytes(const void *data, const size_t size) {
+    const char *bytes = static_cast<const char *>(data);
+
+    if (size > buffer.size()) {
+        flush();
+        if (file && fwrite(bytes, 1, size, file) != size)
+            failed = true;
+        else if (memory)
+            memory -> insert(memory -> end(), bytes, bytes + size);
+        written += size;
+        return;
+    }
+
+    reserve(size);
+    memcpy(&buffer[used], bytes, size);
+    used += size;
+}
+
+void BufferedWriter::write_le_uint32(const uint32_t x) {
+    reserve(4);
+    for (unsigned i = 0; i < 4; ++i)
+        buffer[used++] = static_cast<char>((x >> (8 * i)) & 0xff);
+}
+
+void BufferedWriter::write_le_double(const double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+
+    reserve(8);
+    for (unsigned i = 0; i < 8; ++i)
+        buffer[used++] = static_cast<char>((bits >> (8 * i)) & 0xff);
+}
@@ -0,0 +1,55 @@
+#ifndef BUFFEREDWRITER_HPP
+#define BUFFEREDWRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define BUFFERED_WRITER_CAPACITY (1 << 20)
+
+// file output through one fixed size buffer: numbers are formatted directly
+// into it and it is written to the file when full, no intermediate string
+// the output can also be appended to a vector in memory instead of a file
+// errors are sticky: once a write failed, has_failed() and close() report it
+class BufferedWriter {
+private:
+    FILE *file;
+    std::vector<char> *memory;
+    std::vector<char> buffer;
+    size_t used;
+    uint64_t written;
+    bool failed; // a write or the close of the file failed, the output is incomplete
+
+    void reserve(const size_t size);
+
+public:
+    // constructors
+    BufferedWriter(const std::string &path, const size_t capacity = BUFFERED_WRITER_CAPACITY);
+    explicit BufferedWriter(std::vector<char> &_memory, const size_t capacity = BUFFERED_WRITER_CAPACITY);
+    BufferedWriter(const BufferedWriter &) = delete;
+    ~BufferedWriter();
+
+    // operators
+    BufferedWriter& operator=(const BufferedWriter &) = delete;
+
+    // others
+    bool is_open() const { return file != nullptr || memory != nullptr; }
+    uint64_t get_written_bytes() const { return written + used; }
+    bool has_failed() const { return failed; }
+    void flush();
+    bool close();
+
+    // text
+    void write(const char *text);
+    void write(const char c);
+    void write_uint(uint64_t x);
+    void write_double(const double x);
+
+    // binary, little endian whatever the host
+    void write_bytes(const void *data, const size_t size);
+    void write_le_uint32(const uint32_t x);
+    void write_le_double(const double x);
+};
+
+#endif
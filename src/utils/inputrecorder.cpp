@@ -0,0 +1,44 @@
+#include "inputrecorder.hpp"
+#include <sstream>
+
+bool InputRecorder::open(const std::string &path) {
+	file.open(path);
+	if (! file)
+		return false;
+
+	file << INPUT_RECORD_HEADER << '\n';
+	return true;
+}
+
+// flushed every frame so that a crash keeps the input leading to it
+void InputRecorder::record(const Frame &frame) {
+	file << frame.move_x << ' ' << frame.move_y << ' ' << frame.held << ' ' << frame.pressed << std::endl;
+}
+
+bool InputRecorder::load(const std::string &path, std::vector<Frame> &frames, std::string &error) {
+	std::ifstream input(path);
+	if (! input) {
+		error = "cannot open file";
+		return false;
+	}
+
+	std::string line;
+	if (! std::getline(input, line) || line != INPUT_RECORD_HEADER) {
+		error = "not an input record";
+		return false;
+	}
+
+	frames.clear();
+	for (size_t number = 2; std::getline(input, line); ++number) {
+		std::istringstream fields(line);
+		Frame frame;
+
+		if (! (fields >> frame.move_x >> frame.move_y >> frame.held >> frame.pressed)) {
+			error = "invalid frame on line " + std::to_string(number);
+			return false;
+		}
+		frames.push_back(frame);
+	}
+
+	return true;
+}
@@ -0,0 +1,48 @@
+#ifndef INPUTRECORDER_HPP
+#define INPUTRECORDER_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define INPUT_RECORD_HEADER "3D-engine input 1"
+
+// per frame input of the main loop, written as one text line per frame:
+//    move_x move_y held pressed
+// so that a camera path can be replayed identically to benchmark the rendering
+class InputRecorder {
+public:
+	// bits of Frame::held (camera keys down during the frame) and Frame::pressed (key presses of the frame)
+	enum KEY : unsigned {
+		FRONT          = 1 << 0,
+		BACK           = 1 << 1,
+		RIGHT          = 1 << 2,
+		LEFT           = 1 << 3,
+		UP             = 1 << 4,
+		DOWN           = 1 << 5,
+		NEXT_SHAPE     = 1 << 6,
+		HIDDEN_LINES   = 1 << 7,
+		OCCLUSION      = 1 << 8,
+		MULTI_VIEW     = 1 << 9,
+		PREVIOUS_SHAPE = 1 << 10
+	};
+
+	struct Frame {
+		int move_x, move_y; // mouse move in pixels
+		unsigned held, pressed;
+
+		Frame() : move_x(0), move_y(0), held(0), pressed(0) {}
+	};
+
+private:
+	std::ofstream file;
+
+public:
+	// others
+	bool open(const std::string &path);
+	bool is_open() const { return file.is_open(); }
+	void record(const Frame &frame);
+	static bool load(const std::string &path, std::vector<Frame> &frames, std::string &error);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "mappedfile.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+MappedFile::MappedFile(const std::string &path) : data(nullptr), size(0), opened(false) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat status;
+    if (fstat(fd, &status) == 0) {
+        size_t file_size = static_cast<size_t>(status.st_size);
+
+        if (file_size == 0)
+            opened = true;
+        else {
+            void *mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapping != MAP_FAILED) {
+                data   = static_cast<const char *>(mapping);
+                size   = file_size;
+                opened = true;
+                madvise(mapping, size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data)
+        munmap(const_cast<char *>(data), size);
+}
@@ -0,0 +1,30 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const char *data;
+    size_t size;
+    bool opened;
+
+public:
+    // constructors
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    ~MappedFile();
+
+    // operators
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    // others
+    bool is_open() const { return opened; }
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+    size_t get_size() const { return size; }
+};
+
+#endif
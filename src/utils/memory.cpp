@@ -0,0 +1,54 @@
+#include "memory.hpp"
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// resident memory of the process in bytes, 0 where not available
+size_t get_memory_usage() {
+#ifdef __linux__
+    long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1)
+            pages = 0;
+        fclose(statm);
+    }
+
+    return static_cast<size_t>(pages) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+// highest resident memory of the process in bytes
+size_t get_peak_memory_usage() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);        // bytes on macOS
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024; // kilobytes on linux
+#endif
+}
+
+// memory that can be allocated without swapping (MemAvailable) in bytes, 0 where not available
+size_t get_available_memory() {
+#ifdef __linux__
+    unsigned long kilobytes = 0;
+    char line[256];
+    FILE *meminfo = fopen("/proc/meminfo", "r");
+
+    if (meminfo) {
+        while (fgets(line, sizeof(line), meminfo))
+            if (sscanf(line, "MemAvailable: %lu kB", &kilobytes) == 1)
+                break;
+        fclose(meminfo);
+    }
+
+    return static_cast<size_t>(kilobytes) * 1024;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,13 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cstddef>
+
+#define MEMORY_BLOCK_OVERHEAD 16 // bytes of bookkeeping of every heap block
+#define MEMORY_NODE_OVERHEAD  48 // bytes of a std::map / std::set node besides its value, block included
+
+size_t get_memory_usage();
+size_t get_peak_memory_usage();
+size_t get_available_memory();
+
+#endif
@@ -1,9 +1,12 @@
 #include "parameters.hpp"
+#include <algorithm>
 
 unsigned Parameters::window_width  = INITIAL_WINDOW_WIDTH;
 unsigned Parameters::window_height = INITIAL_WINDOW_HEIGHT;
 std::vector<double> Parameters::cpu_usage;
 LoopTimer Parameters::print_CPU_usage_timer(sf::seconds(1));
+std::vector<double> Parameters::latency;
+LoopTimer Parameters::print_latency_timer(sf::seconds(1));
 
 
 void Parameters::update_window_size(const unsigned width, const unsigned height) {
@@ -42,3 +45,63 @@ void Parameters::print_mean_CPU_usage(std::ostream &os, const double main_loop_d
     }
 }
 
+// frame_latency: time in ms between the camera input sampling and the display of the frame built from it
+void Parameters::print_mean_latency(std::ostream &os, const double frame_latency) {
+
+    latency.push_back(frame_latency);
+
+    if (print_latency_timer.is_done()) {
+
+        // compute mean and max latency
+        double mean_latency = 0.0;
+        double max_latency  = 0.0;
+
+        for (auto x : latency) {
+            mean_latency += x;
+            max_latency = std::max(max_latency, x);
+        }
+
+        mean_latency /= latency.size();
+
+        // print mean latency, green under one frame, red over two frames
+        os << std::setprecision(1) << std::fixed;
+        os << LIGHT_GREY << "camera-to-photon latency (last 1s): ";
+        if (mean_latency <= MAX_MAIN_LOOP_DURATION)
+            os << GREEN;
+        else if (mean_latency >= 2 * MAX_MAIN_LOOP_DURATION)
+            os << RED;
+        else
+            os << ORANGE;
+
+        os << mean_latency << "ms (max " << max_latency << "ms)" << NO_COLOR << std::endl;
+
+
+        latency.clear();
+    }
+}
+
+// one JSON line summing up a replay: total and distribution of the frame times in ms,
+// generation_time being the time spent waiting for new shapes, not counted in frame_times
+void Parameters::print_frame_times(std::ostream &os, std::vector<double> frame_times, const double generation_time) {
+    if (frame_times.empty())
+        return;
+
+    std::sort(frame_times.begin(), frame_times.end());
+
+    double total = 0.0;
+    for (auto x : frame_times)
+        total += x;
+
+    auto percentile = [&frame_times](const double p) { return frame_times[static_cast<size_t>(p * (frame_times.size() - 1) + 0.5)]; };
+
+    os << std::setprecision(3) << std::fixed;
+    os << "{\"frames\":" << frame_times.size()
+       << ",\"total_ms\":" << total
+       << ",\"mean_ms\":" << total / frame_times.size()
+       << ",\"p50_ms\":" << percentile(0.5)
+       << ",\"p90_ms\":" << percentile(0.9)
+       << ",\"p99_ms\":" << percentile(0.99)
+       << ",\"max_ms\":" << frame_times.back()
+       << ",\"fps\":" << 1000.0 * frame_times.size() / total
+       << ",\"generation_ms\":" << generation_time << "}" << std::endl;
+}
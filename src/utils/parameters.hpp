@@ -22,10 +22,14 @@ public:
     static unsigned window_height;
     static std::vector<double> cpu_usage;
     static LoopTimer print_CPU_usage_timer;
+    static std::vector<double> latency;
+    static LoopTimer print_latency_timer;
 
 public:
     static void update_window_size(const unsigned width, const unsigned height);
     static void print_mean_CPU_usage(std::ostream &os, const double main_loop_duration);
+    static void print_mean_latency(std::ostream &os, const double frame_latency);
+    static void print_frame_times(std::ostream &os, std::vector<double> frame_times, const double generation_time);
 };
 
 #endif
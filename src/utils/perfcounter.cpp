@@ -0,0 +1,63 @@
+#include "perfcounter.hpp"
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+PerfCounter::PerfCounter() : fd(-1) {
+#ifdef __linux__
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size           = sizeof(attributes);
+    attributes.type           = PERF_TYPE_HARDWARE;
+    attributes.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled       = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv     = 1;
+
+    fd = static_cast<int>(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+}
+
+PerfCounter::~PerfCounter() {
+#ifdef __linux__
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+void PerfCounter::start() {
+#ifdef __linux__
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+// misses since start(), 0 if the counter is not open
+uint64_t PerfCounter::stop() {
+    uint64_t count = 0;
+
+#ifdef __linux__
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)))
+            count = 0;
+    }
+#endif
+
+    return count;
+}
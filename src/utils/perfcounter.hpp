@@ -0,0 +1,28 @@
+#ifndef PERFCOUNTER_HPP
+#define PERFCOUNTER_HPP
+
+#include <cstdint>
+
+// hardware counter of the last level cache misses of the calling thread (Linux perf events),
+// user space only, between start() and stop(); not open on other systems or where access to
+// the counters is refused (containers, kernel.perf_event_paranoid)
+class PerfCounter {
+private:
+    int fd;
+
+public:
+    // constructors
+    PerfCounter();
+    PerfCounter(const PerfCounter &) = delete;
+    ~PerfCounter();
+
+    // operators
+    PerfCounter& operator=(const PerfCounter &) = delete;
+
+    // others
+    bool is_open() const { return fd >= 0; }
+    void start();
+    uint64_t stop();
+};
+
+#endif
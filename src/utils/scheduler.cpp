@@ -0,0 +1,170 @@
+#include "scheduler.hpp"
+
+// ##############################################
+// ### constructors #############################
+// ##############################################
+
+// by default one worker per core, the main thread using the last one
+Scheduler::Scheduler(unsigned worker_count) : queued(0), next_worker(0), running(true) {
+    if (worker_count == 0)
+        worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (unsigned w = 0; w < worker_count; ++w)
+        workers.emplace_back(new Worker());
+    for (unsigned w = 0; w < worker_count; ++w)
+        threads.emplace_back(&Scheduler::work, this, w);
+}
+
+// the tasks still queued are dropped, their futures report a broken promise
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        running = false;
+    }
+    wake.notify_all();
+
+    for (auto &thread : threads)
+        thread.join();
+}
+
+
+// ##############################################
+// ### others ###################################
+// ##############################################
+
+Scheduler& Scheduler::get() {
+    static Scheduler scheduler;
+    return scheduler;
+}
+
+// index of the worker run by the calling thread, -1 outside the pool
+int& Scheduler::current_worker() {
+    static thread_local int worker = -1;
+    return worker;
+}
+
+// a worker pushes on its own deque, other threads spread their tasks over the workers
+void Scheduler::submit(const Task &task, const PRIORITY priority) {
+    int w = current_worker();
+    if (w < 0)
+        w = static_cast<int>(next_worker++ % workers.size());
+
+    {
+        std::lock_guard<std::mutex> lock(workers[w] -> mutex);
+        workers[w] -> tasks[static_cast<unsigned>(priority)].push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+// most urgent task down to priority lowest: the newest of the own deque of worker,
+// otherwise the oldest one of another deque (worker is -1 outside the pool)
+bool Scheduler::take(const int worker, const PRIORITY lowest, Task &task) {
+    if (queued == 0)
+        return false;
+
+    const unsigned count = static_cast<unsigned>(workers.size());
+    for (unsigned p = 0; p <= static_cast<unsigned>(lowest); ++p) {
+        if (worker >= 0) {
+            std::lock_guard<std::mutex> lock(workers[worker] -> mutex);
+            std::deque<Task> &own = workers[worker] -> tasks[p];
+            if (! own.empty()) {
+                task = std::move(own.back());
+                own.pop_back();
+                queued--;
+                return true;
+            }
+        }
+
+        const unsigned first = worker >= 0 ? static_cast<unsigned>(worker) + 1 : 0;
+        for (unsigned i = 0; i < count; ++i) {
+            const unsigned victim = (first + i) % count;
+            if (static_cast<int>(victim) == worker)
+                continue;
+
+            std::lock_guard<std::mutex> lock(workers[victim] -> mutex);
+            std::deque<Task> &other = workers[victim] -> tasks[p];
+            if (! other.empty()) {
+                task = std::move(other.front());
+                other.pop_front();
+                queued--;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// runs one pending task of priority lowest or more urgent, returns false if there was none
+bool Scheduler::run_one(const PRIORITY lowest) {
+    Task task;
+    if (! take(current_worker(), lowest, task))
+        return false;
+
+    task();
+    return true;
+}
+
+void Scheduler::work(const unsigned worker) {
+    current_worker() = static_cast<int>(worker);
+
+    while (true) {
+        Task task;
+        if (take(static_cast<int>(worker), PRIORITY::BACKGROUND, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this]() { return queued > 0 || ! running; });
+        if (! running)
+            return;
+    }
+}
+
+// a task that throws still counts as ended, so that no wait() is left waiting for it
+void Scheduler::TaskGroup::run(const Task &task) {
+    pending++;
+    try {
+        scheduler.submit([this, task]() {
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (! error)
+                    error = std::current_exception();
+            }
+            pending--;
+        }, priority);
+    }
+    catch (...) {
+        pending--;
+        throw;
+    }
+}
+
+// the waiting thread runs pending tasks meanwhile, only frame ones when it waits for frame
+// tasks so that a long background task never delays a frame
+void Scheduler::TaskGroup::join() {
+    while (pending > 0)
+        if (! scheduler.run_one(priority))
+            std::this_thread::yield();
+}
+
+// the exception is delivered once, the group can be used again afterwards
+void Scheduler::TaskGroup::wait() {
+    join();
+
+    std::exception_ptr thrown;
+    {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        std::swap(thrown, error);
+    }
+    if (thrown)
+        std::rethrow_exception(thrown);
+}
@@ -0,0 +1,125 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// engine-wide pool of worker threads, one per core besides the main thread, each one with
+// its own deques of tasks: a worker runs the newest task of its deque and steals the oldest
+// one of another worker when its deque is empty, so that the tasks spawned by a task stay on
+// its core while idle workers take the large remaining pieces.
+// Frame tasks (clip and project) are always taken before background ones (generation,
+// statistics, import and export), and a thread waiting for a group runs the pending tasks of
+// its priority itself: a frame never waits for a background task to end, generation and
+// rendering share the cores without starting a thread per job
+class Scheduler {
+public:
+    enum class PRIORITY : unsigned {FRAME, BACKGROUND};
+
+    typedef std::function<void()> Task;
+
+    // tasks that can be waited for together, the first exception thrown by one of them is
+    // rethrown by wait() once they have all ended
+    class TaskGroup {
+    private:
+        Scheduler &scheduler;
+        PRIORITY priority;
+        std::atomic<size_t> pending;
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        void join();
+
+    public:
+        // constructors
+        TaskGroup(const PRIORITY _priority = PRIORITY::FRAME, Scheduler &_scheduler = Scheduler::get()) : scheduler(_scheduler), priority(_priority), pending(0) {}
+        TaskGroup(const TaskGroup &) = delete;
+        ~TaskGroup() { join(); }
+
+        // operators
+        TaskGroup& operator=(const TaskGroup &) = delete;
+
+        // others
+        void run(const Task &task);
+        void wait();
+    };
+
+private:
+    static const unsigned PRIORITIES = 2;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks[PRIORITIES];
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued;       // tasks in the deques
+    std::atomic<unsigned> next_worker; // deque receiving the next task submitted from outside the pool
+    std::atomic_bool running;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+
+    static int& current_worker();
+    bool take(const int worker, const PRIORITY lowest, Task &task);
+    void work(const unsigned worker);
+
+public:
+    // constructors
+    explicit Scheduler(unsigned worker_count = 0);
+    Scheduler(const Scheduler &) = delete;
+    ~Scheduler();
+
+    // operators
+    Scheduler& operator=(const Scheduler &) = delete;
+
+    // others
+    static Scheduler& get();
+    unsigned get_concurrency() const { return static_cast<unsigned>(workers.size()) + 1; }
+    void submit(const Task &task, const PRIORITY priority = PRIORITY::BACKGROUND);
+    bool run_one(const PRIORITY lowest);
+
+    // f(b, e) on the consecutive ranges [b, e) of at most grain indices covering [begin, end),
+    // the calling thread takes part and returns when every range is done, rethrowing the first
+    // exception thrown by f
+    template <typename F>
+    void parallel_for(const size_t begin, const size_t end, size_t grain, const F &f, const PRIORITY priority = PRIORITY::FRAME) {
+        if (end <= begin)
+            return;
+
+        grain = std::max<size_t>(1, grain);
+        if (end - begin <= grain) {
+            f(begin, end);
+            return;
+        }
+
+        TaskGroup group(priority, *this);
+        for (size_t b = begin + grain; b < end; b += grain) {
+            const size_t e = std::min(end, b + grain);
+            group.run([&f, b, e]() { f(b, e); });
+        }
+        f(begin, std::min(end, begin + grain));
+        group.wait();
+    }
+
+    // f() on the pool, its result or exception delivered through the future
+    template <typename F>
+    auto async(const PRIORITY priority, F f) -> std::future<decltype(f())> {
+        auto task = std::make_shared<std::packaged_task<decltype(f())()>>(std::move(f));
+        std::future<decltype(f())> result = task -> get_future();
+
+        submit([task]() { (*task)(); }, priority);
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// lock-free bounded single producer / single consumer queue of N slots:
+//    - the producer calls push(), which fails instead of waiting when the queue is full
+//    - the consumer calls pop(), which fails when the queue is empty
+// head and tail only grow, each one written by a single side
+template <typename T, size_t N>
+class SpscQueue {
+private:
+    T slots[N];
+    alignas(64) std::atomic<size_t> head; // next slot to pop, owned by the consumer
+    alignas(64) std::atomic<size_t> tail; // next slot to push, owned by the producer
+
+public:
+    // constructors
+    SpscQueue() : head(0), tail(0) {}
+    SpscQueue(const SpscQueue &) = delete;
+
+    // operators
+    SpscQueue& operator=(const SpscQueue &) = delete;
+
+    // producer side, value is only moved from on success
+    bool push(T &value) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N)
+            return false;
+
+        slots[t % N] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool pop(T &value) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(slots[h % N]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <atomic>
+
+// lock-free single producer / single consumer triple buffer:
+//    - the producer fills write_buffer() then calls publish()
+//    - the consumer calls update() then reads read_buffer()
+// the producer never waits for the consumer and the consumer always sees the
+// most recently published buffer, intermediate ones are simply overwritten
+template <typename T>
+class TripleBuffer {
+private:
+    static const unsigned char INDEX_MASK = 0x3;
+    static const unsigned char DIRTY      = 0x4;
+
+    T buffers[3];
+    std::atomic<unsigned char> middle; // index of the exchanged buffer | DIRTY if not read yet
+    unsigned char back;                // owned by the producer
+    unsigned char front;               // owned by the consumer
+
+public:
+    // constructors
+    TripleBuffer() : middle(1), back(0), front(2) {}
+    TripleBuffer(const TripleBuffer &) = delete;
+
+    // operators
+    TripleBuffer& operator=(const TripleBuffer &) = delete;
+
+    // producer side
+    T& write_buffer() { return buffers[back]; }
+    void publish() { back = middle.exchange(back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK; }
+
+    // consumer side, returns true if a new buffer was published since the last call
+    bool update() {
+        if (! (middle.load(std::memory_order_acquire) & DIRTY))
+            return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    T& read_buffer() { return buffers[front]; }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "compare.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+typedef std::tuple<int64_t, int64_t, int64_t> Cell;
+
+static Cell getCell(const Vector3d& v, const double size) {
+  return Cell(static_cast<int64_t>(std::floor(v.get<0>() / size)),
+              static_cast<int64_t>(std::floor(v.get<1>() / size)),
+              static_cast<int64_t>(std::floor(v.get<2>() / size)));
+}
+
+static bool isClose(const Vector3d& u, const Vector3d& v, const double epsilon) {
+  return std::abs(u.get<0>() - v.get<0>()) <= epsilon && std::abs(u.get<1>() - v.get<1>()) <= epsilon && std::abs(u.get<2>() - v.get<2>()) <= epsilon;
+}
+
+static std::string describe(const Segment3d& s) {
+  std::ostringstream os;
+  os << "(" << s.a.get<0>() << ", " << s.a.get<1>() << ", " << s.a.get<2>() << ") - ("
+     << s.b.get<0>() << ", " << s.b.get<1>() << ", " << s.b.get<2>() << ")";
+  return os.str();
+}
+
+// the edges of b are indexed by the cell of their midpoint, a match of an edge of a has its
+// midpoint within epsilon hence in one of the 27 cells around
+bool haveSameEdges(const std::vector<Segment3d>& a, const std::vector<Segment3d>& b, const double epsilon, std::string& message) {
+  if (a.size() != b.size()) {
+    message = std::to_string(a.size()) + " edges instead of " + std::to_string(b.size());
+    return false;
+  }
+
+  const double size = 2 * epsilon;
+  std::map<Cell, std::vector<size_t>> cells;
+  for (size_t i = 0; i < b.size(); i++) {
+    cells[getCell((b[i].a + b[i].b) * 0.5, size)].push_back(i);
+  }
+
+  std::vector<bool> used(b.size(), false);
+  for (const Segment3d& s : a) {
+    const Cell cell = getCell((s.a + s.b) * 0.5, size);
+    bool found = false;
+
+    for (int64_t dx = -1; dx <= 1 && !found; dx++) {
+      for (int64_t dy = -1; dy <= 1 && !found; dy++) {
+        for (int64_t dz = -1; dz <= 1 && !found; dz++) {
+          auto candidates = cells.find(Cell(std::get<0>(cell) + dx, std::get<1>(cell) + dy, std::get<2>(cell) + dz));
+          if (candidates == cells.end()) {
+            continue;
+          }
+
+          for (size_t i : candidates->second) {
+            const Segment3d& t = b[i];
+            if (!used[i] && ((isClose(s.a, t.a, epsilon) && isClose(s.b, t.b, epsilon)) || (isClose(s.a, t.b, epsilon) && isClose(s.b, t.a, epsilon)))) {
+              used[i] = found = true;
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    if (!found) {
+      message = "no match for edge " + describe(s);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static double getLength(const sf::Vertex& a, const sf::Vertex& b) {
+  return std::hypot(double(a.position.x) - double(b.position.x), double(a.position.y) - double(b.position.y));
+}
+
+static bool isClose(const sf::Vertex& u, const sf::Vertex& v, const double epsilon) {
+  auto closeColor = [](const sf::Uint8 c, const sf::Uint8 d) { return std::abs(int(c) - int(d)) <= 1; };
+
+  return std::abs(double(u.position.x) - double(v.position.x)) <= epsilon * std::max(1.0, std::abs(double(v.position.x)))
+      && std::abs(double(u.position.y) - double(v.position.y)) <= epsilon * std::max(1.0, std::abs(double(v.position.y)))
+      && closeColor(u.color.r, v.color.r) && closeColor(u.color.g, v.color.g) && closeColor(u.color.b, v.color.b) && closeColor(u.color.a, v.color.a);
+}
+
+bool haveSameFigure(const std::vector<sf::Vertex>& reference, const sf::Vertex* figure, const size_t count, const double epsilon, std::string& message) {
+  size_t i = 0, j = 0;
+
+  while (i < reference.size() || j < count) {
+    if (i < reference.size() && j < count && isClose(figure[j], reference[i], epsilon) && isClose(figure[j + 1], reference[i + 1], epsilon)) {
+      i += 2;
+      j += 2;
+    }
+    else if (i < reference.size() && getLength(reference[i], reference[i + 1]) < epsilon) {
+      i += 2;
+    }
+    else if (j < count && getLength(figure[j], figure[j + 1]) < epsilon) {
+      j += 2;
+    }
+    else {
+      std::ostringstream os;
+      os << "segment " << i / 2 << " of the reference differs from segment " << j / 2 << " of " << count / 2;
+      if (i < reference.size()) {
+        os << ", expected (" << reference[i].position.x << ", " << reference[i].position.y << ") - (" << reference[i + 1].position.x << ", " << reference[i + 1].position.y << ")";
+      }
+      if (j < count) {
+        os << ", got (" << figure[j].position.x << ", " << figure[j].position.y << ") - (" << figure[j + 1].position.x << ", " << figure[j + 1].position.y << ")";
+      }
+      message = os.str();
+      return false;
+    }
+  }
+
+  return true;
+}
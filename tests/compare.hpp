@@ -0,0 +1,19 @@
+#ifndef COMPARE_HPP
+#define COMPARE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "geometry/segment3d.hpp"
+
+// true if every edge of a matches an edge of b, each one used once, whose endpoints are
+// at most epsilon away from its own in either order, otherwise message tells the first
+// edge without a match
+bool haveSameEdges(const std::vector<Segment3d>& a, const std::vector<Segment3d>& b, const double epsilon, std::string& message);
+
+// true if the two vertex buffers list the same segments in the same order, positions within
+// epsilon pixels (relative to their magnitude beyond 1 pixel) and colors within 1, segments
+// shorter than epsilon may be missing from either side, they come from edges grazing a plane
+bool haveSameFigure(const std::vector<sf::Vertex>& reference, const sf::Vertex* figure, const size_t count, const double epsilon, std::string& message);
+
+#endif
@@ -0,0 +1,653 @@
+#include "reference.hpp"
+#include "compare.hpp"
+#include "geometry/geometry.hpp"
+#include "geometry/instance3d.hpp"
+#include "geometry/scene3d.hpp"
+#include "engine/rectification.hpp"
+#include "engine/shapecounts.hpp"
+#include "engine/iterationhistory.hpp"
+#include "geometry/meshsimplifier.hpp"
+#include "engine/distributedrectifier.hpp"
+#include "engine/sharedpublisher.hpp"
+#include "engine/rectificationserver.hpp"
+#include "utils/scheduler.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// differential tests: the optimized paths of the engine against the frozen implementations
+// of reference.hpp, on random seeds, camera poses and iterations 1 to N
+//   usage: 3D-engine-tests [iterations N] [seeds] [random seed]
+
+static std::mt19937 generator;
+static unsigned checks = 0;
+static unsigned failures = 0;
+
+static double uniform(const double a, const double b) {
+  return std::uniform_real_distribution<double>(a, b)(generator);
+}
+
+static void check(const bool ok, const std::string& what, const std::string& message) {
+  checks++;
+  if (!ok) {
+    failures++;
+    std::cout << "FAIL " << what << ": " << message << std::endl;
+  }
+}
+
+// cube or tetrahedron of random size, orientation and position whose vertices are moved a
+// little, the faces following them
+static Solid3d getRandomSeed(const unsigned index, double& size) {
+  size = uniform(40, 200);
+  Solid3d seed = index % 2 == 0 ? Solid3d(Cube3d(Vector3d(), size)) : Solid3d(Tetrahedron3d(size));
+
+  std::map<Vector3d, Vector3d> moved;
+  auto move = [&](const Vector3d& v) {
+    auto found = moved.find(v);
+    if (found == moved.end()) {
+      found = moved.emplace(v, Vector3d(v.get<0>() + uniform(-0.02, 0.02) * size, v.get<1>() + uniform(-0.02, 0.02) * size, v.get<2>() + uniform(-0.02, 0.02) * size)).first;
+    }
+    return found->second;
+  };
+  for (Segment3d& edge : seed.edges) {
+    edge = Segment3d(move(edge.a), move(edge.b));
+  }
+  for (Face3d& face : seed.faces) {
+    Face3d jittered(seed.edges, face.edges);
+    jittered.orient(face.normal);
+    face = jittered;
+  }
+
+  seed.rotate(Vector3d(), Vector3d(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)), uniform(0, 360));
+  seed += Vector3d(uniform(-100, 100), uniform(-100, 100), uniform(-100, 100));
+  seed.build_clusters();
+  return seed;
+}
+
+// cube or tetrahedron of random size, orientation and position keeping all its rotations
+static Solid3d getSymmetricSeed(const unsigned index, double& size) {
+  size = uniform(40, 200);
+  Solid3d seed = index % 2 == 0 ? Solid3d(Cube3d(Vector3d(), size)) : Solid3d(Tetrahedron3d(size));
+
+  seed.rotate(Vector3d(), Vector3d(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1)), uniform(0, 360));
+  seed += Vector3d(uniform(-100, 100), uniform(-100, 100), uniform(-100, 100));
+  seed.build_clusters();
+  return seed;
+}
+
+// camera looking at the sphere from outside, off axis and rolled
+static ReferenceCamera getRandomCamera(const Vector3d& center, const double radius) {
+  static const unsigned sizes[][2] = {{800, 600}, {1280, 720}, {1900, 1200}};
+  const unsigned* size = sizes[generator() % 3];
+
+  Vector3d direction(uniform(-1, 1), uniform(-1, 1), uniform(-1, 1));
+  direction.normalize();
+
+  ReferenceCamera camera;
+  camera.position = center - direction * (radius * uniform(1.2, 4.0));
+  camera.thetaX = -asin(direction.get<1>()) * 180.0 / M_PI + uniform(-15, 15);
+  camera.thetaY = atan2(direction.get<0>(), direction.get<2>()) * 180.0 / M_PI + uniform(-15, 15);
+  camera.thetaZ = uniform(-20, 20);
+  camera.width = size[0];
+  camera.height = size[1];
+  return camera;
+}
+
+// the iterations of every mode against referenceNextShape() and their statistics against referenceStats(),
+// the shapes restored from their compressed copies as well, and the iterations computed from them
+static void checkRectification(const Solid3d& seed, const double size, const unsigned iterations, const std::string& name) {
+  std::atomic_bool cancel(false);
+  Solid3d faceless;
+  faceless.edges = seed.edges;
+
+  std::vector<std::pair<std::string, Rectifier>> rectifiers = {
+    {"default", Rectifier(seed)},
+    {"default without faces", Rectifier(faceless)},
+    {"exact", Rectifier(seed, Rectifier::MODE::EXACT)},
+    {"symmetric", Rectifier(seed, Rectifier::MODE::SYMMETRIC)},
+    {"default along a hilbert curve", Rectifier(seed).with_curve(Solid3d::CURVE::HILBERT)},
+    {"exact along a morton curve", Rectifier(seed, Rectifier::MODE::EXACT).with_curve(Solid3d::CURVE::MORTON)}
+  };
+
+  const double epsilon = 1e-5 + 1e-6 * size;
+  Solid3d reference = faceless;
+  std::string message;
+  for (unsigned i = 1; i <= iterations; i++) {
+    reference = referenceNextShape(reference);
+    const std::string stats = referenceStats(reference);
+
+    for (auto& rectifier : rectifiers) {
+      rectifier.second = rectifier.second.get_next(cancel);
+      const std::string what = name + " iteration " + std::to_string(i) + " " + rectifier.first;
+      const Solid3d& shape = *rectifier.second.get_shape();
+
+      check(haveSameEdges(shape.edges, reference.edges, epsilon, message), what + " edges", message);
+      check(getStats(shape) == stats, what + " statistics", "\n" + getStats(shape) + "instead of\n" + stats);
+
+      const Rectifier restored = CompressedIteration(rectifier.second).restore();
+      const Solid3d& restoredShape = *restored.get_shape();
+      check(restored.get_iteration() == i && restored.get_mode() == rectifier.second.get_mode(), what + " restored iteration", "iteration " + std::to_string(restored.get_iteration()));
+      check(haveSameEdges(restoredShape.edges, shape.edges, epsilon, message), what + " restored edges", message);
+      check(getStats(restoredShape) == getStats(shape), what + " restored statistics", "\n" + getStats(restoredShape) + "instead of\n" + getStats(shape));
+
+      // the restored iteration goes on as the original one, on the same lattice or group
+      const Rectifier next = rectifier.second.get_next(cancel);
+      const Rectifier restoredNext = restored.get_next(cancel);
+      check(restoredNext.get_symmetry_order() == next.get_symmetry_order(), what + " restored symmetry", "order " + std::to_string(restoredNext.get_symmetry_order()) + " instead of " + std::to_string(next.get_symmetry_order()));
+      check(haveSameEdges(restoredNext.get_shape()->edges, next.get_shape()->edges, epsilon, message), what + " restored next edges", message);
+      if (next.get_exact_shape()) {
+        const ExactSolid3d& exact = *next.get_exact_shape();
+        const ExactSolid3d& restoredExact = *restoredNext.get_exact_shape();
+        check(restoredExact.shift == exact.shift && restoredExact.vertices == exact.vertices && restoredExact.edges == exact.edges, what + " restored next lattice", "shift " + std::to_string(restoredExact.shift) + " instead of " + std::to_string(exact.shift));
+      }
+    }
+
+    const std::string predicted = ShapeCounts::predict(seed, i).get_stats();
+    check(predicted == stats, name + " iteration " + std::to_string(i) + " predicted statistics", "\n" + predicted + "instead of\n" + stats);
+  }
+}
+
+// the symmetric mode on a seed whose group has order rotations: every iteration keeps the whole
+// group, so that the orbits and stabilizers are exercised, and matches referenceNextShape()
+static void checkSymmetry(const Solid3d& seed, const double size, const unsigned iterations, const size_t order, const std::string& name) {
+  std::atomic_bool cancel(false);
+  Rectifier rectifier(seed, Rectifier::MODE::SYMMETRIC);
+  Solid3d reference;
+  reference.edges = seed.edges;
+
+  const double epsilon = 1e-5 + 1e-6 * size;
+  std::string message;
+  check(rectifier.get_symmetry_order() == order, name + " iteration 0 symmetry", "order " + std::to_string(rectifier.get_symmetry_order()) + " instead of " + std::to_string(order));
+  for (unsigned i = 1; i <= iterations; i++) {
+    reference = referenceNextShape(reference);
+    rectifier = rectifier.get_next(cancel);
+    const std::string what = name + " iteration " + std::to_string(i);
+
+    check(rectifier.get_symmetry_order() == order, what + " symmetry", "order " + std::to_string(rectifier.get_symmetry_order()) + " instead of " + std::to_string(order));
+    check(haveSameEdges(rectifier.get_shape()->edges, reference.edges, epsilon, message), what + " symmetric edges", message);
+  }
+}
+
+// the figure of shape built by Solid3d, with and without clusters, by Scene3d on several
+// copies and by an identity Instance3d, against referenceFigure(); at half the edges, against
+// the figure of the edges kept alone
+static void checkProjection(const Solid3d& shape, const unsigned cameras, const std::string& name) {
+  const double epsilon = 1e-3;
+  const size_t copies = 4;
+  const double edgeRatio = 0.5;
+  Solid3d unclustered = shape;
+  unclustered.clusters.clear();
+
+  Solid3d decimated;
+  const uint32_t threshold = Solid3d::get_edge_threshold(edgeRatio);
+  for (size_t i = 0; i < shape.edges.size(); i++) {
+    if (Solid3d::is_edge_kept(i, threshold)) {
+      decimated.add_segment(shape.edges[i]);
+    }
+  }
+
+  std::shared_ptr<const Solid3d> shared = std::make_shared<const Solid3d>(shape);
+  Scene3d copiesScene, instanceScene;
+  for (size_t c = 0; c < copies; c++) {
+    copiesScene.add(shared);
+  }
+  instanceScene.add(Instance3d(shared, Vector3d()));
+
+  Vector3d center;
+  double radius;
+  shape.get_bounding_sphere(center, radius);
+
+  sf::VertexArray figure(sf::Lines);
+  std::string message;
+  for (unsigned c = 0; c < cameras; c++) {
+    const ReferenceCamera pose = getRandomCamera(center, radius);
+    const Camera3d camera(pose.position, pose.thetaX, pose.thetaY, pose.thetaZ, pose.width, pose.height);
+    const std::vector<sf::Vertex> reference = referenceFigure(shape, pose);
+    const std::string what = name + " camera " + std::to_string(c);
+
+    auto checkFigure = [&](const std::vector<sf::Vertex>& expected, const std::string& path) {
+      const sf::Vertex* vertices = figure.getVertexCount() ? &figure[0] : nullptr;
+      check(haveSameFigure(expected, vertices, figure.getVertexCount(), epsilon, message), what + " " + path, message);
+    };
+
+    shape.build_figure(figure, pose.width, pose.height, camera);
+    checkFigure(reference, "Solid3d");
+
+    unclustered.build_figure(figure, pose.width, pose.height, camera);
+    checkFigure(reference, "Solid3d without clusters");
+
+    std::vector<sf::Vertex> repeated;
+    for (size_t copy = 0; copy < copies; copy++) {
+      repeated.insert(repeated.end(), reference.begin(), reference.end());
+    }
+    copiesScene.build_figure(figure, pose.width, pose.height, camera);
+    checkFigure(repeated, "Scene3d");
+
+    instanceScene.build_figure(figure, pose.width, pose.height, camera);
+    checkFigure(reference, "Instance3d");
+
+    const std::vector<sf::Vertex> decimatedReference = referenceFigure(decimated, pose);
+    shape.build_figure(figure, pose.width, pose.height, camera, false, nullptr, edgeRatio);
+    checkFigure(decimatedReference, "Solid3d at half the edges");
+
+    instanceScene.edge_ratio = edgeRatio;
+    instanceScene.build_figure(figure, pose.width, pose.height, camera);
+    instanceScene.edge_ratio = 1.0;
+    checkFigure(decimatedReference, "Instance3d at half the edges");
+  }
+}
+
+// the simplifications of shape, with its faces and without: unchanged when the target is not
+// below its edge count, otherwise at most the target of edges, none of them degenerate nor
+// repeated, inside the bounding sphere widened by the error bound, which an error tolerance keeps
+static void checkSimplification(const Solid3d& shape, const std::string& name) {
+  std::atomic_bool cancel(false);
+  Solid3d faceless;
+  faceless.edges = shape.edges;
+
+  Vector3d center;
+  double radius;
+  shape.get_bounding_sphere(center, radius);
+  const double epsilon = 1e-9 * radius;
+  const double tolerance = 1e-3 * radius;
+  std::string message;
+
+  const std::vector<const Solid3d*> sources = {&shape, &faceless};
+  for (const Solid3d* source : sources) {
+    const std::string what = name + (source->faces.empty() ? " simplified without faces" : " simplified");
+
+    MeshSimplifier unchanged(*source);
+    check(unchanged.simplify(source->edges.size(), 0.0, cancel) && unchanged.get_error() == 0.0, what + " above its edges", "error " + std::to_string(unchanged.get_error()));
+    check(haveSameEdges(unchanged.get_shape().edges, source->edges, epsilon, message), what + " above its edges", message);
+
+    const size_t target = source->edges.size() / 4;
+    MeshSimplifier simplifier(*source);
+    simplifier.simplify(target, 0.0, cancel);
+    const Solid3d simplified = simplifier.get_shape();
+    check(simplified.edges.size() <= target && simplified.edges.size() == simplifier.get_edge_count(), what + " edge count", std::to_string(simplified.edges.size()) + " edges for " + std::to_string(target));
+
+    std::map<std::pair<Vector3d, Vector3d>, unsigned> edges;
+    size_t degenerate = 0, repeated = 0, outside = 0;
+    for (const Segment3d& edge : simplified.edges) {
+      degenerate += edge.a == edge.b;
+      repeated += edges[edge.a < edge.b ? std::make_pair(edge.a, edge.b) : std::make_pair(edge.b, edge.a)]++ > 0;
+      outside += (edge.a - center).norm() > radius + simplifier.get_error() + epsilon || (edge.b - center).norm() > radius + simplifier.get_error() + epsilon;
+    }
+    check(degenerate == 0 && repeated == 0, what + " edges", std::to_string(degenerate) + " degenerate and " + std::to_string(repeated) + " repeated edges");
+    check(outside == 0, what + " bounds", std::to_string(outside) + " edges farther than the error " + std::to_string(simplifier.get_error()));
+
+    MeshSimplifier bounded(*source);
+    bounded.simplify(0, tolerance, cancel);
+    check(bounded.get_error() <= tolerance && bounded.get_edge_count() <= source->edges.size(), what + " within the tolerance", "error " + std::to_string(bounded.get_error()));
+  }
+}
+
+// the exact iterations of seed computed by regions as the worker processes do, through the frames
+// of DistributedRectifier but without the processes: the same vertices and edges as getNextShape()
+// whatever the number of regions, and an answer cut short refused
+static void checkDistribution(const Solid3d& seed, const unsigned iterations, const std::string& name) {
+  std::atomic_bool cancel(false);
+  ExactSolid3d shape(seed);
+
+  for (unsigned i = 1; i <= iterations; i++) {
+    const ExactSolid3d expected = getNextShape(shape, cancel, 1);
+
+    for (const unsigned count : {1u, 3u, 7u}) {
+      const std::string what = name + " iteration " + std::to_string(i) + " in " + std::to_string(count) + " regions";
+      const std::vector<uint32_t> regions = DistributedRectifier::get_regions(shape, count);
+      std::vector<std::vector<uint8_t>> answers(count);
+      std::string error;
+      bool answered = true;
+      for (uint32_t r = 0; r < count; r++) {
+        std::vector<uint8_t> request;
+        DistributedRectifier::write_region(shape, regions, r, request);
+        answered = DistributedRectifier::answer_region(request, answers[r], error) && answered;
+      }
+
+      ExactSolid3d next;
+      const bool stitched = answered && DistributedRectifier::stitch(shape, regions, answers, next, error);
+      check(stitched && next.shift == expected.shift && next.vertices == expected.vertices && next.edges == expected.edges, what, stitched ? std::to_string(next.edges.size()) + " edges instead of " + std::to_string(expected.edges.size()) : error);
+
+      answers[count - 1].pop_back();
+      check(!DistributedRectifier::stitch(shape, regions, answers, next, error), what + " truncated answer", "stitched");
+    }
+
+    shape = expected;
+  }
+}
+
+// a throwing task of the scheduler ends its group like the others: wait() and parallel_for()
+// rethrow the first exception once every task is done, and another group whose waiting thread
+// ran the throwing task still ends
+static void checkScheduler() {
+  Scheduler scheduler(3);
+  std::atomic<unsigned> done(0);
+  std::string caught;
+
+  try {
+    scheduler.parallel_for(0, 64, 1, [&](const size_t b, const size_t) {
+      if (b % 16 == 5) {
+        throw std::runtime_error("range " + std::to_string(b));
+      }
+      done++;
+    });
+  }
+  catch (const std::runtime_error& e) {
+    caught = e.what();
+  }
+  check(caught.compare(0, 6, "range ") == 0 && done == 60, "scheduler", "parallel_for threw \"" + caught + "\" after " + std::to_string(done) + " ranges");
+
+  Scheduler::TaskGroup thrower(Scheduler::PRIORITY::FRAME, scheduler);
+  Scheduler::TaskGroup other(Scheduler::PRIORITY::FRAME, scheduler);
+  done = 0;
+  for (unsigned t = 0; t < 32; t++) {
+    thrower.run([]() { throw std::bad_alloc(); });
+    other.run([&]() { done++; });
+  }
+  other.wait();
+  check(done == 32, "scheduler", "the other group ran " + std::to_string(done) + " tasks of 32");
+
+  bool rethrown = false;
+  try {
+    thrower.wait();
+  }
+  catch (const std::bad_alloc&) {
+    rethrown = true;
+  }
+  check(rethrown, "scheduler", "the exception of a group was not rethrown by wait()");
+
+  thrower.run([&]() { done++; });
+  thrower.wait();
+  check(done == 33, "scheduler", "a group did not run again after its exception");
+}
+
+// the seqlock of sharedlayout.hpp: a read overlapping a write is retried and a write in progress
+// is waited for, a reader of the frames of SharedPublisher never accepts a torn one, and --share
+// refuses the object of a running engine but replaces the leftover of a dead one
+static void checkSharedMemory() {
+  std::atomic<uint64_t> sequence(4);
+  unsigned reads = 0;
+  unsigned attempts = readSharedBlock(sequence, [&]() {
+    if (reads++ == 0) {
+      sequence += 2; // a whole write during the first read
+    }
+  });
+  check(attempts == 2 && reads == 2, "seqlock", "read " + std::to_string(reads) + " times across a write");
+
+  sequence = 5; // write in progress
+  reads = 0;
+  std::thread writer([&sequence]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sequence = 6;
+  });
+  attempts = readSharedBlock(sequence, [&]() { reads += sequence == 6 ? 1 : 100; });
+  writer.join();
+  check(attempts > 1 && reads == 1, "seqlock", "read while the sequence was odd");
+
+  const std::string name = "/3D-engine-tests-" + std::to_string(getpid());
+  std::string error;
+  SharedPublisher publisher;
+  if (!publisher.open(name, error)) {
+    check(false, "shared memory", error);
+    return;
+  }
+  SharedPublisher other;
+  check(!other.open(name, error), "shared memory", "object of a running engine replaced");
+
+  // every vertex of frame f has the color (f % 256, f / 256), a torn frame mixes two of them
+  std::atomic_bool done(false);
+  std::atomic<unsigned> frames(0), retried(0), torn(0);
+  std::thread reader([&]() {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    struct stat status;
+    fstat(fd, &status);
+    void *shared = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    const uint8_t *mapping = static_cast<const uint8_t*>(shared);
+    const SharedHeader &header = *reinterpret_cast<const SharedHeader*>(mapping);
+    std::vector<sf::Vertex> vertices;
+
+    while (!done) {
+      const uint64_t count = header.frame_count.load(std::memory_order_acquire);
+      if (count == 0) {
+        continue;
+      }
+      const uint8_t *slot = mapping + header.frame_offset + (count - 1) % header.frame_slots * header.frame_stride;
+      const SharedFrame &frame = *reinterpret_cast<const SharedFrame*>(slot);
+      uint64_t number = 0;
+      const unsigned attempts = readSharedBlock(frame.sequence, [&]() {
+        number = frame.number;
+        const sf::Vertex *first = reinterpret_cast<const sf::Vertex*>(slot + sizeof(SharedFrame));
+        vertices.assign(first, first + frame.vertex_count);
+      });
+      if (attempts > 1) {
+        retried++;
+      }
+      for (const auto &vertex : vertices) {
+        if (vertex.color.r != number % 256 || vertex.color.g != number / 256 % 256) {
+          torn++;
+          break;
+        }
+      }
+      frames++;
+    }
+    munmap(shared, static_cast<size_t>(status.st_size));
+  });
+
+  sf::VertexArray figure(sf::Lines, 20000);
+  for (unsigned f = 0; f < 300 || frames == 0; f++) {
+    for (size_t v = 0; v < figure.getVertexCount(); v++) {
+      figure[v].color = sf::Color(static_cast<sf::Uint8>(f % 256), static_cast<sf::Uint8>(f / 256 % 256), 0);
+    }
+    publisher.publish_frame(figure, 640, 480, std::chrono::steady_clock::now());
+  }
+  done = true;
+  reader.join();
+  check(torn == 0, "shared memory", std::to_string(torn) + " torn frames of " + std::to_string(frames) + " accepted, " + std::to_string(retried) + " retried");
+
+  // object left by an engine whose process is gone
+  const pid_t child = fork();
+  if (child == 0) {
+    _exit(0);
+  }
+  waitpid(child, nullptr, 0);
+  const std::string stale = name + "-stale";
+  const int fd = shm_open(stale.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd >= 0 && ftruncate(fd, sizeof(SharedHeader)) == 0) {
+    void *shared = mmap(nullptr, sizeof(SharedHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    SharedHeader *header = new (shared) SharedHeader();
+    header->layout_version = SHARED_LAYOUT_VERSION;
+    header->writer_pid = child;
+    header->magic = SHARED_MAGIC;
+    munmap(shared, sizeof(SharedHeader));
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+  SharedPublisher replacing;
+  check(replacing.open(stale, error), "shared memory", "leftover of a dead engine: " + error);
+}
+
+// the answer of the server on path to one request: its header line and the bytes announced
+static std::string askServer(const std::string& path, const std::string& request) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, path.c_str(), path.size());
+
+  const int socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  std::string answer;
+  if (connect(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 && send(socket, request.data(), request.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(request.size())) {
+    char buffer[4096];
+    size_t expected = std::string::npos;
+    while (answer.size() != expected) {
+      const ssize_t received = recv(socket, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        break;
+      }
+      answer.append(buffer, static_cast<size_t>(received));
+
+      const size_t end = answer.find('\n');
+      if (expected == std::string::npos && end != std::string::npos) {
+        expected = answer.compare(0, 3, "ok ") == 0 ? end + 1 + std::stoul(answer.substr(3, end - 3)) : end + 1;
+      }
+    }
+  }
+  close(socket);
+
+  return answer;
+}
+
+// the origins (computed, cached or coalesced) of the requests logged by the server, one per
+// connection, in the order of the connections: a line is logged after its answer is sent, so
+// the lines of successive connections may be swapped
+static std::vector<std::string> getOrigins(const std::string& log) {
+  std::map<unsigned, std::string> origins;
+  std::istringstream lines(log);
+  const std::string client = "{\"client\":", origin = "\"origin\":\"";
+
+  for (std::string line; std::getline(lines, line); ) {
+    const size_t found = line.find(origin);
+    if (line.compare(0, client.size(), client) == 0 && found != std::string::npos) {
+      const size_t start = found + origin.size();
+      origins[static_cast<unsigned>(std::stoul(line.substr(client.size())))] = line.substr(start, line.find('"', start) - start);
+    }
+  }
+
+  std::vector<std::string> ordered;
+  for (const auto& o : origins) {
+    ordered.push_back(o.second);
+  }
+  return ordered;
+}
+
+// the requests of --serve through its socket: malformed ones refused, the statistics of an
+// iteration, identical concurrent requests sharing one computation, and the least recently used
+// iterations evicted from a cache that holds two of the seeds of the cube in its three modes
+static void checkServer() {
+  const std::string path = "/tmp/3D-engine-tests-" + std::to_string(getpid()) + ".sock";
+  const std::pair<std::string, std::string> refused[] = {
+    {"draw cube 1\n", "error unknown command, expected stats or mesh\n"},
+    {"stats cube\n", "error expected stats SEED ITERATION\n"},
+    {"stats cube -1\n", "error expected stats SEED ITERATION\n"},
+    {"stats cube 33\n", "error iteration above 32\n"},
+    {"mesh cube 999999999999\n", "error iteration above 32\n"},
+    {"stats cube 1 fast\n", "error unknown mode fast\n"},
+    {"mesh cube 1 exact stl\n", "error unknown format stl\n"},
+    {"stats cube 1 exact obj\n", "error unexpected obj\n"},
+    {"stats nowhere.ply 0\n", "error cannot load the seed nowhere.ply\n"},
+    {std::string(SERVER_MAX_REQUEST + 1, 'x'), "error request too long\n"},
+  };
+
+  Solid3d seed;
+  getSeed("cube", seed);
+  size_t seeds = 0;
+  for (const auto mode : {Rectifier::MODE::DEFAULT, Rectifier::MODE::EXACT, Rectifier::MODE::SYMMETRIC}) {
+    seeds += Rectifier(seed, mode).with_curve(Options().curve).get_memory_usage();
+  }
+
+  std::ostringstream log;
+  RectificationServer server(Options(), log, seeds - 1);
+  std::string error;
+  if (!server.listen(path, error)) {
+    check(false, "server", error);
+    return;
+  }
+  std::atomic_bool stop(false);
+  std::thread running([&]() { server.run(stop); });
+
+  for (const auto& request : refused) {
+    const std::string answer = askServer(path, request.first);
+    check(answer == request.second, "server request " + request.first.substr(0, 32), answer);
+  }
+
+  const std::string stats = askServer(path, "stats tetrahedron 1\r\n");
+  check(stats.compare(0, 3, "ok ") == 0 && stats.find("\"iteration\":1,") != std::string::npos && stats.find("\"edges\":12,") != std::string::npos, "server stats", stats);
+
+  std::string answers[2];
+  std::thread clients[2];
+  for (unsigned c = 0; c < 2; c++) {
+    clients[c] = std::thread([&answers, &path, c]() { answers[c] = askServer(path, "stats tetrahedron 13\n"); });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  // the least recently used seed is evicted by the third one: exact, then default
+  for (const std::string mode : {"default", "exact", "default", "symmetric", "exact", "symmetric"}) {
+    askServer(path, "stats cube 0 " + mode + "\n");
+  }
+
+  stop = true;
+  running.join();
+
+  const std::vector<std::string> origins = getOrigins(log.str());
+  const size_t logged = sizeof(refused) / sizeof(refused[0]) - 1 + 1; // the line too long is not a request, the statistics are
+  check(origins.size() == logged + 8, "server log", std::to_string(origins.size()) + " requests logged");
+  if (origins.size() != logged + 8) {
+    return;
+  }
+
+  const std::string& first = origins[logged];
+  const std::string& second = origins[logged + 1];
+  check(answers[0] == answers[1] && answers[0].compare(0, 3, "ok ") == 0, "server concurrent requests", answers[0] + answers[1]);
+  check((first == "computed") != (second == "computed") && (first == "coalesced" || second == "coalesced" || first == "cached" || second == "cached"), "server concurrent requests", first + " and " + second);
+
+  const std::vector<std::string> expected = {"computed", "computed", "cached", "computed", "computed", "cached"};
+  check(std::vector<std::string>(origins.begin() + static_cast<long>(logged) + 2, origins.end()) == expected, "server cache", "unexpected origins of the least recently used requests");
+}
+
+int main(int argc, char* argv[]) {
+  const unsigned iterations = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 6;
+  const unsigned seeds = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 6;
+  const unsigned randomSeed = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 2018;
+  const unsigned cameras = 4;
+
+  generator.seed(randomSeed);
+  std::cout << iterations << " iterations of " << seeds << " random seeds, random seed " << randomSeed << std::endl;
+
+  std::atomic_bool cancel(false);
+  for (unsigned s = 0; s < seeds; s++) {
+    double size;
+    const Solid3d seed = getRandomSeed(s, size);
+    const std::string name = std::string(s % 2 == 0 ? "cube " : "tetrahedron ") + std::to_string(s);
+
+    checkRectification(seed, size, iterations, name);
+    checkDistribution(seed, iterations, name);
+
+    Rectifier rectifier(seed);
+    checkProjection(*rectifier.get_shape(), cameras, name + " iteration 0");
+    for (unsigned i = 1; i <= iterations; i++) {
+      rectifier = rectifier.get_next(cancel);
+      checkProjection(*rectifier.get_shape(), cameras, name + " iteration " + std::to_string(i));
+    }
+    checkSimplification(*rectifier.get_shape(), name + " iteration " + std::to_string(iterations));
+  }
+  for (unsigned s = 0; s < 2; s++) {
+    double size;
+    const Solid3d seed = getSymmetricSeed(s, size);
+    const std::string name = std::string(s % 2 == 0 ? "symmetric cube" : "symmetric tetrahedron");
+
+    checkRectification(seed, size, iterations, name);
+    checkSymmetry(seed, size, iterations, s % 2 == 0 ? 24 : 12, name);
+  }
+  checkScheduler();
+  checkSharedMemory();
+  checkServer();
+
+  std::cout << checks << " checks, " << failures << " failures" << std::endl;
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
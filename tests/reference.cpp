@@ -0,0 +1,169 @@
+#include "reference.hpp"
+#include <algorithm>
+#include <map>
+#include "geometry/plane3d.hpp"
+
+Solid3d referenceNextShape(const Solid3d& shape) {
+  std::map<Vector3d, std::vector<Vector3d>> kMap;
+  for (const Segment3d& edge : shape.edges) {
+    Vector3d midpoint = (edge.a + edge.b) * 0.5;
+    midpoint.set_color(sf::Color::White);
+    kMap[edge.a].push_back(midpoint);
+    kMap[edge.b].push_back(midpoint);
+  }
+
+  Solid3d nextShape;
+  for (const auto& vertex : kMap) {
+    std::vector<Vector3d> midpoints = vertex.second;
+
+    // order points to be connected in correct order to create polygon
+    for (size_t i = 0; i < midpoints.size() - 1; i++) {
+      size_t nextVertex = i + 1;
+      double length = (midpoints[i] - midpoints[nextVertex]).norm();
+
+      for (size_t j = i + 2; j < midpoints.size(); j++) {
+        double currentLength = (midpoints[i] - midpoints[j]).norm();
+        if (currentLength < length) {
+          nextVertex = j;
+          length = currentLength;
+        }
+      }
+
+      if (nextVertex != i + 1) {
+        std::swap(midpoints[i + 1], midpoints[nextVertex]);
+      }
+    }
+
+    // connect midpoints of vertex
+    for (size_t i = 0; i < midpoints.size(); i++) {
+      Segment3d edge = Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]);
+
+      if (std::find(nextShape.edges.begin(), nextShape.edges.end(), edge) == nextShape.edges.end()) {
+        nextShape.add_segment(Segment3d(midpoints[i], midpoints[(i + 1) % midpoints.size()]));
+      }
+    }
+  }
+
+  return nextShape;
+}
+
+std::string referenceStats(const Solid3d& shape) {
+  std::string stats;
+
+  size_t faces, edges, vertices;
+  std::map<Vector3d, size_t> edgesPerVertex;
+
+  edges = shape.edges.size();
+  for (const Segment3d& edge : shape.edges) {
+    edgesPerVertex[edge.a]++;
+    edgesPerVertex[edge.b]++;
+  }
+  vertices = edgesPerVertex.size();
+  faces = edges - vertices + 2;
+
+  std::map<size_t, size_t> edgesPerVertexOccurences;
+  for (const auto& vertex : edgesPerVertex) {
+    edgesPerVertexOccurences[vertex.second]++;
+  }
+
+  stats += "# of faces: " + std::to_string(faces) + "\n";
+  stats += "# of edges: " + std::to_string(edges) + "\n";
+  stats += "# of vertices: " + std::to_string(vertices) + "\n";
+  stats += "Edges per vertex:\n";
+  for (const auto& edgesCount : edgesPerVertexOccurences) {
+    stats += "\t" + std::to_string(edgesCount.first) + " edges: " + std::to_string(edgesCount.second) + " occurences\n";
+  }
+
+  return stats;
+}
+
+// plane [normal, base] of the frustrum in camera coordinates
+struct ReferencePlane {
+  Vector3d base, normal;
+
+  // > 0 on the side of the normal
+  double distance(const Vector3d& v) const {
+    return v * normal + (-(normal * base)) / normal.norm();
+  }
+
+  // cuts s at the plane, keeping the side of the normal, returns true if s is entirely on the other side
+  bool clip(Segment3d& s) const {
+    const double da = distance(s.a);
+    const double db = distance(s.b);
+
+    if (da < 0 && db < 0) {
+      return true;
+    }
+    else if (da > 0 && db < 0) {
+      double f = da / (da - db);
+      const sf::Color& ca = s.a.get_color();
+      const sf::Color& cb = s.b.get_color();
+      sf::Color color = sf::Color(ca.r + f * (cb.r - ca.r), ca.g + f * (cb.g - ca.g), ca.b + f * (cb.b - ca.b));
+      s.b = s.a + (s.b - s.a) * f;
+      s.b.set_color(color);
+    }
+    else if (da < 0 && db > 0) {
+      std::swap(s.a, s.b);
+      clip(s);
+    }
+
+    return false;
+  }
+};
+
+static Vector3d referenceTransform(const ReferenceCamera& camera, const Vector3d& v) {
+  double tx = camera.thetaX * M_PI / 180.0, ty = camera.thetaY * M_PI / 180.0, tz = camera.thetaZ * M_PI / 180.0;
+  double cx = cos(tx), cy = cos(ty), cz = cos(tz);
+  double sx = sin(tx), sy = sin(ty), sz = sin(tz);
+  Vector3d u = v - camera.position;
+
+  double x = u.get<0>(), y = u.get<1>(), z = u.get<2>();
+
+  return Vector3d(cy * (sz * y + cz * x) - sy * z,
+                  sx * (cy * z + sy * (sz * y + cz * x)) + cx * (cz * y - sz * x),
+                  cx * (cy * z + sy * (sz * y + cz * x)) - sx * (cz * y - sz * x), v.get_color());
+}
+
+std::vector<sf::Vertex> referenceFigure(const Solid3d& shape, const ReferenceCamera& camera) {
+  const double horizontalAngle = atan2(camera.width / 2.0, PROJECTION_FACTOR) - 0.0001;
+  const double verticalAngle = atan2(camera.height / 2.0, PROJECTION_FACTOR) - 0.0001;
+  const double ch = cos(horizontalAngle), sh = sin(horizontalAngle);
+  const double cv = cos(verticalAngle), sv = sin(verticalAngle);
+
+  const ReferencePlane frustrum[6] = {
+    {Vector3d(0, 0, 0), Vector3d(0, 0, 1)},                    // close
+    {Vector3d(0, 0, PROJECTION_MAX_DEPTH), Vector3d(0, 0, -1)}, // far
+    {Vector3d(0, 0, 0), Vector3d(ch, 0, sh)},                  // left
+    {Vector3d(0, 0, 0), Vector3d(-ch, 0, sh)},                 // right
+    {Vector3d(0, 0, 0), Vector3d(0, cv, sv)},                  // top
+    {Vector3d(0, 0, 0), Vector3d(0, -cv, sv)}                  // bottom
+  };
+
+  auto project = [&](const Vector3d& v) {
+    sf::Color color = v.get_color();
+    color.a = map(frustrum[0].distance(v), 0, PROJECTION_MAX_DEPTH, 255, 0);
+
+    return sf::Vertex(sf::Vector2f(PROJECTION_FACTOR * v.get<0>() / v.get<2>() + camera.width / 2,
+                                   PROJECTION_FACTOR * v.get<1>() / v.get<2>() + camera.height / 2), color);
+  };
+
+  std::vector<sf::Vertex> figure;
+  for (const Segment3d& edge : shape.edges) {
+    Segment3d s(referenceTransform(camera, edge.a), referenceTransform(camera, edge.b));
+
+    bool outsideFrustrum = false;
+    for (const ReferencePlane& side : frustrum) {
+      outsideFrustrum = side.clip(s);
+      if (outsideFrustrum) {
+        break;
+      }
+    }
+
+    if (!outsideFrustrum) {
+      figure.push_back(project(s.a));
+      figure.push_back(project(s.b));
+    }
+  }
+
+  return figure;
+}
@@ -0,0 +1,31 @@
+#ifndef REFERENCE_HPP
+#define REFERENCE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "geometry/solid3d.hpp"
+
+// frozen copies of the first implementations of the engine, kept as oracles for the
+// optimized paths: they only use the public arithmetic of Vector3d and never call the
+// code they check, do not optimize them
+
+// edges only rectification: midpoints grouped by vertex in a map, ordered by nearest
+// neighbour and connected, duplicated edges found by a linear search
+Solid3d referenceNextShape(const Solid3d& shape);
+
+// statistics with the face count given by Euler's formula
+std::string referenceStats(const Solid3d& shape);
+
+// camera given by its position and angles in degrees, as the Camera3d constructor
+struct ReferenceCamera {
+  Vector3d position;
+  double thetaX, thetaY, thetaZ;
+  unsigned width, height;
+};
+
+// every edge transformed by the camera, clipped by the 6 planes of its frustrum one after
+// the other and projected on the near plane, 2 vertices per visible edge in edge order
+std::vector<sf::Vertex> referenceFigure(const Solid3d& shape, const ReferenceCamera& camera);
+
+#endif